@@ -2,8 +2,10 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
 
 #include <ghc/fs_std.hpp> // filesystem
@@ -17,6 +19,7 @@
 #include <io/write_gltf.hpp>
 #include <io/write_obj.hpp>
 #include <physics/rigid_body_problem.hpp>
+#include <problems/barrier_problem.hpp>
 #include <problems/problem_factory.hpp>
 #include <utils/get_rss.hpp>
 #include <utils/regular_2d_grid.hpp>
@@ -34,6 +37,10 @@ SimState::SimState()
     , m_num_simulation_steps(0)
     , m_max_simulation_steps(-1)
     , m_checkpoint_frequency(100)
+    , m_stream_states(false)
+    , m_write_trajectory(false)
+    , m_trajectory_single_precision(false)
+    , m_animation_in_trajectory(false)
     , m_dirty_constraints(false)
 {
     initial_rss = getCurrentRSS();
@@ -60,6 +67,15 @@ bool SimState::load_scene(const std::string& filename, const std::string& patch)
         // scene = ...
         spdlog::error("MuJoCo file format not supported yet", ext);
         return false;
+    } else if (ext == ".traj") {
+        scene_file = filename;
+        return load_trajectory(filename);
+    } else if (ext == ".ckpt") {
+        scene_file = filename;
+        return load_checkpoint(filename);
+    } else if (ext == ".jsonl") {
+        scene_file = filename;
+        return load_state_stream(filename);
     } else if (ext == ".json") {
         std::ifstream input(filename);
         if (input.good()) {
@@ -114,9 +130,186 @@ bool SimState::load_simulation(const nlohmann::json& input_args)
     }
     m_num_simulation_steps = int(state_sequence.size()) - 1;
     problem_ptr->state(state_sequence.back());
+    record_animation(state_sequence);
     return true;
 }
 
+bool SimState::load_state_stream(const std::string& filename)
+{
+    StateStreamReader reader;
+    if (!reader.open(filename) || !init(reader.args())) {
+        return false;
+    }
+
+    state_sequence.clear();
+    nlohmann::json state;
+    while (reader.next(state)) {
+        state_sequence.push_back(std::move(state));
+    }
+    if (state_sequence.empty()) {
+        spdlog::error("State stream has no states: {}", filename);
+        return false;
+    }
+    spdlog::info(
+        "Recovered {:d} states from {}", state_sequence.size(), filename);
+    m_num_simulation_steps = int(state_sequence.size()) - 1;
+    problem_ptr->state(state_sequence.back());
+    record_animation(state_sequence);
+    return true;
+}
+
+bool SimState::load_trajectory(const std::string& filename)
+{
+    auto reader = std::make_shared<TrajectoryReader>();
+    if (!reader->open(filename)) {
+        return false;
+    }
+    if (!reader->metadata().contains("args") || reader->num_frames() == 0) {
+        spdlog::error("Trajectory has no arguments or frames: {}", filename);
+        return false;
+    }
+    if (!init(reader->metadata()["args"])) {
+        return false;
+    }
+    if (reader->num_bodies() != problem_ptr->num_bodies()
+        || reader->dim() != problem_ptr->dim()) {
+        spdlog::error("Trajectory does not match its scene: {}", filename);
+        return false;
+    }
+
+    trajectory = reader;
+    m_num_simulation_steps = int(trajectory->num_frames()) - 1;
+    set_trajectory_frame(trajectory->num_frames() - 1);
+    state_sequence.assign(1, problem_ptr->state());
+    // The animation is read from the trajectory
+    animation.clear();
+    return true;
+}
+
+void SimState::set_trajectory_frame(size_t frame)
+{
+    assert(trajectory != nullptr);
+    std::shared_ptr<RigidBodyProblem> rbp =
+        std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+    rbp->m_assembler.set_rb_poses(trajectory->poses(frame));
+    PosesD velocities = trajectory->velocities(frame);
+    for (size_t i = 0; i < velocities.size(); i++) {
+        rbp->m_assembler[i].velocity = velocities[i];
+    }
+}
+
+void SimState::write_trajectory_frame()
+{
+    std::shared_ptr<RigidBodyProblem> rbp =
+        std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+    const RigidBodyAssembler& bodies = rbp->m_assembler;
+    PosesD velocities(bodies.num_bodies());
+    for (size_t i = 0; i < velocities.size(); i++) {
+        velocities[i] = bodies[i].velocity;
+    }
+    const double time = m_num_simulation_steps * problem_ptr->timestep();
+    io_writer.push([this, time, poses = bodies.rb_poses_t1(),
+                    velocities = std::move(velocities)]() {
+        return trajectory_writer.write_frame(time, poses, velocities);
+    });
+}
+
+void SimState::detach_trajectory()
+{
+    if (trajectory == nullptr) {
+        return;
+    }
+    // The last frame is set last, so the bodies are left in their state.
+    std::vector<nlohmann::json> states;
+    states.reserve(trajectory->num_frames());
+    animation.clear();
+    for (size_t i = 0; i < trajectory->num_frames(); i++) {
+        set_trajectory_frame(i);
+        states.push_back(problem_ptr->state());
+        record_animation_frame();
+    }
+    state_sequence = std::move(states);
+    trajectory = nullptr;
+}
+
+bool SimState::load_checkpoint(const std::string& filename)
+{
+    Checkpoint checkpoint;
+    if (!read_checkpoint(filename, checkpoint) || !init(checkpoint.args)) {
+        return false;
+    }
+    std::shared_ptr<RigidBodyProblem> rbp =
+        std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+    if (checkpoint.bodies.size() != rbp->num_bodies()
+        || checkpoint.dim != rbp->dim()) {
+        spdlog::error("Checkpoint does not match its scene: {}", filename);
+        return false;
+    }
+
+    for (size_t i = 0; i < checkpoint.bodies.size(); i++) {
+        const RigidBodyCheckpoint& body = checkpoint.bodies[i];
+        RigidBody& rb = rbp->m_assembler[i];
+        rb.type = RigidBodyType(body.type);
+        rb.is_dof_fixed = body.is_dof_fixed;
+        rb.pose = body.pose;
+        rb.pose_prev = body.pose_prev;
+        rb.velocity = body.velocity;
+        rb.velocity_prev = body.velocity_prev;
+        rb.acceleration = body.acceleration;
+        rb.force = body.force;
+        rb.Qdot = body.Qdot;
+        rb.Qddot = body.Qddot;
+        rb.kinematic_max_time = body.kinematic_max_time;
+        rb.kinematic_poses = body.kinematic_poses;
+    }
+    // κ of the last step is used to build the friction constraints
+    std::shared_ptr<BarrierProblem> barrier_problem =
+        std::dynamic_pointer_cast<BarrierProblem>(problem_ptr);
+    if (barrier_problem != nullptr
+        && std::isfinite(checkpoint.barrier_stiffness)) {
+        barrier_problem->barrier_stiffness(checkpoint.barrier_stiffness);
+    }
+
+    m_num_simulation_steps = int(checkpoint.num_steps);
+    // Only take the remaining time-steps of the original run
+    if (m_max_simulation_steps >= 0) {
+        m_max_simulation_steps =
+            std::max(m_max_simulation_steps - m_num_simulation_steps, 0);
+    }
+    state_sequence.assign(1, problem_ptr->state());
+    animation.clear();
+    record_animation_frame();
+    spdlog::info(
+        "Continuing from time-step {:d} of {}", m_num_simulation_steps,
+        filename);
+    return true;
+}
+
+Checkpoint SimState::checkpoint() const
+{
+    std::shared_ptr<RigidBodyProblem> rbp =
+        std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+    std::shared_ptr<BarrierProblem> barrier_problem =
+        std::dynamic_pointer_cast<BarrierProblem>(problem_ptr);
+
+    Checkpoint checkpoint;
+    checkpoint.args = args;
+    checkpoint.dim = rbp->dim();
+    checkpoint.num_steps = m_num_simulation_steps;
+    checkpoint.timestep = problem_ptr->timestep();
+    checkpoint.barrier_stiffness = barrier_problem != nullptr
+        ? barrier_problem->barrier_stiffness()
+        : std::numeric_limits<double>::quiet_NaN();
+    checkpoint.bodies.reserve(rbp->num_bodies());
+    for (const RigidBody& rb : rbp->m_assembler.m_rbs) {
+        checkpoint.bodies.push_back(
+            { int(rb.type), rb.is_dof_fixed, rb.pose, rb.pose_prev,
+              rb.velocity, rb.velocity_prev, rb.acceleration, rb.force,
+              rb.Qdot, rb.Qddot, rb.kinematic_max_time, rb.kinematic_poses });
+    }
+    return checkpoint;
+}
+
 bool SimState::init(const nlohmann::json& args_in)
 {
     using namespace nlohmann;
@@ -135,7 +328,8 @@ bool SimState::init(const nlohmann::json& args_in)
             "gravity": [0.0, 0.0, 0.0],
             "collision_eps": 0.0,
             "time_stepper": "default",
-            "do_intersection_check": false
+            "do_intersection_check": false,
+            "warm_start": false
         },
         "homotopy_solver": {
             "inner_solver": "DEPRECATED",
@@ -152,6 +346,11 @@ bool SimState::init(const nlohmann::json& args_in)
             "velocity_conv_tol": null,
             "is_velocity_conv_tol_abs": false,
             "line_search_lower_bound": null,
+            "speculative_line_search_steps": 1,
+            "linear_solver_method": "direct",
+            "linear_solver_ordering": "default",
+            "separate_decoupled_blocks": false,
+            "cg_max_iterations": 1000,
             "linear_solver": {
                 "name": "Eigen::SimplicialLDLT",
                 "max_iter": 1000,
@@ -164,6 +363,10 @@ bool SimState::init(const nlohmann::json& args_in)
             "dhat_epsilon": 1e-9,
             "min_barrier_stiffness_scale": null
         },
+        "lbfgs_solver": {
+            "history_size": 8,
+            "hessian_refresh_interval": 10
+        },
         "ncp_solver": {
             "max_iterations": 1000,
             "do_line_search": false,
@@ -209,6 +412,10 @@ bool SimState::init(const nlohmann::json& args_in)
     json newton_settings = args["newton_solver"];    // make a copy of newton
     newton_settings.merge_patch(args["ipc_solver"]); // apply ipc to newton
     args["ipc_solver"] = newton_settings; // set ipc to updated newton
+    // Share the IPC solver settings with L-BFGS
+    json ipc_settings = args["ipc_solver"];
+    ipc_settings.merge_patch(args["lbfgs_solver"]);
+    args["lbfgs_solver"] = ipc_settings;
 
     // check that incomming json doesn't have any unkown keys to avoid stupid
     // bugs
@@ -232,6 +439,10 @@ bool SimState::init(const nlohmann::json& args_in)
     newton_settings = args["newton_solver"];         // make a copy of newton
     newton_settings.merge_patch(args["ipc_solver"]); // apply ipc to newton
     args["ipc_solver"] = newton_settings; // set ipc to updated newton
+    // Share the IPC solver settings with L-BFGS
+    ipc_settings = args["ipc_solver"];
+    ipc_settings.merge_patch(args["lbfgs_solver"]);
+    args["lbfgs_solver"] = ipc_settings;
 
     auto problem_name = args["scene_type"].get<std::string>();
     auto tmp_problem_ptr = ProblemFactory::factory().get_problem(problem_name);
@@ -256,9 +467,13 @@ bool SimState::init(const nlohmann::json& args_in)
 
     m_num_simulation_steps = 0;
     m_dirty_constraints = true;
+    trajectory = nullptr;
 
     state_sequence.clear();
     state_sequence.push_back(problem_ptr->state());
+    animation.clear();
+    m_animation_in_trajectory = false;
+    record_animation_frame();
     step_timings.clear();
     solver_iterations.clear();
     num_contacts.clear();
@@ -322,16 +537,56 @@ void SimState::run_simulation(const std::string& fout)
     std::string chkpt_base =
         (fout_path.parent_path() / fout_path.stem()).string();
 
-    if (m_max_simulation_steps <= 0) {
+    // A negative maximum means the scene does not set one
+    if (m_max_simulation_steps < 0) {
         m_max_simulation_steps = 1000;
     }
 
+    // Simulating from a trajectory continues from its last frame
+    detach_trajectory();
+
     spdlog::info("Starting simulation {}", scene_file);
     spdlog::info("Running {} iterations", m_max_simulation_steps);
 
     igl::Timer timer;
     timer.start();
 
+    // Stream the states so only the last one is kept in memory
+    if (m_stream_states) {
+        fs::path stream_path = fout_path;
+        stream_path.replace_extension(".jsonl");
+        if (state_stream.open(stream_path.string(), args)) {
+            for (const nlohmann::json& state : state_sequence) {
+                state_stream.write(state);
+            }
+            state_sequence.erase(
+                state_sequence.begin(), state_sequence.end() - 1);
+            spdlog::info("Streaming states to {}", stream_path.string());
+        }
+    }
+
+    // The frames of a streamed run are not kept in memory, so the glTF
+    // export reads them back from a (float32 and pose only) trajectory.
+    const bool is_animation_streamed =
+        m_stream_states && problem_ptr->dim() == 3;
+    if (m_write_trajectory || is_animation_streamed) {
+        fs::path trajectory_path = fout_path;
+        trajectory_path.replace_extension(".traj");
+        if (trajectory_writer.open(
+                trajectory_path.string(), problem_ptr->dim(),
+                problem_ptr->num_bodies(), problem_ptr->timestep(),
+                { { "args", args } },
+                m_trajectory_single_precision || !m_write_trajectory,
+                /*write_velocities=*/m_write_trajectory)) {
+            write_trajectory_frame();
+            m_animation_in_trajectory = problem_ptr->dim() == 3;
+            if (m_write_trajectory) {
+                spdlog::info(
+                    "Writing trajectory to {}", trajectory_path.string());
+            }
+        }
+    }
+
     m_solve_collisions = true;
     print_progress_bar(0, m_max_simulation_steps, 0);
     for (int i = 0; i < m_max_simulation_steps; ++i) {
@@ -348,12 +603,15 @@ void SimState::run_simulation(const std::string& fout)
             "Finished it={} sim_step={}", i + 1, m_num_simulation_steps);
 
         // Checkpoint the simulation every m_checkpoint_frequency time-steps
-        if ((i + 1) % m_checkpoint_frequency == 0
+        // (written in the background while the simulation continues).
+        if (m_num_simulation_steps % m_checkpoint_frequency == 0
             && (i + 1) < m_max_simulation_steps) {
             std::string chkpt_fout = fmt::format(
-                "{}-chkpt{:05d}.json", chkpt_base, m_num_simulation_steps);
-            save_simulation(chkpt_fout);
-            spdlog::info("Simulation checkpoint saved to {}", chkpt_fout);
+                "{}-chkpt{:05d}.ckpt", chkpt_base, m_num_simulation_steps);
+            io_writer.push([chkpt_fout, snapshot = checkpoint()]() {
+                return write_checkpoint(chkpt_fout, snapshot);
+            });
+            spdlog::info("Writing simulation checkpoint to {}", chkpt_fout);
         }
         print_progress_bar(
             i + 1, m_max_simulation_steps, timer.getElapsedTime());
@@ -365,12 +623,57 @@ void SimState::run_simulation(const std::string& fout)
         timer.getElapsedTime(),
         m_max_simulation_steps / timer.getElapsedTime());
 
-    save_simulation(fout);
-    spdlog::info("Simulation results saved to {}", fout);
+    // Encode the animation in the background while the results are saved
     fs::path gltf_filename(fout);
     gltf_filename.replace_extension(".glb");
-    save_gltf(gltf_filename.string());
-    spdlog::info("Animation saved to {}", gltf_filename.string());
+    if (problem_ptr->dim() == 3) {
+        if (m_animation_in_trajectory) {
+            // Finish the trajectory before reading the frames back
+            io_writer.push([this]() { return trajectory_writer.close(); });
+        }
+        io_writer.push([this, filename = gltf_filename.string()]() {
+            if (!save_gltf(filename)) {
+                return false;
+            }
+            spdlog::info("Animation saved to {}", filename);
+            return true;
+        });
+    }
+    bool saved = save_simulation(fout);
+    spdlog::info("Simulation results saved to {}", fout);
+    // Finish the exports, trajectory frames, and checkpoints
+    if (!io_writer.wait()) {
+        spdlog::error("Unable to write every output of the simulation");
+    }
+    trajectory_writer.close();
+
+    if (m_animation_in_trajectory) {
+        m_animation_in_trajectory = false;
+        if (state_stream.is_open()) {
+            // Only the last state is kept after streaming
+            animation.clear();
+            record_animation_frame();
+        } else {
+            // Keep the animation of the states in memory
+            TrajectoryReader reader;
+            if (reader.open(trajectory_writer.filename())) {
+                for (size_t i = 1; i < reader.num_frames(); i++) {
+                    animation.push_back(reader.poses(i));
+                }
+            }
+        }
+        if (!m_write_trajectory) {
+            fs::remove(trajectory_writer.filename());
+        }
+    }
+
+    if (state_stream.is_open()) {
+        // The results hold every state, so the stream is no longer needed.
+        state_stream.close();
+        if (saved) {
+            fs::remove(state_stream.filename());
+        }
+    }
 
     PROFILE_END();
     LOG_PROFILER(scene_file);
@@ -378,6 +681,7 @@ void SimState::run_simulation(const std::string& fout)
 
 void SimState::simulation_step()
 {
+    detach_trajectory();
     m_num_simulation_steps += 1;
     m_step_has_collision = false;
     m_step_has_intersections = false;
@@ -415,7 +719,21 @@ void SimState::save_simulation_step()
     PROFILE_POINT("SimState::save_simulation_step");
     PROFILE_START();
 
-    state_sequence.push_back(problem_ptr->state());
+    if (state_stream.is_open()) {
+        state_sequence.back() = problem_ptr->state();
+        last_state_write =
+            io_writer.push([this, state = state_sequence.back()]() {
+                return state_stream.write(state);
+            });
+    } else {
+        state_sequence.push_back(problem_ptr->state());
+    }
+    if (trajectory_writer.is_open()) {
+        write_trajectory_frame();
+    }
+    if (!m_animation_in_trajectory) {
+        record_animation_frame();
+    }
     step_timings.push_back(step_timer.getElapsedTime());
     solver_iterations.push_back(problem_ptr->opt_result.num_iterations);
     num_contacts.push_back(problem_ptr->num_contacts());
@@ -429,11 +747,6 @@ bool SimState::save_simulation(const std::string& filename)
     PROFILE_POINT("SimState::save_simulation");
     PROFILE_START();
 
-    nlohmann::json results;
-    results["args"] = args;
-    results["animation"] = nlohmann::json();
-    results["animation"]["state_sequence"] = state_sequence;
-
     nlohmann::json stats;
     stats["dim"] = problem_ptr->dim();
     stats["num_bodies"] = problem_ptr->num_bodies();
@@ -447,7 +760,6 @@ bool SimState::save_simulation(const std::string& filename)
     stats["num_contacts"] = num_contacts;
     stats["step_minimum_distances"] = step_minimum_distances;
     stats["solve_stats"] = problem_ptr->solver().stats();
-    results["stats"] = stats;
 
     std::ofstream file(filename);
     if (!file) {
@@ -455,10 +767,56 @@ bool SimState::save_simulation(const std::string& filename)
         return false;
     }
 
-    file << results.dump();
+    // Write the states one at a time instead of copying them all into a
+    // results object (same output as dumping {animation, args, stats}).
+    file << R"({"animation":{"state_sequence":[)";
+    bool is_first_state = true;
+    bool success = for_each_state([&](const nlohmann::json& state) {
+        if (!is_first_state) {
+            file << ',';
+        }
+        file << state.dump();
+        is_first_state = false;
+    });
+    file << R"(]},"args":)" << args.dump() << R"(,"stats":)" << stats.dump()
+         << '}';
 
     PROFILE_END();
-    return true;
+    return success && bool(file);
+}
+
+bool SimState::for_each_state(
+    const std::function<void(const nlohmann::json&)>& visit)
+{
+    if (trajectory != nullptr) {
+        for (size_t i = 0; i < trajectory->num_frames(); i++) {
+            set_trajectory_frame(i);
+            visit(problem_ptr->state());
+        }
+        problem_ptr->state(state_sequence.back());
+        return true;
+    }
+
+    if (!state_stream.is_open()) {
+        for (const nlohmann::json& state : state_sequence) {
+            visit(state);
+        }
+        return true;
+    }
+
+    // Finish writing the states before reading them back
+    bool success = io_writer.wait_for(last_state_write);
+    StateStreamReader reader;
+    if (!reader.open(state_stream.filename())) {
+        return false;
+    }
+    nlohmann::json state;
+    size_t num_states = 0;
+    while (reader.next(state)) {
+        visit(state);
+        num_states++;
+    }
+    return success && num_states == state_stream.num_states();
 }
 
 bool SimState::save_obj_sequence(const std::string& dir_name)
@@ -467,42 +825,117 @@ bool SimState::save_obj_sequence(const std::string& dir_name)
     fs::path dir_path(dir_name);
     fs::create_directories(dir_path);
 
+    // Only compute the vertices of each state here and format the files in
+    // the background while the next state is set.
+    int i = 0;
+    const auto write_state = [&]() {
+        std::vector<Eigen::MatrixXd> body_vertices(problem_ptr->num_bodies());
+        for (size_t j = 0; j < body_vertices.size(); j++) {
+            body_vertices[j] = problem_ptr->vertices(j);
+        }
+        io_writer.push([this,
+                        filename =
+                            (dir_path / fmt::format("{:05d}.obj", i++))
+                                .string(),
+                        body_vertices = std::move(body_vertices)]() {
+            return write_obj(filename, *problem_ptr, body_vertices, false);
+        });
+    };
+
     bool success = true;
-    for (int i = 0; i < state_sequence.size(); i++) {
-        const auto& state = state_sequence[i];
-        problem_ptr->state(state);
-        write_obj(
-            (dir_path / fmt::format("{:05d}.obj", i)).string(), *problem_ptr,
-            false);
+    if (trajectory != nullptr) {
+        // Set the poses directly instead of through JSON states
+        for (size_t frame = 0; frame < trajectory->num_frames(); frame++) {
+            set_trajectory_frame(frame);
+            write_state();
+        }
+    } else {
+        success = for_each_state([&](const nlohmann::json& state) {
+            problem_ptr->state(state);
+            write_state();
+        });
     }
+    success &= io_writer.wait();
 
     problem_ptr->state(state_sequence.back());
 
     return success;
 }
 
-bool SimState::save_gltf(const std::string& filename)
+void SimState::record_animation_frame()
 {
-    std::vector<PosesD> poses(state_sequence.size());
+    // glTF animations are only exported for 3D scenes
+    if (problem_ptr->dim() == 3) {
+        std::shared_ptr<RigidBodyProblem> rbp =
+            std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+        animation.push_back(rbp->m_assembler.rb_poses_t1());
+    }
+}
 
-    bool success = true;
-    for (int i = 0; i < state_sequence.size(); i++) {
-        const auto& state = state_sequence[i];
-        std::vector<nlohmann::json> jrbs = state["rigid_bodies"];
-        for (int j = 0; j < jrbs.size(); j++) {
-            VectorMax3d position;
-            VectorMax3d rotation;
-            from_json(jrbs[j]["position"], position);
-            from_json(jrbs[j]["rotation"], rotation);
-            poses[i].emplace_back(position, rotation);
+void SimState::record_animation(const std::vector<nlohmann::json>& states)
+{
+    animation.clear();
+    if (problem_ptr->dim() != 3) {
+        return;
+    }
+    for (const nlohmann::json& state : states) {
+        const nlohmann::json& jrbs = state["rigid_bodies"];
+        PosesD poses;
+        poses.reserve(jrbs.size());
+        for (const nlohmann::json& jrb : jrbs) {
+            VectorMax3d position, rotation;
+            from_json(jrb["position"], position);
+            from_json(jrb["rotation"], rotation);
+            poses.emplace_back(position, rotation);
         }
+        animation.push_back(poses);
     }
+}
 
+bool SimState::save_gltf(const std::string& filename)
+{
+    // glTF animations are only exported for 3D scenes
+    if (problem_ptr->dim() != 3) {
+        spdlog::error("No 3D animation to save to {}", filename);
+        return false;
+    }
     std::shared_ptr<RigidBodyProblem> rbp =
         std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+    const RigidBodyAssembler& bodies = rbp->m_assembler;
+    const double timestep = problem_ptr->timestep();
+
+    if (trajectory != nullptr) {
+        return write_gltf(
+            filename, bodies, trajectory->num_frames(),
+            [this](size_t frame, size_t body, float* transform) {
+                gltf_transform(trajectory->pose(frame, body), transform);
+            },
+            timestep);
+    }
+
+    if (!m_animation_in_trajectory) {
+        return write_gltf(filename, bodies, animation, timestep);
+    }
 
+    // The frames of the run follow the ones recorded before it (the first
+    // frame of the trajectory is the last recorded one).
+    TrajectoryReader reader;
+    if (!reader.open(trajectory_writer.filename())) {
+        return false;
+    }
+    const size_t num_recorded =
+        animation.num_frames() > 0 ? animation.num_frames() - 1 : 0;
     return write_gltf(
-        filename, rbp->m_assembler, poses, problem_ptr->timestep());
+        filename, bodies, num_recorded + reader.num_frames(),
+        [&](size_t frame, size_t body, float* transform) {
+            if (frame < num_recorded) {
+                std::copy_n(animation.transform(frame, body), 7, transform);
+            } else {
+                gltf_transform(
+                    reader.pose(frame - num_recorded, body), transform);
+            }
+        },
+        timestep);
 }
 
 } // namespace ipc::rigid
@@ -3,8 +3,14 @@
 #include <igl/Timer.h>
 #include <nlohmann/json.hpp>
 
+#include <functional>
 #include <memory> // shared_ptr
 
+#include <io/async_writer.hpp>
+#include <io/checkpoint.hpp>
+#include <io/state_stream.hpp>
+#include <io/trajectory.hpp>
+#include <io/write_gltf.hpp>
 #include <physics/simulation_problem.hpp>
 #include <solvers/optimization_solver.hpp>
 
@@ -17,6 +23,12 @@ public:
     bool load_scene(const std::string& filename, const std::string& patch = "");
     bool reload_scene();
     bool load_simulation(const nlohmann::json& args);
+    /// Load the states of a (possibly crashed) run from its state stream.
+    bool load_state_stream(const std::string& filename);
+    /// Load the frames of a binary trajectory (e.g., for post-processing).
+    bool load_trajectory(const std::string& filename);
+    /// Continue a simulation from a binary checkpoint.
+    bool load_checkpoint(const std::string& filename);
     bool init(const nlohmann::json& args);
 
     void simulation_step();
@@ -42,6 +54,13 @@ public:
     int m_num_simulation_steps; ///< counts simulation steps
     int m_max_simulation_steps; ///< maximum number of time-steps to take
     int m_checkpoint_frequency; ///< time-steps between checkpoints
+    /// Write the states to disk as they are computed in run_simulation()
+    /// instead of keeping them in memory (only the last state is kept).
+    bool m_stream_states;
+    /// Write a binary trajectory of the poses and velocities in
+    /// run_simulation() (float32 if m_trajectory_single_precision).
+    bool m_write_trajectory;
+    bool m_trajectory_single_precision;
 
     std::string scene_file;
 
@@ -54,6 +73,42 @@ public:
     std::vector<double> step_minimum_distances;
 
 protected:
+    /// Visit the saved states in order (from the stream if streaming).
+    bool for_each_state(
+        const std::function<void(const nlohmann::json&)>& visit);
+
+    /// Set the poses and velocities of the bodies to a trajectory frame.
+    void set_trajectory_frame(size_t frame);
+    /// Append the current poses and velocities to the trajectory.
+    void write_trajectory_frame();
+    /// Replace the loaded trajectory with its states, so the new time-steps
+    /// are saved after its frames.
+    void detach_trajectory();
+
+    /// Record the current poses in the animation (3D scenes only).
+    void record_animation_frame();
+    /// Record the poses of saved states in the animation.
+    void record_animation(const std::vector<nlohmann::json>& states);
+
+    /// Snapshot the state needed to continue the simulation.
+    Checkpoint checkpoint() const;
+
+    StateStreamWriter state_stream;
+    TrajectoryWriter trajectory_writer;
+    /// Writes the states, trajectory frames, checkpoints, and exports off the
+    /// simulation thread (the streams are only written through it).
+    AsyncWriter io_writer;
+    /// Task of the last state written to the stream
+    size_t last_state_write = 0;
+    /// Loaded trajectory the states are read from (nullptr if none)
+    std::shared_ptr<TrajectoryReader> trajectory;
+    /// glTF transforms of the frames (up to the start of the run if
+    /// m_animation_in_trajectory)
+    GltfAnimation animation;
+    /// Are the frames of the run read back from its trajectory instead of
+    /// being recorded in memory?
+    bool m_animation_in_trajectory;
+
     igl::Timer step_timer;
     size_t initial_rss;
 
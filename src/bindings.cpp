@@ -123,12 +123,12 @@ PYBIND11_MODULE(_RigidIPC, m)
         .def_readwrite("name", &RigidBody::name)
         .def_readwrite("group_id", &RigidBody::group_id)
         .def_readwrite("type", &RigidBody::type)
-        .def_readonly("vertices", &RigidBody::vertices)
+        .def_property_readonly("vertices", &RigidBody::vertices)
         .def(
             "world_vertices",
             [](const RigidBody& self) { return self.world_vertices(); })
-        .def_readonly("edges", &RigidBody::edges)
-        .def_readonly("faces", &RigidBody::faces)
+        .def_property_readonly("edges", &RigidBody::edges)
+        .def_property_readonly("faces", &RigidBody::faces)
         .def_readwrite("pose", &RigidBody::pose)
         .def_readwrite("kinematic_poses", &RigidBody::kinematic_poses);
 
@@ -1,10 +1,10 @@
 #include "ccd.hpp"
 
-#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
 
-#include <tbb/parallel_for.h>
 #include <tbb/parallel_for_each.h>
-#include <tbb/parallel_invoke.h>
 
 #include <ipc/ccd/ccd.hpp>
 #include <ipc/friction/closest_point.hpp>
@@ -14,6 +14,7 @@
 #include <ccd/piecewise_linear/time_of_impact.hpp>
 #include <ccd/redon/time_of_impact.hpp>
 #include <ccd/rigid/broad_phase.hpp>
+#include <ccd/rigid/rigid_body_separation.hpp>
 #include <ccd/rigid/time_of_impact.hpp>
 
 // #define SAVE_CCD_QUERIES
@@ -21,6 +22,7 @@
 #include <ccd/save_queries.hpp>
 #endif
 
+#include <logger.hpp>
 #include <profiler.hpp>
 
 namespace ipc::rigid {
@@ -94,108 +96,163 @@ void detect_collisions_from_candidates(
     Impacts& impacts,
     TrajectoryType trajectory)
 {
-    PROFILE_POINT("collisions_detection__narrow_phase");
-    PROFILE_START();
+    NAMED_PROFILE_POINT("collisions_detection__narrow_phase", NARROW_PHASE);
+    PROFILE_START(NARROW_PHASE);
 
-    std::mutex ev_impacts_mutex, ee_impacts_mutex, fv_impacts_mutex;
+    std::atomic<size_t> filtered_count(0);
+    std::atomic<size_t> collision_count(0);
 
-    auto ev_impact = [&](const EdgeVertexCandidate& ev_candidate) {
-        double toi;
-        bool is_colliding = edge_vertex_ccd(
-            bodies, poses_t0, poses_t1, ev_candidate, toi, trajectory);
-        if (is_colliding) {
+    std::vector<BodyPairCandidates> body_pairs;
+    group_candidates_by_body_pair(bodies, candidates, body_pairs);
+
+    // Collect the impacts in thread local storage and merge them afterwards
+    ThreadSpecificImpacts storages;
+
+    const auto on_impact = [&](int collision_type, size_t ci, double toi) {
+        collision_count++;
+        Impacts& local_impacts = storages.local();
+        switch (collision_type) {
+        case CollisionType::EDGE_VERTEX: {
+            const EdgeVertexCandidate& ev_candidate =
+                candidates.ev_candidates[ci];
             double alpha = edge_vertex_closest_point(
                 bodies, poses_t0, poses_t1, ev_candidate, toi, trajectory);
-            std::scoped_lock lock(ev_impacts_mutex);
-            impacts.ev_impacts.emplace_back(
+            local_impacts.ev_impacts.emplace_back(
                 toi, ev_candidate.edge_index, alpha, ev_candidate.vertex_index);
+            break;
         }
-    };
-
-    auto ee_impact = [&](const EdgeEdgeCandidate& ee_candidate) {
-        double toi;
-        bool is_colliding = edge_edge_ccd(
-            bodies, poses_t0, poses_t1, ee_candidate, toi, trajectory);
-        if (is_colliding) {
+        case CollisionType::EDGE_EDGE: {
+            const EdgeEdgeCandidate& ee_candidate =
+                candidates.ee_candidates[ci];
             double alpha, beta;
             edge_edge_closest_point(
                 bodies, poses_t0, poses_t1, ee_candidate, toi, alpha, beta,
                 trajectory);
-            std::scoped_lock lock(ee_impacts_mutex);
-            impacts.ee_impacts.emplace_back(
+            local_impacts.ee_impacts.emplace_back(
                 toi, ee_candidate.edge0_index, alpha, ee_candidate.edge1_index,
                 beta);
+            break;
         }
-    };
-
-    auto fv_impact = [&](const FaceVertexCandidate& fv_candidate) {
-        double toi;
-        bool is_colliding = face_vertex_ccd(
-            bodies, poses_t0, poses_t1, fv_candidate, toi, trajectory);
-        if (is_colliding) {
+        case CollisionType::FACE_VERTEX: {
+            const FaceVertexCandidate& fv_candidate =
+                candidates.fv_candidates[ci];
             double u, v;
             face_vertex_closest_point(
                 bodies, poses_t0, poses_t1, fv_candidate, toi, u, v,
                 trajectory);
-            std::scoped_lock lock(fv_impacts_mutex);
-            impacts.fv_impacts.emplace_back(
+            local_impacts.fv_impacts.emplace_back(
                 toi, fv_candidate.face_index, u, v, fv_candidate.vertex_index);
+            break;
+        }
         }
     };
 
-    impacts.clear();
-    tbb::parallel_invoke(
-        [&] { tbb::parallel_for_each(candidates.ev_candidates, ev_impact); },
-        [&] { tbb::parallel_for_each(candidates.ee_candidates, ee_impact); },
-        [&] { tbb::parallel_for_each(candidates.fv_candidates, fv_impact); });
+    // Process all candidates of a body pair as a single task
+    const double earliest_toi = 1;
+    tbb::parallel_for_each(
+        body_pairs, [&](const BodyPairCandidates& body_pair) {
+            filtered_count += detect_body_pair_collisions(
+                bodies, poses_t0, poses_t1, candidates, body_pair, trajectory,
+                on_impact, earliest_toi);
+        });
+
+    merge_local_impacts(storages, impacts);
+
+    double percent_correct = candidates.size() == 0
+        ? 100
+        : (double(collision_count) / candidates.size() * 100);
+    PROFILE_MESSAGE(
+        NARROW_PHASE, "num_candidates,num_filtered,num_collisions,percentage",
+        fmt::format(
+            "{:d},{:d},{:d},{:g}%", candidates.size(), filtered_count.load(),
+            collision_count.load(), percent_correct));
+
+    PROFILE_END(NARROW_PHASE);
+}
 
-    PROFILE_END();
+///////////////////////////////////////////////////////////////////////////////
+// Linear trajectories of world vertices
+
+static bool linear_edge_vertex_ccd(
+    const Eigen::Vector2d& v_t0,
+    const Eigen::Vector2d& e0_t0,
+    const Eigen::Vector2d& e1_t0,
+    const Eigen::Vector2d& v_t1,
+    const Eigen::Vector2d& e0_t1,
+    const Eigen::Vector2d& e1_t1,
+    double& toi)
+{
+    // Expects the arguments as position and displacements
+    return compute_edge_vertex_time_of_impact(
+        e0_t0, e1_t0, v_t0, (e0_t1 - e0_t0).eval(), (e1_t1 - e1_t0).eval(),
+        (v_t1 - v_t0).eval(), toi);
 }
 
-// Determine if a single edge-vertext pair intersects.
-bool edge_vertex_ccd(
-    const RigidBodyAssembler& bodies,
-    const PosesD& poses_t0,
-    const PosesD& poses_t1,
-    const EdgeVertexCandidate& candidate,
+static bool linear_edge_edge_ccd(
+    const Eigen::Vector3d& ea0_t0,
+    const Eigen::Vector3d& ea1_t0,
+    const Eigen::Vector3d& eb0_t0,
+    const Eigen::Vector3d& eb1_t0,
+    const Eigen::Vector3d& ea0_t1,
+    const Eigen::Vector3d& ea1_t1,
+    const Eigen::Vector3d& eb0_t1,
+    const Eigen::Vector3d& eb1_t1,
+    double& toi)
+{
+    // TODO: Check if edges are parallel
+    bool result = ipc::edge_edge_ccd(
+        ea0_t0, ea1_t0, eb0_t0, eb1_t0, ea0_t1, ea1_t1, eb0_t1, eb1_t1, toi,
+        /*conservative_rescaling=*/0.8);
+    assert(!result || toi > 0);
+    return result;
+}
+
+static bool linear_face_vertex_ccd(
+    const Eigen::Vector3d& v_t0,
+    const Eigen::Vector3d& f0_t0,
+    const Eigen::Vector3d& f1_t0,
+    const Eigen::Vector3d& f2_t0,
+    const Eigen::Vector3d& v_t1,
+    const Eigen::Vector3d& f0_t1,
+    const Eigen::Vector3d& f1_t1,
+    const Eigen::Vector3d& f2_t1,
+    double& toi)
+{
+    bool result = ipc::point_triangle_ccd(
+        v_t0, f0_t0, f1_t0, f2_t0, v_t1, f0_t1, f1_t1, f2_t1, toi,
+        /*conservative_rescaling=*/0.8);
+    assert(!result || toi > 0);
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CCD of body-local primitives
+
+static bool edge_vertex_ccd(
+    const RigidBody& bodyA, // Body of the vertex
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long vertex_id,
+    const RigidBody& bodyB, // Body of the edge
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long edge_id,
     double& toi,
     TrajectoryType trajectory,
     double earliest_toi,
     double minimum_separation_distance)
 {
-    assert(bodies.dim() == 2);
-
-#ifdef SAVE_CCD_QUERIES
-    save_ccd_candidate(bodies, poses_t0, poses_t1, candidate);
-#endif
-
-    long bodyA_id, vertex_id, bodyB_id, edge_id;
-    bodies.global_to_local_vertex(candidate.vertex_index, bodyA_id, vertex_id);
-    bodies.global_to_local_edge(candidate.edge_index, bodyB_id, edge_id);
-    const RigidBody& bodyA = bodies[bodyA_id];
-    const RigidBody& bodyB = bodies[bodyB_id];
-    const PoseD& poseA_t0 = poses_t0[bodyA_id];
-    const PoseD& poseA_t1 = poses_t1[bodyA_id];
-    const PoseD& poseB_t0 = poses_t0[bodyB_id];
-    const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long e0_id = bodyB.edges(edge_id, 0);
-    long e1_id = bodyB.edges(edge_id, 1);
-
     switch (trajectory) {
     case TrajectoryType::LINEAR: {
-        Eigen::Vector2d v_t0 = bodyA.world_vertex(poseA_t0, vertex_id);
-        Eigen::Vector2d v_t1 = bodyA.world_vertex(poseA_t1, vertex_id);
-
-        Eigen::Vector2d e0_t0 = bodyB.world_vertex(poseB_t0, e0_id);
-        Eigen::Vector2d e0_t1 = bodyB.world_vertex(poseB_t1, e0_id);
-
-        Eigen::Vector2d e1_t0 = bodyB.world_vertex(poseB_t0, e1_id);
-        Eigen::Vector2d e1_t1 = bodyB.world_vertex(poseB_t1, e1_id);
-
-        // Expects the arguments as position and displacements
-        return compute_edge_vertex_time_of_impact(
-            e0_t0, e1_t0, v_t0, (e0_t1 - e0_t0).eval(), (e1_t1 - e1_t0).eval(),
-            (v_t1 - v_t0).eval(), toi);
+        long e0_id = bodyB.edges()(edge_id, 0);
+        long e1_id = bodyB.edges()(edge_id, 1);
+        return linear_edge_vertex_ccd(
+            bodyA.world_vertex(poseA_t0, vertex_id),
+            bodyB.world_vertex(poseB_t0, e0_id),
+            bodyB.world_vertex(poseB_t0, e1_id),
+            bodyA.world_vertex(poseA_t1, vertex_id),
+            bodyB.world_vertex(poseB_t1, e0_id),
+            bodyB.world_vertex(poseB_t1, e1_id), toi);
     }
 
     case TrajectoryType::PIECEWISE_LINEAR:
@@ -218,54 +275,35 @@ bool edge_vertex_ccd(
     }
 }
 
-bool edge_edge_ccd(
-    const RigidBodyAssembler& bodies,
-    const PosesD& poses_t0,
-    const PosesD& poses_t1,
-    const EdgeEdgeCandidate& candidate,
+static bool edge_edge_ccd(
+    const RigidBody& bodyA, // Body of the first edge
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long edgeA_id,
+    const RigidBody& bodyB, // Body of the second edge
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long edgeB_id,
     double& toi,
     TrajectoryType trajectory,
     double earliest_toi,
     double minimum_separation_distance)
 {
-#ifdef SAVE_CCD_QUERIES
-    save_ccd_candidate(bodies, poses_t0, poses_t1, candidate);
-#endif
-
-    long bodyA_id, edgeA_id, bodyB_id, edgeB_id;
-    bodies.global_to_local_edge(candidate.edge0_index, bodyA_id, edgeA_id);
-    bodies.global_to_local_edge(candidate.edge1_index, bodyB_id, edgeB_id);
-    const RigidBody& bodyA = bodies[bodyA_id];
-    const RigidBody& bodyB = bodies[bodyB_id];
-    const PoseD& poseA_t0 = poses_t0[bodyA_id];
-    const PoseD& poseA_t1 = poses_t1[bodyA_id];
-    const PoseD& poseB_t0 = poses_t0[bodyB_id];
-    const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long ea0_id = bodyA.edges(edgeA_id, 0);
-    long ea1_id = bodyA.edges(edgeA_id, 1);
-    long eb0_id = bodyB.edges(edgeB_id, 0);
-    long eb1_id = bodyB.edges(edgeB_id, 1);
-
     switch (trajectory) {
     case TrajectoryType::LINEAR: {
-        Eigen::Vector3d ea0_t0 = bodyA.world_vertex(poseA_t0, ea0_id);
-        Eigen::Vector3d ea0_t1 = bodyA.world_vertex(poseA_t1, ea0_id);
-
-        Eigen::Vector3d ea1_t0 = bodyA.world_vertex(poseA_t0, ea1_id);
-        Eigen::Vector3d ea1_t1 = bodyA.world_vertex(poseA_t1, ea1_id);
-
-        Eigen::Vector3d eb0_t0 = bodyB.world_vertex(poseB_t0, eb0_id);
-        Eigen::Vector3d eb0_t1 = bodyB.world_vertex(poseB_t1, eb0_id);
-
-        Eigen::Vector3d eb1_t0 = bodyB.world_vertex(poseB_t0, eb1_id);
-        Eigen::Vector3d eb1_t1 = bodyB.world_vertex(poseB_t1, eb1_id);
-
-        // TODO: Check if edges are parallel
-        bool result = ipc::edge_edge_ccd(
-            ea0_t0, ea1_t0, eb0_t0, eb1_t0, ea0_t1, ea1_t1, eb0_t1, eb1_t1, toi,
-            /*conservative_rescaling=*/0.8);
-        assert(!result || toi > 0);
-        return result;
+        long ea0_id = bodyA.edges()(edgeA_id, 0);
+        long ea1_id = bodyA.edges()(edgeA_id, 1);
+        long eb0_id = bodyB.edges()(edgeB_id, 0);
+        long eb1_id = bodyB.edges()(edgeB_id, 1);
+        return linear_edge_edge_ccd(
+            bodyA.world_vertex(poseA_t0, ea0_id),
+            bodyA.world_vertex(poseA_t0, ea1_id),
+            bodyB.world_vertex(poseB_t0, eb0_id),
+            bodyB.world_vertex(poseB_t0, eb1_id),
+            bodyA.world_vertex(poseA_t1, ea0_id),
+            bodyA.world_vertex(poseA_t1, ea1_id),
+            bodyB.world_vertex(poseB_t1, eb0_id),
+            bodyB.world_vertex(poseB_t1, eb1_id), toi);
     }
 
     case TrajectoryType::PIECEWISE_LINEAR:
@@ -288,6 +326,108 @@ bool edge_edge_ccd(
     }
 }
 
+static bool face_vertex_ccd(
+    const RigidBody& bodyA, // Body of the vertex
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long vertex_id,
+    const RigidBody& bodyB, // Body of the face
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long face_id,
+    double& toi,
+    TrajectoryType trajectory,
+    double earliest_toi,
+    double minimum_separation_distance)
+{
+    switch (trajectory) {
+    case TrajectoryType::LINEAR: {
+        long f0_id = bodyB.faces()(face_id, 0);
+        long f1_id = bodyB.faces()(face_id, 1);
+        long f2_id = bodyB.faces()(face_id, 2);
+        return linear_face_vertex_ccd(
+            bodyA.world_vertex(poseA_t0, vertex_id),
+            bodyB.world_vertex(poseB_t0, f0_id),
+            bodyB.world_vertex(poseB_t0, f1_id),
+            bodyB.world_vertex(poseB_t0, f2_id),
+            bodyA.world_vertex(poseA_t1, vertex_id),
+            bodyB.world_vertex(poseB_t1, f0_id),
+            bodyB.world_vertex(poseB_t1, f1_id),
+            bodyB.world_vertex(poseB_t1, f2_id), toi);
+    }
+
+    case TrajectoryType::PIECEWISE_LINEAR:
+        return compute_piecewise_linear_face_vertex_time_of_impact(
+            bodyA, poseA_t0, poseA_t1, vertex_id, bodyB, poseB_t0, poseB_t1,
+            face_id, toi, earliest_toi, minimum_separation_distance);
+
+    case TrajectoryType::RIGID:
+        return compute_face_vertex_time_of_impact(
+            bodyA, poseA_t0, poseA_t1, vertex_id, bodyB, poseB_t0, poseB_t1,
+            face_id, toi, earliest_toi);
+
+    case TrajectoryType::REDON:
+        return compute_face_vertex_time_of_impact_redon(
+            bodyA, poseA_t0, poseA_t1, vertex_id, bodyB, poseB_t0, poseB_t1,
+            face_id, toi, earliest_toi);
+
+    default:
+        throw "Invalid trajectory type";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CCD of global candidates
+
+// Determine if a single edge-vertext pair intersects.
+bool edge_vertex_ccd(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const EdgeVertexCandidate& candidate,
+    double& toi,
+    TrajectoryType trajectory,
+    double earliest_toi,
+    double minimum_separation_distance)
+{
+    assert(bodies.dim() == 2);
+
+#ifdef SAVE_CCD_QUERIES
+    save_ccd_candidate(bodies, poses_t0, poses_t1, candidate);
+#endif
+
+    long bodyA_id, vertex_id, bodyB_id, edge_id;
+    bodies.global_to_local_vertex(candidate.vertex_index, bodyA_id, vertex_id);
+    bodies.global_to_local_edge(candidate.edge_index, bodyB_id, edge_id);
+    return edge_vertex_ccd(
+        bodies[bodyA_id], poses_t0[bodyA_id], poses_t1[bodyA_id], vertex_id,
+        bodies[bodyB_id], poses_t0[bodyB_id], poses_t1[bodyB_id], edge_id, toi,
+        trajectory, earliest_toi, minimum_separation_distance);
+}
+
+bool edge_edge_ccd(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const EdgeEdgeCandidate& candidate,
+    double& toi,
+    TrajectoryType trajectory,
+    double earliest_toi,
+    double minimum_separation_distance)
+{
+#ifdef SAVE_CCD_QUERIES
+    save_ccd_candidate(bodies, poses_t0, poses_t1, candidate);
+#endif
+
+    long bodyA_id, edgeA_id, bodyB_id, edgeB_id;
+    bodies.global_to_local_edge(candidate.edge0_index, bodyA_id, edgeA_id);
+    bodies.global_to_local_edge(candidate.edge1_index, bodyB_id, edgeB_id);
+    return edge_edge_ccd(
+        bodies[bodyA_id], poses_t0[bodyA_id], poses_t1[bodyA_id], edgeA_id,
+        bodies[bodyB_id], poses_t0[bodyB_id], poses_t1[bodyB_id], edgeB_id,
+        toi, trajectory, earliest_toi, minimum_separation_distance);
+}
+
 bool face_vertex_ccd(
     const RigidBodyAssembler& bodies,
     const PosesD& poses_t0,
@@ -305,57 +445,324 @@ bool face_vertex_ccd(
     long bodyA_id, vertex_id, bodyB_id, face_id;
     bodies.global_to_local_vertex(candidate.vertex_index, bodyA_id, vertex_id);
     bodies.global_to_local_face(candidate.face_index, bodyB_id, face_id);
-    const RigidBody& bodyA = bodies[bodyA_id];
-    const RigidBody& bodyB = bodies[bodyB_id];
-    const PoseD& poseA_t0 = poses_t0[bodyA_id];
-    const PoseD& poseA_t1 = poses_t1[bodyA_id];
-    const PoseD& poseB_t0 = poses_t0[bodyB_id];
-    const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long f0_id = bodyB.faces(face_id, 0);
-    long f1_id = bodyB.faces(face_id, 1);
-    long f2_id = bodyB.faces(face_id, 2);
+    return face_vertex_ccd(
+        bodies[bodyA_id], poses_t0[bodyA_id], poses_t1[bodyA_id], vertex_id,
+        bodies[bodyB_id], poses_t0[bodyB_id], poses_t1[bodyB_id], face_id, toi,
+        trajectory, earliest_toi, minimum_separation_distance);
+}
 
-    switch (trajectory) {
-    case TrajectoryType::LINEAR: {
-        Eigen::Vector3d v_t0 = bodyA.world_vertex(poseA_t0, vertex_id);
-        Eigen::Vector3d v_t1 = bodyA.world_vertex(poseA_t1, vertex_id);
+///////////////////////////////////////////////////////////////////////////////
+// Batched Narrow-Phase
+///////////////////////////////////////////////////////////////////////////////
 
-        Eigen::Vector3d f0_t0 = bodyB.world_vertex(poseB_t0, f0_id);
-        Eigen::Vector3d f0_t1 = bodyB.world_vertex(poseB_t1, f0_id);
+void group_candidates_by_body_pair(
+    const RigidBodyAssembler& bodies,
+    const Candidates& candidates,
+    std::vector<BodyPairCandidates>& body_pairs)
+{
+    PROFILE_POINT("group_candidates_by_body_pair");
+    PROFILE_START();
 
-        Eigen::Vector3d f1_t0 = bodyB.world_vertex(poseB_t0, f1_id);
-        Eigen::Vector3d f1_t1 = bodyB.world_vertex(poseB_t1, f1_id);
+    body_pairs.clear();
 
-        Eigen::Vector3d f2_t0 = bodyB.world_vertex(poseB_t0, f2_id);
-        Eigen::Vector3d f2_t1 = bodyB.world_vertex(poseB_t1, f2_id);
+    // Map from the (sorted) pair of body ids to the index in body_pairs
+    std::unordered_map<size_t, size_t> body_pair_ids;
+    const size_t num_bodies = bodies.num_bodies();
+    const auto find_body_pair = [&](long bodyA_id,
+                                    long bodyB_id) -> BodyPairCandidates& {
+        if (bodyA_id > bodyB_id) {
+            std::swap(bodyA_id, bodyB_id);
+        }
+        const size_t key = size_t(bodyA_id) * num_bodies + size_t(bodyB_id);
+        auto inserted = body_pair_ids.emplace(key, body_pairs.size());
+        if (inserted.second) {
+            body_pairs.emplace_back(bodyA_id, bodyB_id);
+        }
+        return body_pairs[inserted.first->second];
+    };
 
-        bool result = ipc::point_triangle_ccd(
-            v_t0, f0_t0, f1_t0, f2_t0, v_t1, f0_t1, f1_t1, f2_t1, toi,
-            /*conservative_rescaling=*/0.8);
-        assert(!result || toi > 0);
-        return result;
+    for (size_t i = 0; i < candidates.ev_candidates.size(); i++) {
+        const EdgeVertexCandidate& candidate = candidates.ev_candidates[i];
+        find_body_pair(
+            bodies.vertex_id_to_body_id(candidate.vertex_index),
+            bodies.edge_id_to_body_id(candidate.edge_index))
+            .ev_candidates.push_back(i);
+    }
+    for (size_t i = 0; i < candidates.ee_candidates.size(); i++) {
+        const EdgeEdgeCandidate& candidate = candidates.ee_candidates[i];
+        find_body_pair(
+            bodies.edge_id_to_body_id(candidate.edge0_index),
+            bodies.edge_id_to_body_id(candidate.edge1_index))
+            .ee_candidates.push_back(i);
+    }
+    for (size_t i = 0; i < candidates.fv_candidates.size(); i++) {
+        const FaceVertexCandidate& candidate = candidates.fv_candidates[i];
+        find_body_pair(
+            bodies.vertex_id_to_body_id(candidate.vertex_index),
+            bodies.face_id_to_body_id(candidate.face_index))
+            .fv_candidates.push_back(i);
     }
 
-    case TrajectoryType::PIECEWISE_LINEAR:
-        return compute_piecewise_linear_face_vertex_time_of_impact(
-            bodyA, poseA_t0, poseA_t1, vertex_id, bodyB, poseB_t0, poseB_t1,
-            face_id, toi, earliest_toi, minimum_separation_distance);
+    PROFILE_END();
+}
 
-    case TrajectoryType::RIGID:
-        return compute_face_vertex_time_of_impact(
-            bodyA, poseA_t0, poseA_t1, vertex_id, bodyB, poseB_t0, poseB_t1,
-            face_id, toi, earliest_toi);
+namespace {
+    /// World vertices of the primitives of one body in a body pair stored in
+    /// a compact buffer at the start and end of the time-step.
+    class BodyVertexBuffer {
+    public:
+        void add(long local_vertex_id) { local_ids.push_back(local_vertex_id); }
+
+        void build(
+            const RigidBody& body, const PoseD& pose_t0, const PoseD& pose_t1)
+        {
+            std::sort(local_ids.begin(), local_ids.end());
+            local_ids.erase(
+                std::unique(local_ids.begin(), local_ids.end()),
+                local_ids.end());
+
+            const MatrixMax3d R_t0 = pose_t0.construct_rotation_matrix();
+            const MatrixMax3d R_t1 = pose_t1.construct_rotation_matrix();
+            V_t0.resize(local_ids.size(), body.dim());
+            V_t1.resize(local_ids.size(), body.dim());
+            for (size_t i = 0; i < local_ids.size(); i++) {
+                V_t0.row(i) =
+                    body.vertices().row(local_ids[i]) * R_t0.transpose()
+                    + pose_t0.position.transpose();
+                V_t1.row(i) =
+                    body.vertices().row(local_ids[i]) * R_t1.transpose()
+                    + pose_t1.position.transpose();
+            }
+        }
 
-    case TrajectoryType::REDON:
-        return compute_face_vertex_time_of_impact_redon(
-            bodyA, poseA_t0, poseA_t1, vertex_id, bodyB, poseB_t0, poseB_t1,
-            face_id, toi, earliest_toi);
+        VectorMax3d t0(long local_vertex_id) const
+        {
+            return V_t0.row(index(local_vertex_id));
+        }
+        VectorMax3d t1(long local_vertex_id) const
+        {
+            return V_t1.row(index(local_vertex_id));
+        }
 
-    default:
-        throw "Invalid trajectory type";
+    protected:
+        size_t index(long local_vertex_id) const
+        {
+            auto it = std::lower_bound(
+                local_ids.begin(), local_ids.end(), local_vertex_id);
+            assert(it != local_ids.end() && *it == local_vertex_id);
+            return it - local_ids.begin();
+        }
+
+        std::vector<long> local_ids;
+        Eigen::MatrixXd V_t0, V_t1;
+    };
+} // namespace
+
+size_t detect_body_pair_collisions(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const Candidates& candidates,
+    const BodyPairCandidates& body_pair,
+    TrajectoryType trajectory,
+    const BodyPairImpactCallback& on_impact,
+    const double& earliest_toi,
+    double minimum_separation_distance)
+{
+    NAMED_PROFILE_POINT(
+        "detect_body_pair_collisions:edge_vertex", EV_NARROW_PHASE);
+    NAMED_PROFILE_POINT(
+        "detect_body_pair_collisions:edge_edge", EE_NARROW_PHASE);
+    NAMED_PROFILE_POINT(
+        "detect_body_pair_collisions:face_vertex", FV_NARROW_PHASE);
+
+    // Shared setup of the body pair
+    const long body_ids[2] = { body_pair.bodyA_id, body_pair.bodyB_id };
+    const RigidBody* rbs[2] = { &bodies[body_ids[0]], &bodies[body_ids[1]] };
+    const PoseD* rb_poses_t0[2] = { &poses_t0[body_ids[0]],
+                                    &poses_t0[body_ids[1]] };
+    const PoseD* rb_poses_t1[2] = { &poses_t1[body_ids[0]],
+                                    &poses_t1[body_ids[1]] };
+    const long vertex_offsets[2] = { bodies.m_body_vertex_id[body_ids[0]],
+                                     bodies.m_body_vertex_id[body_ids[1]] };
+    const long edge_offsets[2] = { bodies.m_body_edge_id[body_ids[0]],
+                                   bodies.m_body_edge_id[body_ids[1]] };
+    const long face_offsets[2] = { bodies.m_body_face_id[body_ids[0]],
+                                   bodies.m_body_face_id[body_ids[1]] };
+
+    // Index (0 or 1) of the body in the pair that owns a global primitive
+    const auto vertex_body = [&](long vi) {
+        return int(bodies.vertex_id_to_body_id(vi) != body_ids[0]);
+    };
+    const auto edge_body = [&](long ei) {
+        return int(bodies.edge_id_to_body_id(ei) != body_ids[0]);
+    };
+    const auto face_body = [&](long fi) {
+        return int(bodies.face_id_to_body_id(fi) != body_ids[0]);
+    };
+
+    // Prefetch the world vertices of linear trajectories
+    const bool is_linear = trajectory == TrajectoryType::LINEAR;
+    BodyVertexBuffer buffers[2];
+    if (is_linear) {
+        for (const size_t ci : body_pair.ev_candidates) {
+            const auto& c = candidates.ev_candidates[ci];
+            int a = vertex_body(c.vertex_index), b = edge_body(c.edge_index);
+            long edge_id = c.edge_index - edge_offsets[b];
+            buffers[a].add(c.vertex_index - vertex_offsets[a]);
+            buffers[b].add(rbs[b]->edges()(edge_id, 0));
+            buffers[b].add(rbs[b]->edges()(edge_id, 1));
+        }
+        for (const size_t ci : body_pair.ee_candidates) {
+            const auto& c = candidates.ee_candidates[ci];
+            int a = edge_body(c.edge0_index), b = edge_body(c.edge1_index);
+            long edgeA_id = c.edge0_index - edge_offsets[a];
+            long edgeB_id = c.edge1_index - edge_offsets[b];
+            buffers[a].add(rbs[a]->edges()(edgeA_id, 0));
+            buffers[a].add(rbs[a]->edges()(edgeA_id, 1));
+            buffers[b].add(rbs[b]->edges()(edgeB_id, 0));
+            buffers[b].add(rbs[b]->edges()(edgeB_id, 1));
+        }
+        for (const size_t ci : body_pair.fv_candidates) {
+            const auto& c = candidates.fv_candidates[ci];
+            int a = vertex_body(c.vertex_index), b = face_body(c.face_index);
+            long face_id = c.face_index - face_offsets[b];
+            buffers[a].add(c.vertex_index - vertex_offsets[a]);
+            buffers[b].add(rbs[b]->faces()(face_id, 0));
+            buffers[b].add(rbs[b]->faces()(face_id, 1));
+            buffers[b].add(rbs[b]->faces()(face_id, 2));
+        }
+        for (int i = 0; i < 2; i++) {
+            buffers[i].build(*rbs[i], *rb_poses_t0[i], *rb_poses_t1[i]);
+        }
     }
+
+    // Number of candidates rejected before the exact CCD
+    size_t num_filtered = 0;
+
+    PROFILE_START(EV_NARROW_PHASE);
+    for (const size_t ci : body_pair.ev_candidates) {
+        const EdgeVertexCandidate& c = candidates.ev_candidates[ci];
+#ifdef SAVE_CCD_QUERIES
+        save_ccd_candidate(bodies, poses_t0, poses_t1, c);
+#endif
+        int a = vertex_body(c.vertex_index), b = edge_body(c.edge_index);
+        long vertex_id = c.vertex_index - vertex_offsets[a];
+        long edge_id = c.edge_index - edge_offsets[b];
+
+        double toi;
+        bool is_colliding;
+        if (is_linear) {
+            long e0_id = rbs[b]->edges()(edge_id, 0);
+            long e1_id = rbs[b]->edges()(edge_id, 1);
+            is_colliding = linear_edge_vertex_ccd(
+                buffers[a].t0(vertex_id), buffers[b].t0(e0_id),
+                buffers[b].t0(e1_id), buffers[a].t1(vertex_id),
+                buffers[b].t1(e0_id), buffers[b].t1(e1_id), toi);
+        } else if (is_edge_vertex_trajectory_separated(
+                       *rbs[a], *rb_poses_t0[a], *rb_poses_t1[a], vertex_id,
+                       *rbs[b], *rb_poses_t0[b], *rb_poses_t1[b], edge_id,
+                       earliest_toi, minimum_separation_distance)) {
+            num_filtered++;
+            is_colliding = false;
+        } else {
+            is_colliding = edge_vertex_ccd(
+                *rbs[a], *rb_poses_t0[a], *rb_poses_t1[a], vertex_id, //
+                *rbs[b], *rb_poses_t0[b], *rb_poses_t1[b], edge_id,   //
+                toi, trajectory, earliest_toi, minimum_separation_distance);
+        }
+        if (is_colliding) {
+            on_impact(CollisionType::EDGE_VERTEX, ci, toi);
+        }
+    }
+    PROFILE_END(EV_NARROW_PHASE);
+
+    PROFILE_START(EE_NARROW_PHASE);
+    for (const size_t ci : body_pair.ee_candidates) {
+        const EdgeEdgeCandidate& c = candidates.ee_candidates[ci];
+#ifdef SAVE_CCD_QUERIES
+        save_ccd_candidate(bodies, poses_t0, poses_t1, c);
+#endif
+        int a = edge_body(c.edge0_index), b = edge_body(c.edge1_index);
+        long edgeA_id = c.edge0_index - edge_offsets[a];
+        long edgeB_id = c.edge1_index - edge_offsets[b];
+
+        double toi;
+        bool is_colliding;
+        if (is_linear) {
+            long ea0_id = rbs[a]->edges()(edgeA_id, 0);
+            long ea1_id = rbs[a]->edges()(edgeA_id, 1);
+            long eb0_id = rbs[b]->edges()(edgeB_id, 0);
+            long eb1_id = rbs[b]->edges()(edgeB_id, 1);
+            is_colliding = linear_edge_edge_ccd(
+                buffers[a].t0(ea0_id), buffers[a].t0(ea1_id),
+                buffers[b].t0(eb0_id), buffers[b].t0(eb1_id),
+                buffers[a].t1(ea0_id), buffers[a].t1(ea1_id),
+                buffers[b].t1(eb0_id), buffers[b].t1(eb1_id), toi);
+        } else if (is_edge_edge_trajectory_separated(
+                       *rbs[a], *rb_poses_t0[a], *rb_poses_t1[a], edgeA_id,
+                       *rbs[b], *rb_poses_t0[b], *rb_poses_t1[b], edgeB_id,
+                       earliest_toi, minimum_separation_distance)) {
+            num_filtered++;
+            is_colliding = false;
+        } else {
+            is_colliding = edge_edge_ccd(
+                *rbs[a], *rb_poses_t0[a], *rb_poses_t1[a], edgeA_id, //
+                *rbs[b], *rb_poses_t0[b], *rb_poses_t1[b], edgeB_id, //
+                toi, trajectory, earliest_toi, minimum_separation_distance);
+        }
+        if (is_colliding) {
+            on_impact(CollisionType::EDGE_EDGE, ci, toi);
+        }
+    }
+    PROFILE_END(EE_NARROW_PHASE);
+
+    PROFILE_START(FV_NARROW_PHASE);
+    for (const size_t ci : body_pair.fv_candidates) {
+        const FaceVertexCandidate& c = candidates.fv_candidates[ci];
+#ifdef SAVE_CCD_QUERIES
+        save_ccd_candidate(bodies, poses_t0, poses_t1, c);
+#endif
+        int a = vertex_body(c.vertex_index), b = face_body(c.face_index);
+        long vertex_id = c.vertex_index - vertex_offsets[a];
+        long face_id = c.face_index - face_offsets[b];
+
+        double toi;
+        bool is_colliding;
+        if (is_linear) {
+            long f0_id = rbs[b]->faces()(face_id, 0);
+            long f1_id = rbs[b]->faces()(face_id, 1);
+            long f2_id = rbs[b]->faces()(face_id, 2);
+            is_colliding = linear_face_vertex_ccd(
+                buffers[a].t0(vertex_id), buffers[b].t0(f0_id),
+                buffers[b].t0(f1_id), buffers[b].t0(f2_id),
+                buffers[a].t1(vertex_id), buffers[b].t1(f0_id),
+                buffers[b].t1(f1_id), buffers[b].t1(f2_id), toi);
+        } else if (is_face_vertex_trajectory_separated(
+                       *rbs[a], *rb_poses_t0[a], *rb_poses_t1[a], vertex_id,
+                       *rbs[b], *rb_poses_t0[b], *rb_poses_t1[b], face_id,
+                       earliest_toi, minimum_separation_distance)) {
+            num_filtered++;
+            is_colliding = false;
+        } else {
+            is_colliding = face_vertex_ccd(
+                *rbs[a], *rb_poses_t0[a], *rb_poses_t1[a], vertex_id, //
+                *rbs[b], *rb_poses_t0[b], *rb_poses_t1[b], face_id,   //
+                toi, trajectory, earliest_toi, minimum_separation_distance);
+        }
+        if (is_colliding) {
+            on_impact(CollisionType::FACE_VERTEX, ci, toi);
+        }
+    }
+    PROFILE_END(FV_NARROW_PHASE);
+
+    return num_filtered;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Closest points
+///////////////////////////////////////////////////////////////////////////////
+
 double edge_vertex_closest_point(
     const RigidBodyAssembler& bodies,
     const PosesD& poses_t0,
@@ -373,8 +780,8 @@ double edge_vertex_closest_point(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long e0_id = bodyB.edges(edge_id, 0);
-    long e1_id = bodyB.edges(edge_id, 1);
+    long e0_id = bodyB.edges()(edge_id, 0);
+    long e1_id = bodyB.edges()(edge_id, 1);
 
     Eigen::Vector2d v, e0, e1;
     switch (trajectory) {
@@ -428,10 +835,10 @@ void edge_edge_closest_point(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long ea0_id = bodyA.edges(edgeA_id, 0);
-    long ea1_id = bodyA.edges(edgeA_id, 1);
-    long eb0_id = bodyB.edges(edgeB_id, 0);
-    long eb1_id = bodyB.edges(edgeB_id, 1);
+    long ea0_id = bodyA.edges()(edgeA_id, 0);
+    long ea1_id = bodyA.edges()(edgeA_id, 1);
+    long eb0_id = bodyB.edges()(edgeB_id, 0);
+    long eb1_id = bodyB.edges()(edgeB_id, 1);
 
     Eigen::Vector3d ea0, ea1, eb0, eb1;
     switch (trajectory) {
@@ -462,11 +869,11 @@ void edge_edge_closest_point(
         PoseD poseA_toi = PoseD::interpolate(poseA_t0, poseA_t1, toi);
         PoseD poseB_toi = PoseD::interpolate(poseB_t0, poseB_t1, toi);
 
-        ea0 = bodyA.world_vertex(poseA_toi, bodyA.edges(edgeA_id, 0));
-        ea1 = bodyA.world_vertex(poseA_toi, bodyA.edges(edgeA_id, 1));
+        ea0 = bodyA.world_vertex(poseA_toi, bodyA.edges()(edgeA_id, 0));
+        ea1 = bodyA.world_vertex(poseA_toi, bodyA.edges()(edgeA_id, 1));
 
-        eb0 = bodyB.world_vertex(poseB_toi, bodyB.edges(edgeB_id, 0));
-        eb1 = bodyB.world_vertex(poseB_toi, bodyB.edges(edgeB_id, 1));
+        eb0 = bodyB.world_vertex(poseB_toi, bodyB.edges()(edgeB_id, 0));
+        eb1 = bodyB.world_vertex(poseB_toi, bodyB.edges()(edgeB_id, 1));
         break;
     }
     }
@@ -495,9 +902,9 @@ void face_vertex_closest_point(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long f0_id = bodyB.faces(face_id, 0);
-    long f1_id = bodyB.faces(face_id, 1);
-    long f2_id = bodyB.faces(face_id, 2);
+    long f0_id = bodyB.faces()(face_id, 0);
+    long f1_id = bodyB.faces()(face_id, 1);
+    long f2_id = bodyB.faces()(face_id, 2);
 
     Eigen::Vector3d p, f0, f1, f2;
     switch (trajectory) {
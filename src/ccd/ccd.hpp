@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include <Eigen/Core>
 
 #include <nlohmann/json.hpp>
@@ -125,6 +128,68 @@ bool face_vertex_ccd(
     double earliest_toi = 1,
     double minimum_separation_distance = 0);
 
+///////////////////////////////////////////////////////////////////////////////
+// Batched Narrow-Phase
+///////////////////////////////////////////////////////////////////////////////
+
+/// @brief Indices of the candidates between a single pair of bodies.
+struct BodyPairCandidates {
+    BodyPairCandidates(long bodyA_id, long bodyB_id)
+        : bodyA_id(bodyA_id)
+        , bodyB_id(bodyB_id)
+    {
+    }
+
+    size_t size() const
+    {
+        return ev_candidates.size() + ee_candidates.size()
+            + fv_candidates.size();
+    }
+
+    long bodyA_id; ///< @brief Smaller body id of the pair
+    long bodyB_id; ///< @brief Larger body id of the pair
+    /// @brief Indices into Candidates::ev_candidates
+    std::vector<size_t> ev_candidates;
+    /// @brief Indices into Candidates::ee_candidates
+    std::vector<size_t> ee_candidates;
+    /// @brief Indices into Candidates::fv_candidates
+    std::vector<size_t> fv_candidates;
+};
+
+/// @brief Group the candidates by the pair of bodies they belong to.
+void group_candidates_by_body_pair(
+    const RigidBodyAssembler& bodies,
+    const Candidates& candidates,
+    std::vector<BodyPairCandidates>& body_pairs);
+
+/// @brief Called for every colliding candidate of a body pair with the
+/// CollisionType of the candidate, its index in the candidate vector, and its
+/// time of impact.
+typedef std::function<void(int, size_t, double)> BodyPairImpactCallback;
+
+/// @brief Run the narrow-phase on all candidates between a pair of bodies.
+///
+/// The body and pose lookups are shared by all candidates of the pair, and the
+/// world vertices of linear trajectories are computed once into a compact
+/// buffer.
+///
+/// Nonlinear trajectories first run a conservative double-precision distance
+/// test, and only the candidates it cannot reject go to the exact CCD.
+///
+/// @param earliest_toi Only search for collision in [0, earliest_toi]. It is
+///                     read before every candidate, so on_impact may shrink it.
+/// @return The number of candidates rejected without running the exact CCD.
+size_t detect_body_pair_collisions(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const Candidates& candidates,
+    const BodyPairCandidates& body_pair,
+    TrajectoryType trajectory,
+    const BodyPairImpactCallback& on_impact,
+    const double& earliest_toi,
+    double minimum_separation_distance = 0);
+
 double edge_vertex_closest_point(
     const RigidBodyAssembler& bodies,
     const PosesD& poses_t0,
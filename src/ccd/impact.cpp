@@ -1,6 +1,9 @@
 // Data structures for impacts between different geometry.
 #include <ccd/impact.hpp>
 
+#include <algorithm>
+#include <tuple>
+
 namespace ipc::rigid {
 
 EdgeVertexImpact::EdgeVertexImpact(
@@ -63,6 +66,53 @@ bool FaceVertexImpact::operator==(const FaceVertexImpact& other) const
         && this->vertex_index == other.vertex_index;
 }
 
+// Append the impacts of every thread and sort them into a deterministic order.
+template <typename Impact, typename Compare>
+static void merge_local_impact_vectors(
+    const ThreadSpecificImpacts& storages,
+    std::vector<Impact> Impacts::*member,
+    std::vector<Impact>& impacts,
+    Compare compare)
+{
+    size_t size = 0;
+    for (const auto& local_impacts : storages) {
+        size += (local_impacts.*member).size();
+    }
+    impacts.clear();
+    impacts.reserve(size);
+    for (const auto& local_impacts : storages) {
+        impacts.insert(
+            impacts.end(), (local_impacts.*member).begin(),
+            (local_impacts.*member).end());
+    }
+    std::sort(impacts.begin(), impacts.end(), compare);
+}
+
+void merge_local_impacts(
+    const ThreadSpecificImpacts& storages, Impacts& impacts)
+{
+    merge_local_impact_vectors(
+        storages, &Impacts::ev_impacts, impacts.ev_impacts,
+        [](const EdgeVertexImpact& a, const EdgeVertexImpact& b) {
+            return std::tie(a.time, a.edge_index, a.vertex_index)
+                < std::tie(b.time, b.edge_index, b.vertex_index);
+        });
+    merge_local_impact_vectors(
+        storages, &Impacts::ee_impacts, impacts.ee_impacts,
+        [](const EdgeEdgeImpact& a, const EdgeEdgeImpact& b) {
+            return std::tie(
+                       a.time, a.impacted_edge_index, a.impacting_edge_index)
+                < std::tie(
+                       b.time, b.impacted_edge_index, b.impacting_edge_index);
+        });
+    merge_local_impact_vectors(
+        storages, &Impacts::fv_impacts, impacts.fv_impacts,
+        [](const FaceVertexImpact& a, const FaceVertexImpact& b) {
+            return std::tie(a.time, a.face_index, a.vertex_index)
+                < std::tie(b.time, b.face_index, b.vertex_index);
+        });
+}
+
 // Convert all edge-vertex impacts to correspoding edge-edge impacts. There may
 // be multiple edge-edge impacts per edge-vertex impact depending on the
 // connectivity.
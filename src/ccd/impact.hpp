@@ -2,6 +2,8 @@
 
 #include <vector>
 
+#include <tbb/enumerable_thread_specific.h>
+
 #include <Eigen/Core>
 
 namespace ipc::rigid {
@@ -75,6 +77,20 @@ struct Impacts {
     }
 };
 
+typedef tbb::enumerable_thread_specific<Impacts> ThreadSpecificImpacts;
+
+/**
+ * @brief Merge the thread local impacts into a single set of impacts.
+ *
+ * The merged impacts are sorted by time (ties broken by the primitive
+ * indices), so the output does not depend on the thread scheduling.
+ *
+ * @param storages Thread local impacts to merge.
+ * @param impacts Where to store the merged impacts. The vectors are cleared.
+ */
+void merge_local_impacts(
+    const ThreadSpecificImpacts& storages, Impacts& impacts);
+
 /**
  * @brief Compare two impacts to determine if impact0 comes before impact1.
  *
@@ -269,8 +269,9 @@ void detect_collision_candidates_linear_bvh(
                 const auto& bodyA = bodies[bodyA_id];
                 const auto& bodyB = bodies[bodyB_id];
 
-                // PROFILE_POINT("detect_collision_candidates_linear_bvh:compute_vertices");
-                // PROFILE_START();
+                PROFILE_POINT(
+                    "detect_collision_candidates_linear_bvh:compute_vertices");
+                PROFILE_START();
                 // Compute the smaller body's vertices in the larger body's
                 // local coordinates.
                 const auto& pA_t0 = poses_t0[bodyA_id].position;
@@ -286,11 +287,11 @@ void detect_collision_candidates_linear_bvh(
                 const auto RB_t1 =
                     poses_t1[bodyB_id].construct_rotation_matrix();
                 const Eigen::MatrixXd VA_t0 =
-                    ((bodyA.vertices * RA_t0.transpose()).rowwise()
+                    ((bodyA.vertices() * RA_t0.transpose()).rowwise()
                      + (pA_t0 - pB_t0).transpose())
                     * RB_t0;
                 const Eigen::MatrixXd VA_t1 =
-                    ((bodyA.vertices * RA_t1.transpose()).rowwise()
+                    ((bodyA.vertices() * RA_t1.transpose()).rowwise()
                      + (pA_t1 - pB_t1).transpose())
                     * RB_t1;
 
@@ -303,7 +304,7 @@ void detect_collision_candidates_linear_bvh(
                         v_t0.cwiseMin(v_t1).array() - inflation_radius,
                         v_t0.cwiseMax(v_t1).array() + inflation_radius);
                 }
-                // PROFILE_END();
+                PROFILE_END();
 
                 detect_body_pair_collision_candidates_from_aabbs(
                     bodies, VA_aabbs, bodyA_id, bodyB_id, collision_types,
@@ -34,6 +34,8 @@ static const size_t FIXED_NUM_PIECES = 100;
 
 static const size_t MAX_NUM_SUBDIVISIONS = 1e3;
 
+static const size_t MAX_NUM_ADAPTIVE_PIECES = 100;
+
 static const size_t LINEAR_CCD_MAX_ITERATIONS = 1e6;
 static const double LINEAR_CCD_TOL = 1e-6;
 
@@ -52,6 +54,46 @@ static const int TIGHT_INCLUSION_CCD_TYPE = 1;
 // outer CCD algorithmn will perform the refinement in a smarter way.
 static const bool TIGHT_INCLUSION_NO_ZERO_TOI = false;
 
+// Maximum distance of the given vertices from the center of mass.
+static double max_vertex_radius(
+    const RigidBody& body, std::initializer_list<long> vertex_ids)
+{
+    double radius = 0;
+    for (const long vi : vertex_ids) {
+        radius = std::max(radius, body.vertices().row(vi).norm());
+    }
+    return radius;
+}
+
+// Choose the number of linear pieces from the rotation swept by each body and
+// the distance of its primitive from the center of mass. A point at radius r
+// rotating by θ deviates from its chord by at most r (1 - cos(θ/2)) ≤ r θ²/8,
+// so primitives close to the center of mass need fewer pieces. This is only
+// an initial guess; the interval bound below still subdivides if needed.
+static int adaptive_num_pieces(
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    double radiusA,
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    double radiusB,
+    double earliest_toi,
+    double distance_t0)
+{
+    double angleA =
+        earliest_toi * (poseA_t1.rotation - poseA_t0.rotation).norm();
+    double angleB =
+        earliest_toi * (poseB_t1.rotation - poseB_t0.rotation).norm();
+    double error = (radiusA * angleA * angleA + radiusB * angleB * angleB) / 8;
+    double max_error = TRAJECTORY_DISTANCE_FACTOR * distance_t0;
+    if (error < max_error) {
+        return 1;
+    }
+    return int(std::min(
+        std::ceil(std::sqrt(error / max_error)),
+        double(MAX_NUM_ADAPTIVE_PIECES)));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Edge-Vertex
 
@@ -114,7 +156,8 @@ bool compute_piecewise_linear_edge_vertex_time_of_impact(
     double& toi,
     double earliest_toi, // Only search for collision in [0, earliest_toi]
     double minimum_separation_distance,
-    double toi_tolerance)
+    double toi_tolerance,
+    PiecewiseLinearPieces initial_pieces)
 {
     int dim = bodyA.dim();
     assert(bodyB.dim() == dim);
@@ -122,8 +165,8 @@ bool compute_piecewise_linear_edge_vertex_time_of_impact(
     assert(minimum_separation_distance >= 0);
 
     const long vi = vertex_id;
-    const long e0i = bodyB.edges(edge_id, 0);
-    const long e1i = bodyB.edges(edge_id, 1);
+    const long e0i = bodyB.edges()(edge_id, 0);
+    const long e1i = bodyB.edges()(edge_id, 1);
 
     double distance_t0 = sqrt(point_edge_distance(
         bodyA.world_vertex(poseA_t0, vi), //
@@ -148,8 +191,16 @@ bool compute_piecewise_linear_edge_vertex_time_of_impact(
     }
     int num_subdivisions = FIXED_NUM_PIECES;
 #else
-    ts.push(earliest_toi);
     int num_subdivisions = 1;
+    if (initial_pieces == PiecewiseLinearPieces::ADAPTIVE) {
+        num_subdivisions = adaptive_num_pieces(
+            poseA_t0, poseA_t1, max_vertex_radius(bodyA, { vi }), //
+            poseB_t0, poseB_t1, max_vertex_radius(bodyB, { e0i, e1i }), //
+            earliest_toi, distance_t0);
+    }
+    for (int i = num_subdivisions; i > 0; i--) {
+        ts.push(i / double(num_subdivisions) * earliest_toi);
+    }
 #endif
 
     while (!ts.empty()) {
@@ -280,17 +331,18 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
     double& toi,
     double earliest_toi, // Only search for collision in [0, earliest_toi]
     double minimum_separation_distance,
-    double toi_tolerance)
+    double toi_tolerance,
+    PiecewiseLinearPieces initial_pieces)
 {
     int dim = bodyA.dim();
     assert(bodyB.dim() == dim);
     assert(dim == 3);
     assert(minimum_separation_distance >= 0);
 
-    const long ea0i = bodyA.edges(edgeA_id, 0);
-    const long ea1i = bodyA.edges(edgeA_id, 1);
-    const long eb0i = bodyB.edges(edgeB_id, 0);
-    const long eb1i = bodyB.edges(edgeB_id, 1);
+    const long ea0i = bodyA.edges()(edgeA_id, 0);
+    const long ea1i = bodyA.edges()(edgeA_id, 1);
+    const long eb0i = bodyB.edges()(edgeB_id, 0);
+    const long eb1i = bodyB.edges()(edgeB_id, 1);
 
     double distance_t0 = sqrt(edge_edge_distance(
         bodyA.world_vertex(poseA_t0, ea0i), bodyA.world_vertex(poseA_t0, ea1i),
@@ -322,8 +374,16 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
     }
     int num_subdivisions = FIXED_NUM_PIECES;
 #else
-    ts.push(earliest_toi);
     int num_subdivisions = 1;
+    if (initial_pieces == PiecewiseLinearPieces::ADAPTIVE) {
+        num_subdivisions = adaptive_num_pieces(
+            poseA_t0, poseA_t1, max_vertex_radius(bodyA, { ea0i, ea1i }), //
+            poseB_t0, poseB_t1, max_vertex_radius(bodyB, { eb0i, eb1i }), //
+            earliest_toi, distance_t0);
+    }
+    for (int i = num_subdivisions; i > 0; i--) {
+        ts.push(i / double(num_subdivisions) * earliest_toi);
+    }
 #endif
 
     while (!ts.empty()) {
@@ -333,10 +393,10 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
         PoseD poseB_ti1 = PoseD::interpolate(poseB_t0, poseB_t1, ti1);
 
         double distance_ti0 = sqrt(edge_edge_distance(
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 0)),
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 1)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 0)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 1))));
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 0)),
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 1)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 0)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 1))));
 
 #ifdef USE_DECREASING_DISTANCE_CHECK
         if (distance_ti0 < DECREASING_DISTANCE_FACTOR * distance_t0
@@ -409,14 +469,14 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
         // 1: ccd with max_itr and t=[0, t_max]
         const int CCD_TYPE = 1;
         is_impacting = inclusion_ccd::edgeEdgeCCD_double(
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 0)),
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 1)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 0)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 1)),
-            bodyA.world_vertex(poseA_ti1, bodyA.edges(edgeA_id, 0)),
-            bodyA.world_vertex(poseA_ti1, bodyA.edges(edgeA_id, 1)),
-            bodyB.world_vertex(poseB_ti1, bodyB.edges(edgeB_id, 0)),
-            bodyB.world_vertex(poseB_ti1, bodyB.edges(edgeB_id, 1)),
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 0)),
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 1)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 0)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 1)),
+            bodyA.world_vertex(poseA_ti1, bodyA.edges()(edgeA_id, 0)),
+            bodyA.world_vertex(poseA_ti1, bodyA.edges()(edgeA_id, 1)),
+            bodyB.world_vertex(poseB_ti1, bodyB.edges()(edgeB_id, 0)),
+            bodyB.world_vertex(poseB_ti1, bodyB.edges()(edgeB_id, 1)),
             { { -1, -1, -1 } },        // rounding error
             min_distance,              // minimum separation distance
             toi,                       // time of impact
@@ -476,7 +536,8 @@ bool compute_piecewise_linear_face_vertex_time_of_impact(
     double& toi,
     double earliest_toi, // Only search for collision in [0, earliest_toi]
     double minimum_separation_distance,
-    double toi_tolerance)
+    double toi_tolerance,
+    PiecewiseLinearPieces initial_pieces)
 {
     int dim = bodyA.dim();
     assert(bodyB.dim() == dim);
@@ -484,9 +545,9 @@ bool compute_piecewise_linear_face_vertex_time_of_impact(
     assert(minimum_separation_distance >= 0);
 
     const long vi = vertex_id;
-    const long f0i = bodyB.faces(face_id, 0);
-    const long f1i = bodyB.faces(face_id, 1);
-    const long f2i = bodyB.faces(face_id, 2);
+    const long f0i = bodyB.faces()(face_id, 0);
+    const long f1i = bodyB.faces()(face_id, 1);
+    const long f2i = bodyB.faces()(face_id, 2);
 
     double distance_t0 = sqrt(point_triangle_distance(
         bodyA.world_vertex(poseA_t0, vi), bodyB.world_vertex(poseB_t0, f0i),
@@ -516,8 +577,16 @@ bool compute_piecewise_linear_face_vertex_time_of_impact(
     }
     int num_subdivisions = FIXED_NUM_PIECES;
 #else
-    ts.push(earliest_toi);
     int num_subdivisions = 1;
+    if (initial_pieces == PiecewiseLinearPieces::ADAPTIVE) {
+        num_subdivisions = adaptive_num_pieces(
+            poseA_t0, poseA_t1, max_vertex_radius(bodyA, { vi }), //
+            poseB_t0, poseB_t1, max_vertex_radius(bodyB, { f0i, f1i, f2i }), //
+            earliest_toi, distance_t0);
+    }
+    for (int i = num_subdivisions; i > 0; i--) {
+        ts.push(i / double(num_subdivisions) * earliest_toi);
+    }
 #endif
 
     while (!ts.empty()) {
@@ -6,6 +6,13 @@
 
 namespace ipc::rigid {
 
+/// How the trajectory is initially split into linear pieces (the pieces are
+/// then subdivided until the linearization error is bounded).
+enum class PiecewiseLinearPieces {
+    SINGLE,  ///< A single piece
+    ADAPTIVE ///< Pieces estimated from the rotation swept by each primitive
+};
+
 /// Find time-of-impact between two rigid bodies
 bool compute_piecewise_linear_edge_vertex_time_of_impact(
     const RigidBody& bodyA,
@@ -19,7 +26,8 @@ bool compute_piecewise_linear_edge_vertex_time_of_impact(
     double& toi,
     double earliest_toi = 1, // Only search for collision in [0, earliest_toi],
     double minimum_separation_distance = 0,
-    double toi_tolerance = Constants::RIGID_CCD_TOI_TOL);
+    double toi_tolerance = Constants::RIGID_CCD_TOI_TOL,
+    PiecewiseLinearPieces initial_pieces = PiecewiseLinearPieces::ADAPTIVE);
 
 /// Find time-of-impact between two rigid bodies
 bool compute_piecewise_linear_edge_edge_time_of_impact(
@@ -34,7 +42,8 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
     double& toi,
     double earliest_toi = 1, // Only search for collision in [0, earliest_toi],
     double minimum_separation_distance = 0,
-    double toi_tolerance = Constants::RIGID_CCD_TOI_TOL);
+    double toi_tolerance = Constants::RIGID_CCD_TOI_TOL,
+    PiecewiseLinearPieces initial_pieces = PiecewiseLinearPieces::ADAPTIVE);
 
 /// Find time-of-impact between two rigid bodies
 bool compute_piecewise_linear_face_vertex_time_of_impact(
@@ -49,6 +58,7 @@ bool compute_piecewise_linear_face_vertex_time_of_impact(
     double& toi,
     double earliest_toi = 1, // Only search for collision in [0, earliest_toi],
     double minimum_separation_distance = 0,
-    double toi_tolerance = Constants::RIGID_CCD_TOI_TOL);
+    double toi_tolerance = Constants::RIGID_CCD_TOI_TOL,
+    PiecewiseLinearPieces initial_pieces = PiecewiseLinearPieces::ADAPTIVE);
 
 } // namespace ipc::rigid
@@ -44,8 +44,8 @@ bool compute_edge_vertex_time_of_impact_redon(
         // Get the world vertex of the edges at time t
         vertex = bodyA.world_vertex(poseIA, vertex_id);
         // Get the world vertex of the edge at time t
-        edge_vertex0 = bodyB.world_vertex(poseIB, bodyB.edges(edge_id, 0));
-        edge_vertex1 = bodyB.world_vertex(poseIB, bodyB.edges(edge_id, 1));
+        edge_vertex0 = bodyB.world_vertex(poseIB, bodyB.edges()(edge_id, 0));
+        edge_vertex1 = bodyB.world_vertex(poseIB, bodyB.edges()(edge_id, 1));
     };
 
     const auto distance = [&](const Interval& t) {
@@ -107,11 +107,11 @@ bool compute_edge_edge_time_of_impact_redon(
         PoseI poseIB = PoseI::interpolate(poseIB_t0, poseIB_t1, t);
 
         // Get the world vertex of the edges at time t
-        edgeA_vertex0 = bodyA.world_vertex(poseIA, bodyA.edges(edgeA_id, 0));
-        edgeA_vertex1 = bodyA.world_vertex(poseIA, bodyA.edges(edgeA_id, 1));
+        edgeA_vertex0 = bodyA.world_vertex(poseIA, bodyA.edges()(edgeA_id, 0));
+        edgeA_vertex1 = bodyA.world_vertex(poseIA, bodyA.edges()(edgeA_id, 1));
 
-        edgeB_vertex0 = bodyB.world_vertex(poseIB, bodyB.edges(edgeB_id, 0));
-        edgeB_vertex1 = bodyB.world_vertex(poseIB, bodyB.edges(edgeB_id, 1));
+        edgeB_vertex0 = bodyB.world_vertex(poseIB, bodyB.edges()(edgeB_id, 0));
+        edgeB_vertex1 = bodyB.world_vertex(poseIB, bodyB.edges()(edgeB_id, 1));
     };
 
     const auto distance = [&](const Interval& t) {
@@ -180,9 +180,12 @@ bool compute_face_vertex_time_of_impact_redon(
             // Get the world vertex of the point at time t
             vertex = bodyA.world_vertex(poseIA, vertex_id);
             // Get the world vertex of the edge at time t
-            face_vertex0 = bodyB.world_vertex(poseIB, bodyB.faces(face_id, 0));
-            face_vertex1 = bodyB.world_vertex(poseIB, bodyB.faces(face_id, 1));
-            face_vertex2 = bodyB.world_vertex(poseIB, bodyB.faces(face_id, 2));
+            face_vertex0 =
+                bodyB.world_vertex(poseIB, bodyB.faces()(face_id, 0));
+            face_vertex1 =
+                bodyB.world_vertex(poseIB, bodyB.faces()(face_id, 1));
+            face_vertex2 =
+                bodyB.world_vertex(poseIB, bodyB.faces()(face_id, 2));
         };
 
     const auto distance = [&](const Interval& t) {
@@ -5,6 +5,7 @@
 #include <ccd/linear/broad_phase.hpp>
 #include <ccd/rigid/rigid_body_bvh.hpp>
 #include <ccd/rigid/rigid_body_hash_grid.hpp>
+#include <ccd/rigid/rigid_body_separation.hpp>
 #include <logger.hpp>
 #include <profiler.hpp>
 #include <utils/type_name.hpp>
@@ -61,6 +62,8 @@ void detect_collision_candidates_rigid_hash_grid(
 {
     std::vector<std::pair<int, int>> body_pairs =
         bodies.close_bodies(poses, poses, inflation_radius);
+    filter_separated_body_pairs(
+        bodies, poses, poses, body_pairs, inflation_radius);
 
     if (body_pairs.size() == 0) {
         return;
@@ -99,6 +102,8 @@ void detect_collision_candidates_rigid_bvh(
 {
     std::vector<std::pair<int, int>> body_pairs =
         bodies.close_bodies(poses, poses, inflation_radius);
+    filter_separated_body_pairs(
+        bodies, poses, poses, body_pairs, inflation_radius);
 
     // Use interval arithmetic to conservativly capture all distance candidates
     auto posesI = cast<Interval>(poses);
@@ -173,6 +178,8 @@ void detect_collision_candidates_rigid_hash_grid(
 {
     std::vector<std::pair<int, int>> body_pairs =
         bodies.close_bodies(poses_t0, poses_t1, inflation_radius);
+    filter_separated_body_pairs(
+        bodies, poses_t0, poses_t1, body_pairs, inflation_radius);
 
     if (body_pairs.size() == 0) {
         return;
@@ -213,6 +220,8 @@ void detect_collision_candidates_rigid_bvh(
 {
     std::vector<std::pair<int, int>> body_pairs =
         bodies.close_bodies(poses_t0, poses_t1, inflation_radius);
+    filter_separated_body_pairs(
+        bodies, poses_t0, poses_t1, body_pairs, inflation_radius);
 
     Poses<Interval> poses = interpolate(
         cast<Interval>(poses_t0), cast<Interval>(poses_t1), Interval(0, 1));
@@ -270,6 +279,7 @@ void detect_intersection_candidates_rigid_bvh(
 {
     std::vector<std::pair<int, int>> body_pairs =
         bodies.close_bodies(poses, poses, /*inflation_radius=*/0);
+    filter_separated_body_pairs(bodies, poses, poses, body_pairs);
 
     auto posesI = cast<Interval>(poses);
 
@@ -289,7 +299,7 @@ void detect_intersection_candidates_rigid_bvh(
                 const auto& pA = poses[bodyA_id].position;
                 const auto& pB = poses[bodyB_id].position;
                 const MatrixXI VA =
-                    ((bodies[bodyA_id].vertices * RA.transpose()).rowwise()
+                    ((bodies[bodyA_id].vertices() * RA.transpose()).rowwise()
                      + (pA - pB).transpose())
                     * RB;
 
@@ -8,6 +8,8 @@
 #include <ccd/ccd.hpp>
 #include <interval/interval.hpp>
 #include <physics/rigid_body_assembler.hpp>
+#include <profiler.hpp>
+#include <utils/type_name.hpp>
 
 namespace ipc::rigid {
 
@@ -74,19 +76,19 @@ inline void detect_body_pair_collision_candidates_bvh(
 
     // Compute the smaller body's vertices in the larger body's local
     // coordinates.
-    // PROFILE_POINT(fmt::format(
-    //     "detect_body_pair_collision_candidates_bvh<{}>:compute_vertices",
-    //     get_type_name<T>()));
-    // PROFILE_START();
+    PROFILE_POINT(fmt::format(
+        "detect_body_pair_collision_candidates_bvh<{}>:compute_vertices",
+        get_type_name<T>()));
+    PROFILE_START();
     const auto RA = poses[bodyA_id].construct_rotation_matrix();
     const auto RB = poses[bodyB_id].construct_rotation_matrix();
     const auto& pA = poses[bodyA_id].position;
     const auto& pB = poses[bodyB_id].position;
     const MatrixX<T> VA =
-        ((bodies[bodyA_id].vertices * RA.transpose()).rowwise()
+        ((bodies[bodyA_id].vertices() * RA.transpose()).rowwise()
          + (pA - pB).transpose())
         * RB;
-    // PROFILE_END();
+    PROFILE_END();
 
     detect_body_pair_collision_candidates_from_aabbs(
         bodies, vertex_aabbs(VA, inflation_radius), bodyA_id, bodyB_id,
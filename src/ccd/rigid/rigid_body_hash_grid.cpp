@@ -139,7 +139,7 @@ void RigidBodyHashGrid::addBodies(
                 }
             },
             [&]() {
-                const Eigen::MatrixXi& E = bodies[id].edges;
+                const Eigen::MatrixXi& E = bodies[id].edges();
                 long e0i = bodies.m_body_edge_id[id];
                 for (int i = 0; i < E.rows(); i++) {
                     this->addEdge(
@@ -149,7 +149,7 @@ void RigidBodyHashGrid::addBodies(
                 }
             },
             [&]() {
-                const Eigen::MatrixXi& F = bodies[id].faces;
+                const Eigen::MatrixXi& F = bodies[id].faces();
                 long f0i = bodies.m_body_face_id[id];
                 for (int i = 0; i < F.rows(); i++) {
                     this->addFace(
@@ -214,7 +214,7 @@ int RigidBodyHashGrid::compute_vertices_intervals(
             return 0;
         }
     } else {
-        vertices.resizeLike(body.vertices);
+        vertices.resizeLike(body.vertices());
     }
 
     force_subdivision--;
@@ -0,0 +1,308 @@
+#include "rigid_body_separation.hpp"
+
+#include <limits>
+
+#include <tbb/parallel_for.h>
+
+#include <ipc/distance/edge_edge.hpp>
+#include <ipc/distance/point_triangle.hpp>
+#include <ipc/ipc.hpp>
+
+#include <logger.hpp>
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+// Relative tolerance for the convergence of the GJK iterations.
+static const double GJK_CONVERGENCE_TOL = 1e-6;
+// Relative padding to account for rounding in the separation test.
+static const double SEPARATION_PADDING = 1e-8;
+// Estimate of the rounding error of the squared distances in the narrow-phase
+// filters relative to the squared magnitude M of the coordinates. Rounding
+// the world vertices (R v + p) moves them by about 8 ε M, which changes a
+// squared distance (at most (2M)²) by about 4 × 2M × 8 ε M = 64 ε M², and the
+// distance formulas add about 64 ε (2M)² on the differences. This is padded
+// to 4096 ε (≈ 9e-13). It is not a rigorous bound for nearly degenerate
+// primitives, as the distance formulas divide by their squared lengths.
+static const double FILTER_SQUARED_DISTANCE_ERROR =
+    4096 * std::numeric_limits<double>::epsilon();
+
+// Point of the body's convex hull (in world coordinates) that minimizes the
+// dot product with dir.
+static VectorMax3d hull_support(
+    const RigidBody& body,
+    const MatrixMax3d& R,
+    const VectorMax3d& p,
+    const VectorMax3d& dir)
+{
+    const VectorMax3d local_dir = R.transpose() * dir;
+    Eigen::Index vi;
+    (body.vertices() * local_dir).minCoeff(&vi);
+    return R * body.vertices().row(vi).transpose() + p;
+}
+
+double body_hulls_distance_lower_bound(
+    const RigidBody& bodyA,
+    const PoseD& poseA,
+    const RigidBody& bodyB,
+    const PoseD& poseB,
+    const double threshold,
+    const int max_iterations)
+{
+    const MatrixMax3d RA = poseA.construct_rotation_matrix();
+    const MatrixMax3d RB = poseB.construct_rotation_matrix();
+
+    // Point of the Minkowski difference A - B that minimizes the dot product
+    // with dir.
+    const auto support = [&](const VectorMax3d& dir) -> VectorMax3d {
+        return hull_support(bodyA, RA, poseA.position, dir)
+            - hull_support(bodyB, RB, poseB.position, -dir);
+    };
+
+    VectorMax3d x = poseA.position - poseB.position;
+    if (x.squaredNorm() == 0) {
+        x.setZero();
+        x(0) = 1;
+    }
+    x = support(x);
+
+    double lower_bound = 0;
+    for (int i = 0; i < max_iterations; i++) {
+        const double x_norm = x.norm();
+        // The closest point is within threshold, so the hulls may be too
+        if (x_norm <= threshold || x_norm == 0) {
+            break;
+        }
+
+        // Every support plane of A - B gives a lower bound on the distance
+        const VectorMax3d s = support(x);
+        lower_bound = std::max(lower_bound, x.dot(s) / x_norm);
+        if (lower_bound > threshold) {
+            break;
+        }
+
+        const VectorMax3d x_minus_s = x - s;
+        const double x_dot_x_minus_s = x.dot(x_minus_s);
+        if (x_dot_x_minus_s <= GJK_CONVERGENCE_TOL * x_norm * x_norm) {
+            break; // Converged
+        }
+
+        // Move to the closest point to the origin on the segment [x, s]
+        x -= std::min(x_dot_x_minus_s / x_minus_s.squaredNorm(), 1.0)
+            * x_minus_s;
+    }
+
+    return lower_bound;
+}
+
+double body_max_displacement(
+    const RigidBody& body, const PoseD& pose_t0, const PoseD& pose_t1)
+{
+    // The rotation vector is interpolated linearly and the exponential map is
+    // 1-Lipschitz, so the angle swept is at most ‖Δθ‖. Each point moves at
+    // most the chord of that angle, bounded by r_max ‖Δθ‖ and 2 r_max.
+    const double rotation_change =
+        (pose_t1.rotation - pose_t0.rotation).norm();
+    return (pose_t1.position - pose_t0.position).norm()
+        + body.r_max() * std::min(rotation_change, 2.0);
+}
+
+bool are_body_hulls_separated(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const int bodyA_id,
+    const int bodyB_id,
+    const double inflation_radius)
+{
+    const RigidBody& bodyA = bodies[bodyA_id];
+    const RigidBody& bodyB = bodies[bodyB_id];
+
+    // Both bodies are inflated by the inflation radius
+    double margin = 2 * inflation_radius
+        + body_max_displacement(bodyA, poses_t0[bodyA_id], poses_t1[bodyA_id])
+        + body_max_displacement(bodyB, poses_t0[bodyB_id], poses_t1[bodyB_id]);
+    margin += SEPARATION_PADDING * (margin + bodyA.r_max() + bodyB.r_max());
+
+    return body_hulls_distance_lower_bound(
+               bodyA, poses_t0[bodyA_id], bodyB, poses_t0[bodyB_id], margin)
+        > margin;
+}
+
+void filter_separated_body_pairs(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    std::vector<std::pair<int, int>>& body_pairs,
+    const double inflation_radius)
+{
+    if (body_pairs.empty()) {
+        return;
+    }
+
+    NAMED_PROFILE_POINT("filter_separated_body_pairs", FILTER);
+    PROFILE_START(FILTER);
+
+    std::vector<char> is_separated(body_pairs.size(), false);
+    tbb::parallel_for(size_t(0), body_pairs.size(), [&](size_t i) {
+        is_separated[i] = are_body_hulls_separated(
+            bodies, poses_t0, poses_t1, body_pairs[i].first,
+            body_pairs[i].second, inflation_radius);
+    });
+
+    size_t num_kept = 0;
+    for (size_t i = 0; i < body_pairs.size(); i++) {
+        if (!is_separated[i]) {
+            body_pairs[num_kept++] = body_pairs[i];
+        }
+    }
+
+    PROFILE_MESSAGE(
+        FILTER, "num_separated_pairs",
+        fmt::format("{:d}", body_pairs.size() - num_kept));
+
+    body_pairs.resize(num_kept);
+
+    PROFILE_END(FILTER);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Narrow-phase filters
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+    /// Primitive vertices of one body at t=0 and a bound on their motion.
+    class PrimitiveTrajectoryBound {
+    public:
+        PrimitiveTrajectoryBound(
+            const RigidBody& body,
+            const PoseD& pose_t0,
+            const PoseD& pose_t1,
+            double earliest_toi)
+            : body(body)
+            , pose_t0(pose_t0)
+            , R_t0(pose_t0.construct_rotation_matrix())
+            , translation(
+                  earliest_toi * (pose_t1.position - pose_t0.position).norm())
+            , rotation(std::min(
+                  earliest_toi * (pose_t1.rotation - pose_t0.rotation).norm(),
+                  2.0))
+            , max_displacement(0)
+            , max_magnitude(0)
+        {
+        }
+
+        /// World vertex at t=0 (also updates the bounds).
+        VectorMax3d vertex(long vi)
+        {
+            // The motion is affine in the body-local point, so the vertices
+            // bound the displacement of the whole primitive.
+            const double r = body.vertices().row(vi).norm();
+            max_displacement =
+                std::max(max_displacement, translation + r * rotation);
+            VectorMax3d v = R_t0 * body.vertices().row(vi).transpose()
+                + pose_t0.position;
+            max_magnitude =
+                std::max(max_magnitude, v.lpNorm<Eigen::Infinity>());
+            return v;
+        }
+
+    private:
+        const RigidBody& body;
+        const PoseD& pose_t0;
+        const MatrixMax3d R_t0;
+        const double translation; ///< Distance traveled by the center of mass
+        const double rotation; ///< Bound on the chord of a unit radius point
+
+    public:
+        double max_displacement; ///< Maximum displacement of the vertices
+        double max_magnitude; ///< Maximum absolute coordinate of the vertices
+    };
+
+    // Compare the squared distance at t=0 to the maximum relative motion.
+    bool is_trajectory_separated(
+        double distance_sqr,
+        const PrimitiveTrajectoryBound& boundA,
+        const PrimitiveTrajectoryBound& boundB,
+        double minimum_separation_distance)
+    {
+        const double margin = boundA.max_displacement
+            + boundB.max_displacement + minimum_separation_distance;
+        const double magnitude =
+            std::max(boundA.max_magnitude, boundB.max_magnitude) + margin;
+        const double error =
+            FILTER_SQUARED_DISTANCE_ERROR * magnitude * magnitude;
+        return distance_sqr - error
+            > margin * margin * (1 + SEPARATION_PADDING);
+    }
+} // namespace
+
+bool is_edge_vertex_trajectory_separated(
+    const RigidBody& bodyA,
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long vertex_id,
+    const RigidBody& bodyB,
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long edge_id,
+    double earliest_toi,
+    double minimum_separation_distance)
+{
+    PrimitiveTrajectoryBound boundA(bodyA, poseA_t0, poseA_t1, earliest_toi);
+    PrimitiveTrajectoryBound boundB(bodyB, poseB_t0, poseB_t1, earliest_toi);
+    const VectorMax3d v = boundA.vertex(vertex_id);
+    const VectorMax3d e0 = boundB.vertex(bodyB.edges()(edge_id, 0));
+    const VectorMax3d e1 = boundB.vertex(bodyB.edges()(edge_id, 1));
+    return is_trajectory_separated(
+        point_edge_distance(v, e0, e1), boundA, boundB,
+        minimum_separation_distance);
+}
+
+bool is_edge_edge_trajectory_separated(
+    const RigidBody& bodyA,
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long edgeA_id,
+    const RigidBody& bodyB,
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long edgeB_id,
+    double earliest_toi,
+    double minimum_separation_distance)
+{
+    PrimitiveTrajectoryBound boundA(bodyA, poseA_t0, poseA_t1, earliest_toi);
+    PrimitiveTrajectoryBound boundB(bodyB, poseB_t0, poseB_t1, earliest_toi);
+    const Eigen::Vector3d ea0 = boundA.vertex(bodyA.edges()(edgeA_id, 0));
+    const Eigen::Vector3d ea1 = boundA.vertex(bodyA.edges()(edgeA_id, 1));
+    const Eigen::Vector3d eb0 = boundB.vertex(bodyB.edges()(edgeB_id, 0));
+    const Eigen::Vector3d eb1 = boundB.vertex(bodyB.edges()(edgeB_id, 1));
+    return is_trajectory_separated(
+        edge_edge_distance(ea0, ea1, eb0, eb1), boundA, boundB,
+        minimum_separation_distance);
+}
+
+bool is_face_vertex_trajectory_separated(
+    const RigidBody& bodyA,
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long vertex_id,
+    const RigidBody& bodyB,
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long face_id,
+    double earliest_toi,
+    double minimum_separation_distance)
+{
+    PrimitiveTrajectoryBound boundA(bodyA, poseA_t0, poseA_t1, earliest_toi);
+    PrimitiveTrajectoryBound boundB(bodyB, poseB_t0, poseB_t1, earliest_toi);
+    const Eigen::Vector3d v = boundA.vertex(vertex_id);
+    const Eigen::Vector3d f0 = boundB.vertex(bodyB.faces()(face_id, 0));
+    const Eigen::Vector3d f1 = boundB.vertex(bodyB.faces()(face_id, 1));
+    const Eigen::Vector3d f2 = boundB.vertex(bodyB.faces()(face_id, 2));
+    return is_trajectory_separated(
+        point_triangle_distance(v, f0, f1, f2), boundA, boundB,
+        minimum_separation_distance);
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+
+#include <physics/pose.hpp>
+#include <physics/rigid_body.hpp>
+#include <physics/rigid_body_assembler.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Compute a conservative lower bound on the distance between the
+/// convex hulls of two bodies at the given poses.
+///
+/// Uses a GJK-style (Gilbert) iteration on the Minkowski difference of the
+/// hulls. Every iterate provides a valid lower bound, so the iteration can
+/// stop as soon as the bound exceeds threshold (separated) or the upper bound
+/// falls below it (possibly touching).
+///
+/// @param threshold Distance to test the separation against.
+/// @return A lower bound on the hull distance (zero if they may overlap).
+double body_hulls_distance_lower_bound(
+    const RigidBody& bodyA,
+    const PoseD& poseA,
+    const RigidBody& bodyB,
+    const PoseD& poseB,
+    const double threshold,
+    const int max_iterations = 32);
+
+/// @brief Upper bound on how far any point of the body moves over the
+/// linearly interpolated trajectory from pose_t0 to pose_t1.
+double body_max_displacement(
+    const RigidBody& body, const PoseD& pose_t0, const PoseD& pose_t1);
+
+/// @brief Determine if the convex hulls of two bodies stay farther apart than
+/// inflation_radius for the entire trajectory.
+bool are_body_hulls_separated(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const int bodyA_id,
+    const int bodyB_id,
+    const double inflation_radius = 0.0);
+
+/// @brief Remove the body pairs whose convex hulls are separated for the
+/// entire trajectory.
+void filter_separated_body_pairs(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    std::vector<std::pair<int, int>>& body_pairs,
+    const double inflation_radius = 0.0);
+
+///////////////////////////////////////////////////////////////////////////////
+// Narrow-phase filters
+//
+// Cheap double-precision tests that reject candidates whose primitives stay
+// farther apart than the minimum separation distance for t ∈ [0,
+// earliest_toi]. They bound the motion of each primitive by a ball around its
+// position at t=0 and pad the comparison by an estimate of the rounding error
+// relative to the magnitude of the coordinates, so only ambiguous candidates
+// need the exact (interval) CCD.
+///////////////////////////////////////////////////////////////////////////////
+
+/// @brief Determine if an edge-vertex candidate can be rejected without CCD.
+bool is_edge_vertex_trajectory_separated(
+    const RigidBody& bodyA, // Body of the vertex
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long vertex_id,
+    const RigidBody& bodyB, // Body of the edge
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long edge_id,
+    double earliest_toi = 1,
+    double minimum_separation_distance = 0);
+
+/// @brief Determine if an edge-edge candidate can be rejected without CCD.
+bool is_edge_edge_trajectory_separated(
+    const RigidBody& bodyA, // Body of the first edge
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long edgeA_id,
+    const RigidBody& bodyB, // Body of the second edge
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long edgeB_id,
+    double earliest_toi = 1,
+    double minimum_separation_distance = 0);
+
+/// @brief Determine if a face-vertex candidate can be rejected without CCD.
+bool is_face_vertex_trajectory_separated(
+    const RigidBody& bodyA, // Body of the vertex
+    const PoseD& poseA_t0,
+    const PoseD& poseA_t1,
+    long vertex_id,
+    const RigidBody& bodyB, // Body of the face
+    const PoseD& poseB_t0,
+    const PoseD& poseB_t1,
+    long face_id,
+    double earliest_toi = 1,
+    double minimum_separation_distance = 0);
+
+} // namespace ipc::rigid
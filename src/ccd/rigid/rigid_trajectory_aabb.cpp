@@ -28,8 +28,8 @@ VectorMax3I edge_trajectory_aabb(
     // Compute the pose at time t
     PoseI pose = PoseI::interpolate(pose_t0, pose_t1, t);
     // Get the world vertex of the edges at time t
-    VectorMax3I e0 = body.world_vertex(pose, body.edges(edge_id, 0));
-    VectorMax3I e1 = body.world_vertex(pose, body.edges(edge_id, 1));
+    VectorMax3I e0 = body.world_vertex(pose, body.edges()(edge_id, 0));
+    VectorMax3I e1 = body.world_vertex(pose, body.edges()(edge_id, 1));
     return (e1 - e0) * alpha + e0;
 }
 
@@ -45,9 +45,9 @@ VectorMax3I face_trajectory_aabb(
     // Compute the pose at time t
     PoseI pose = PoseI::interpolate(pose_t0, pose_t1, t);
     // Get the world vertex of the edges at time t
-    VectorMax3I f0 = body.world_vertex(pose, body.faces(face_id, 0));
-    VectorMax3I f1 = body.world_vertex(pose, body.faces(face_id, 1));
-    VectorMax3I f2 = body.world_vertex(pose, body.faces(face_id, 2));
+    VectorMax3I f0 = body.world_vertex(pose, body.faces()(face_id, 0));
+    VectorMax3I f1 = body.world_vertex(pose, body.faces()(face_id, 1));
+    VectorMax3I f2 = body.world_vertex(pose, body.faces()(face_id, 2));
     return (f1 - f0) * u + (f2 - f0) * v + f0;
 }
 
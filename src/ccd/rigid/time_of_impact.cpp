@@ -116,17 +116,17 @@ void print_EE_query(
     size_t edgeB_id)              // In bodyB
 {
 
-    std::cerr << fmt_eigen(bodyA.vertices.row(bodyA.edges(edgeA_id, 0)))
+    std::cerr << fmt_eigen(bodyA.vertices().row(bodyA.edges()(edgeA_id, 0)))
               << std::endl;
-    std::cerr << fmt_eigen(bodyA.vertices.row(bodyA.edges(edgeA_id, 1)))
+    std::cerr << fmt_eigen(bodyA.vertices().row(bodyA.edges()(edgeA_id, 1)))
               << std::endl;
     std::cerr << fmt_eigen(poseA_t0.position) << std::endl;
     std::cerr << fmt_eigen(poseA_t0.rotation) << std::endl;
     std::cerr << fmt_eigen(poseA_t1.position) << std::endl;
     std::cerr << fmt_eigen(poseA_t1.rotation) << std::endl;
-    std::cerr << fmt_eigen(bodyB.vertices.row(bodyB.edges(edgeB_id, 0)))
+    std::cerr << fmt_eigen(bodyB.vertices().row(bodyB.edges()(edgeB_id, 0)))
               << std::endl;
-    std::cerr << fmt_eigen(bodyB.vertices.row(bodyB.edges(edgeB_id, 1)))
+    std::cerr << fmt_eigen(bodyB.vertices().row(bodyB.edges()(edgeB_id, 1)))
               << std::endl;
     std::cerr << fmt_eigen(poseB_t0.position) << std::endl;
     std::cerr << fmt_eigen(poseB_t0.rotation) << std::endl;
@@ -234,8 +234,8 @@ Eigen::Vector3d compute_face_vertex_tolerance(
 
     // (f1 - f0) * u + (f2 - f0) * v + f0
     // u interpolates edge (f0, f1) and v interpolates edge (f1, f2)
-    size_t edge0_id = bodyB.mesh_selector.face_to_edge(face_id, 0);
-    size_t edge1_id = bodyB.mesh_selector.face_to_edge(face_id, 1);
+    size_t edge0_id = bodyB.mesh_selector().face_to_edge(face_id, 0);
+    size_t edge1_id = bodyB.mesh_selector().face_to_edge(face_id, 1);
 
     return Eigen::Vector3d(
         // Constants::RIGID_CCD_TOI_TOL / dl,
@@ -44,6 +44,12 @@ namespace Constants {
     /// \brief Scaling of κ_min to better condition the system
     static const double DEFAULT_MIN_BARRIER_STIFFNESS_SCALE = 1e11;
 
+    /// \brief Largest displacement of a body's vertices (relative to d̂) for
+    /// which its lagged friction constraints are reused. The lagged normal
+    /// forces and tangent bases change to first order with the displacement,
+    /// so this is far below the error of lagging them over a Newton step.
+    static const double FRICTION_CONSTRAINT_REUSE_TOL = 1e-10;
+
     // static const int MAXIMUM_FRICTION_ITERATIONS = 100;
 
     // ------------------------------------------------------------------------
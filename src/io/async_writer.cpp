@@ -0,0 +1,87 @@
+#include "async_writer.hpp"
+
+#include <algorithm>
+#include <exception>
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+AsyncWriter::AsyncWriter(size_t max_queued_tasks)
+    : m_max_queued_tasks(std::max(max_queued_tasks, size_t(1)))
+{
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stopping = true;
+    }
+    m_task_pushed.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+size_t AsyncWriter::push(std::function<bool()> task)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&AsyncWriter::run, this);
+    }
+    m_task_finished.wait(
+        lock, [&] { return m_tasks.size() < m_max_queued_tasks; });
+    m_tasks.push_back(std::move(task));
+    const size_t task_id = ++m_num_pushed;
+    lock.unlock();
+    m_task_pushed.notify_one();
+    return task_id;
+}
+
+bool AsyncWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task_finished.wait(lock, [&] { return m_num_finished == m_num_pushed; });
+    bool success = !m_has_failed;
+    m_has_failed = false;
+    return success;
+}
+
+bool AsyncWriter::wait_for(size_t task_id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task_finished.wait(lock, [&] { return m_num_finished >= task_id; });
+    return !m_has_failed;
+}
+
+void AsyncWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_task_pushed.wait(
+            lock, [&] { return m_is_stopping || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+            return; // Stopping and every task is done
+        }
+
+        std::function<bool()> task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock();
+
+        bool success;
+        try {
+            success = task();
+        } catch (const std::exception& e) {
+            spdlog::error("Asynchronous write failed: {}", e.what());
+            success = false;
+        }
+
+        lock.lock();
+        m_num_finished++;
+        m_has_failed |= !success;
+        m_task_finished.notify_all();
+    }
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Run file writes on a background thread in the order they are queued.
+ *
+ * Every task owns a snapshot of the data it writes (moved in by the caller),
+ * so the simulation can continue while the data is encoded and written. The
+ * queue is bounded: when the file system falls behind, push() waits instead
+ * of buffering an unbounded number of snapshots.
+ */
+class AsyncWriter {
+public:
+    explicit AsyncWriter(size_t max_queued_tasks = 8);
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+    /// Finishes the queued tasks.
+    ~AsyncWriter();
+
+    /// @brief Queue a write (waits while the queue is full).
+    /// @param task Writes its data and returns false if the write failed.
+    /// @return Id of the task for wait_for().
+    size_t push(std::function<bool()> task);
+
+    /// @brief Wait for the queued writes to finish.
+    /// @return False if a write failed since the last wait.
+    bool wait();
+
+    /// @brief Wait for a task and the ones queued before it to finish.
+    /// @return False if a write failed since the last wait().
+    bool wait_for(size_t task_id);
+
+protected:
+    /// Body of the writer thread.
+    void run();
+
+    const size_t m_max_queued_tasks;
+    std::deque<std::function<bool()>> m_tasks;
+    size_t m_num_pushed = 0;   ///< Number of tasks queued so far
+    size_t m_num_finished = 0; ///< Number of tasks finished so far
+    bool m_has_failed = false; ///< Did a task fail since the last wait?
+    bool m_is_stopping = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_task_pushed;   ///< Wakes the thread
+    std::condition_variable m_task_finished; ///< Wakes push() and wait()
+    std::thread m_thread; ///< Started by the first push()
+};
+
+} // namespace ipc::rigid
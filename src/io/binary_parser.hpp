@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+namespace ipc::rigid {
+
+/// @brief Append the bytes of a trivially copyable value.
+template <typename T> void append(std::vector<char>& data, const T& value)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+/// @brief Append the bytes of an array of values.
+template <typename T>
+void append(std::vector<char>& data, const T* values, size_t n)
+{
+    const char* bytes = reinterpret_cast<const char*>(values);
+    data.insert(data.end(), bytes, bytes + n * sizeof(T));
+}
+
+/// @brief Reads the values of a binary buffer in order and fails on any read
+/// past the end.
+class BinaryParser {
+public:
+    BinaryParser(const char* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    bool read(void* value, size_t num_bytes)
+    {
+        if (m_failed || num_bytes > m_size - m_offset) {
+            m_failed = true;
+            return false;
+        }
+        std::memcpy(value, m_data + m_offset, num_bytes);
+        m_offset += num_bytes;
+        return true;
+    }
+
+    bool skip(size_t num_bytes)
+    {
+        if (m_failed || num_bytes > m_size - m_offset) {
+            m_failed = true;
+            return false;
+        }
+        m_offset += num_bytes;
+        return true;
+    }
+
+    template <typename T> T read()
+    {
+        T value = T();
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    const char* position() const { return m_data + m_offset; }
+    size_t offset() const { return m_offset; }
+    size_t remaining() const { return m_size - m_offset; }
+    bool failed() const { return m_failed; }
+
+protected:
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+} // namespace ipc::rigid
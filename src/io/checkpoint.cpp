@@ -0,0 +1,188 @@
+#include "checkpoint.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/binary_parser.hpp>
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+static const char CHECKPOINT_MAGIC[8] = { 'R', 'I', 'P', 'C',
+                                          'C', 'K', 'P', 'T' };
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+// Encoding
+
+static void append_pose(std::vector<char>& data, const PoseD& pose)
+{
+    VectorMax6d dof = pose.dof();
+    append(data, dof.data(), dof.size());
+}
+
+static PoseD read_pose(BinaryParser& parser, int ndof)
+{
+    VectorMax6d dof = VectorMax6d::Zero(ndof);
+    parser.read(dof.data(), ndof * sizeof(double));
+    return PoseD(dof);
+}
+
+std::vector<char> serialize_checkpoint(const Checkpoint& checkpoint)
+{
+    const std::string args_str = checkpoint.args.dump();
+    const int ndof = PoseD::dim_to_ndof(checkpoint.dim);
+
+    std::vector<char> state;
+    for (const RigidBodyCheckpoint& body : checkpoint.bodies) {
+        append(state, int32_t(body.type));
+        for (int i = 0; i < ndof; i++) {
+            append(state, uint8_t(body.is_dof_fixed[i]));
+        }
+        append_pose(state, body.pose);
+        append_pose(state, body.pose_prev);
+        append_pose(state, body.velocity);
+        append_pose(state, body.velocity_prev);
+        append_pose(state, body.acceleration);
+        append_pose(state, body.force);
+        append(state, body.Qdot.data(), body.Qdot.size());
+        append(state, body.Qddot.data(), body.Qddot.size());
+        append(state, body.kinematic_max_time);
+        append(state, uint64_t(body.kinematic_poses.size()));
+        for (const PoseD& pose : body.kinematic_poses) {
+            append_pose(state, pose);
+        }
+    }
+
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(CheckpointHeader));
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.dim = checkpoint.dim;
+    header.num_bodies = checkpoint.bodies.size();
+    header.num_steps = checkpoint.num_steps;
+    header.timestep = checkpoint.timestep;
+    header.barrier_stiffness = checkpoint.barrier_stiffness;
+    header.args_size = args_str.size();
+    header.state_size = state.size();
+
+    std::vector<char> data;
+    data.reserve(sizeof(CheckpointHeader) + args_str.size() + state.size());
+    append(data, header);
+    data.insert(data.end(), args_str.begin(), args_str.end());
+    data.insert(data.end(), state.begin(), state.end());
+
+    return data;
+}
+
+bool deserialize_checkpoint(
+    const char* data, size_t size, Checkpoint& checkpoint)
+{
+    BinaryParser parser(data, size);
+    const CheckpointHeader header = parser.read<CheckpointHeader>();
+    if (parser.failed()
+        || std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic))
+            != 0
+        || header.version != CHECKPOINT_VERSION
+        || (header.dim != 2 && header.dim != 3)
+        || header.num_bodies > size // At least one byte per body
+        || header.args_size > size - sizeof(CheckpointHeader)
+        || header.state_size
+            != size - sizeof(CheckpointHeader) - header.args_size) {
+        return false;
+    }
+
+    checkpoint.args = nlohmann::json::parse(
+        parser.position(), parser.position() + header.args_size, nullptr,
+        false);
+    if (checkpoint.args.is_discarded()) {
+        return false;
+    }
+    parser.skip(header.args_size);
+
+    checkpoint.dim = header.dim;
+    checkpoint.num_steps = header.num_steps;
+    checkpoint.timestep = header.timestep;
+    checkpoint.barrier_stiffness = header.barrier_stiffness;
+
+    const int ndof = PoseD::dim_to_ndof(header.dim);
+    checkpoint.bodies.resize(header.num_bodies);
+    for (RigidBodyCheckpoint& body : checkpoint.bodies) {
+        body.type = parser.read<int32_t>();
+        body.is_dof_fixed.resize(ndof);
+        for (int i = 0; i < ndof; i++) {
+            body.is_dof_fixed[i] = parser.read<uint8_t>() != 0;
+        }
+        body.pose = read_pose(parser, ndof);
+        body.pose_prev = read_pose(parser, ndof);
+        body.velocity = read_pose(parser, ndof);
+        body.velocity_prev = read_pose(parser, ndof);
+        body.acceleration = read_pose(parser, ndof);
+        body.force = read_pose(parser, ndof);
+        parser.read(body.Qdot.data(), body.Qdot.size() * sizeof(double));
+        parser.read(body.Qddot.data(), body.Qddot.size() * sizeof(double));
+        body.kinematic_max_time = parser.read<double>();
+        const uint64_t num_kinematic_poses = parser.read<uint64_t>();
+        if (parser.failed()
+            || num_kinematic_poses > (size - parser.offset()) / ndof) {
+            return false;
+        }
+        body.kinematic_poses.clear();
+        for (uint64_t i = 0; i < num_kinematic_poses; i++) {
+            body.kinematic_poses.push_back(read_pose(parser, ndof));
+        }
+    }
+
+    return !parser.failed() && parser.offset() == size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Files
+
+bool write_checkpoint(
+    const std::string& filename, const Checkpoint& checkpoint)
+{
+    const std::vector<char> data = serialize_checkpoint(checkpoint);
+
+    // Write to a temporary file first so an interrupted write does not
+    // replace the last good checkpoint.
+    const std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), data.size()) || !file.flush()) {
+            spdlog::error("Unable to write checkpoint file: {}", filename);
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(tmp_filename, filename, error);
+    if (error) {
+        spdlog::error(
+            "Unable to write checkpoint file: {} ({})", filename,
+            error.message());
+        return false;
+    }
+    return true;
+}
+
+bool read_checkpoint(const std::string& filename, Checkpoint& checkpoint)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        spdlog::error("Unable to open checkpoint file: {}", filename);
+        return false;
+    }
+    const std::vector<char> data(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    if (!deserialize_checkpoint(data.data(), data.size(), checkpoint)) {
+        spdlog::error("Invalid checkpoint file: {}", filename);
+        return false;
+    }
+    return true;
+}
+
+} // namespace ipc::rigid
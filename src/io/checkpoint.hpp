@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <physics/pose.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Header of a binary checkpoint file (.ckpt).
+ *
+ * The header is followed by the JSON arguments of the simulation and the
+ * state of each body. Unlike a saved simulation, a checkpoint only holds the
+ * current state, so its size does not grow with the number of time-steps.
+ */
+struct CheckpointHeader {
+    char magic[8];            ///< "RIPCCKPT"
+    uint32_t version;         ///< Version of the format
+    uint32_t dim;             ///< Dimension of the scene (2 or 3)
+    uint64_t num_bodies;      ///< Number of bodies
+    uint64_t num_steps;       ///< Number of time-steps taken
+    double timestep;          ///< Timestep of the simulation
+    double barrier_stiffness; ///< κ at the end of the last step (or NaN)
+    uint64_t args_size;       ///< Bytes of the JSON arguments
+    uint64_t state_size;      ///< Bytes of the body states
+};
+static_assert(sizeof(CheckpointHeader) == 64);
+
+/// @brief State of a rigid body needed to continue a simulation.
+struct RigidBodyCheckpoint {
+    int type;                 ///< RigidBodyType of the body
+    VectorMax6b is_dof_fixed; ///< Fixed dof (kinematic bodies become static)
+    PoseD pose, pose_prev;
+    PoseD velocity, velocity_prev;
+    PoseD acceleration;
+    PoseD force;
+    Eigen::Matrix3d Qdot, Qddot;
+    double kinematic_max_time;
+    std::deque<PoseD> kinematic_poses;
+};
+
+/// @brief Solver-relevant state of a simulation after a time-step.
+///
+/// Everything else (e.g., the friction constraints) is rebuilt identically
+/// from this state at the start of the next step.
+struct Checkpoint {
+    nlohmann::json args; ///< Arguments to initialize the scene with
+    int dim;
+    size_t num_steps;
+    double timestep;
+    double barrier_stiffness;
+    std::vector<RigidBodyCheckpoint> bodies;
+};
+
+/// @brief Encode a checkpoint in the binary format.
+std::vector<char> serialize_checkpoint(const Checkpoint& checkpoint);
+
+/// @brief Decode a checkpoint in the binary format.
+/// @return False if the data is not a valid checkpoint.
+bool deserialize_checkpoint(
+    const char* data, size_t size, Checkpoint& checkpoint);
+
+/// @brief Write a checkpoint file (replaced only once it is complete).
+bool write_checkpoint(
+    const std::string& filename, const Checkpoint& checkpoint);
+
+/// @brief Read a checkpoint file.
+bool read_checkpoint(const std::string& filename, Checkpoint& checkpoint);
+
+} // namespace ipc::rigid
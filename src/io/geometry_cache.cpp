@@ -0,0 +1,364 @@
+#include "geometry_cache.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/binary_parser.hpp>
+#include <io/mapped_file.hpp>
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+static const char GEOMETRY_CACHE_MAGIC[8] = { 'R', 'I', 'P', 'C',
+                                              'G', 'E', 'O', 'M' };
+// NOTE: Increase the version when the processing of the geometries changes,
+// so stale records are ignored.
+static const uint32_t GEOMETRY_CACHE_VERSION = 1;
+
+static std::string& cache_directory()
+{
+    static std::string directory = []() {
+        const char* env_directory = std::getenv("RIGID_IPC_GEOMETRY_CACHE");
+        return std::string(env_directory == nullptr ? "" : env_directory);
+    }();
+    return directory;
+}
+
+const std::string& geometry_cache_directory() { return cache_directory(); }
+
+void set_geometry_cache_directory(const std::string& directory)
+{
+    cache_directory() = directory;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Hashing
+
+static inline uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t hash_file_content(const char* data, size_t size)
+{
+    // Hash eight bytes at a time, the mesh files can be large.
+    const uint64_t prime = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = mix(size ^ prime);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(uint64_t));
+        h = (h ^ mix(word)) * prime;
+    }
+    if (i < size) {
+        uint64_t tail = 0;
+        std::memcpy(&tail, data + i, size - i);
+        h = (h ^ mix(tail)) * prime;
+    }
+    return mix(h);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Encoding
+
+static void pad(std::vector<char>& data)
+{
+    data.resize(data.size() + (8 - data.size() % 8) % 8, 0);
+}
+
+template <typename Derived>
+static void
+append_matrix(std::vector<char>& data, const Eigen::PlainObjectBase<Derived>& m)
+{
+    append(data, uint64_t(m.rows()));
+    append(data, uint64_t(m.cols()));
+    append(data, m.data(), m.size());
+    pad(data);
+}
+
+static void
+append_indices(std::vector<char>& data, const std::vector<size_t>& indices)
+{
+    append(data, uint64_t(indices.size()));
+    for (size_t i : indices) {
+        append(data, uint64_t(i));
+    }
+}
+
+template <typename Derived>
+static bool
+read_matrix(BinaryParser& parser, Eigen::PlainObjectBase<Derived>& m)
+{
+    typedef typename Derived::Scalar Scalar;
+    const uint64_t rows = parser.read<uint64_t>();
+    const uint64_t cols = parser.read<uint64_t>();
+    if (parser.failed()
+        || (cols != 0 && rows > parser.remaining() / sizeof(Scalar) / cols)
+        || (Derived::MaxRowsAtCompileTime != Eigen::Dynamic
+            && rows > uint64_t(Derived::MaxRowsAtCompileTime))
+        || (Derived::MaxColsAtCompileTime != Eigen::Dynamic
+            && cols > uint64_t(Derived::MaxColsAtCompileTime))) {
+        return false;
+    }
+    m.resize(rows, cols);
+    parser.read(m.data(), m.size() * sizeof(Scalar));
+    parser.skip((8 - parser.offset() % 8) % 8);
+    return !parser.failed();
+}
+
+static bool read_indices(BinaryParser& parser, std::vector<size_t>& indices)
+{
+    const uint64_t size = parser.read<uint64_t>();
+    if (parser.failed() || size > parser.remaining() / sizeof(uint64_t)) {
+        return false;
+    }
+    indices.resize(size);
+    for (size_t& i : indices) {
+        i = parser.read<uint64_t>();
+    }
+    return !parser.failed();
+}
+
+static std::vector<char> mesh_key(uint64_t mesh_hash)
+{
+    std::vector<char> key;
+    append(key, mesh_hash);
+    return key;
+}
+
+static std::vector<char> geometries_key(const GeometryCacheKey& key)
+{
+    std::vector<char> data;
+    append(data, key.mesh_hash);
+    append(data, int32_t(key.dim));
+    append(data, uint8_t(key.split_components));
+    append(data, uint8_t(key.use_principal_axes));
+    pad(data);
+    append_matrix(data, key.scale);
+    append_matrix(data, key.rotation);
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Records
+
+static fs::path
+record_path(GeometryCacheKind kind, const std::vector<char>& key)
+{
+    uint64_t h = hash_file_content(key.data(), key.size());
+    return fs::path(geometry_cache_directory())
+        / fmt::format("{:016x}-{:d}.geom", h, int(kind));
+}
+
+/// Write a record to a uniquely named file and move it in place, so
+/// concurrent runs never read a partially written record.
+static void write_record(
+    GeometryCacheKind kind,
+    const std::vector<char>& key,
+    const std::vector<char>& content)
+{
+    const fs::path path = record_path(kind, key);
+
+    GeometryCacheHeader header;
+    std::memset(&header, 0, sizeof(GeometryCacheHeader));
+    std::memcpy(header.magic, GEOMETRY_CACHE_MAGIC, sizeof(header.magic));
+    header.version = GEOMETRY_CACHE_VERSION;
+    header.kind = kind;
+    header.key_size = key.size();
+    header.content_size = content.size();
+
+    std::error_code error;
+    fs::create_directories(path.parent_path(), error);
+    if (error) {
+        spdlog::warn(
+            "Unable to create geometry cache directory: {} ({})",
+            path.parent_path().string(), error.message());
+        return;
+    }
+
+    static thread_local std::mt19937_64 generator { std::random_device()() };
+    const std::string tmp_filename =
+        fmt::format("{}.{:016x}.tmp", path.string(), generator());
+    {
+        std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+            || !file.write(key.data(), key.size())
+            || !file.write(content.data(), content.size()) || !file.flush()) {
+            spdlog::warn(
+                "Unable to write geometry cache file: {}", path.string());
+            file.close();
+            fs::remove(tmp_filename, error);
+            return;
+        }
+    }
+    fs::rename(tmp_filename, path, error);
+    if (error) {
+        spdlog::warn(
+            "Unable to write geometry cache file: {} ({})", path.string(),
+            error.message());
+        fs::remove(tmp_filename, error);
+    }
+}
+
+/// Map a record and position the parser at the start of its content.
+/// @return False if the record does not exist or does not match the key.
+static bool open_record(
+    GeometryCacheKind kind,
+    const std::vector<char>& key,
+    MappedFile& file,
+    BinaryParser& parser)
+{
+    if (!file.open(record_path(kind, key).string())) {
+        return false;
+    }
+    parser = BinaryParser(file.data(), file.size());
+    const GeometryCacheHeader header = parser.read<GeometryCacheHeader>();
+    return !parser.failed()
+        && std::memcmp(
+               header.magic, GEOMETRY_CACHE_MAGIC, sizeof(header.magic))
+        == 0
+        && header.version == GEOMETRY_CACHE_VERSION && header.kind == kind
+        && header.key_size == key.size()
+        && header.key_size <= parser.remaining()
+        && std::memcmp(parser.position(), key.data(), key.size()) == 0
+        && parser.skip(key.size())
+        && header.content_size == parser.remaining();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Meshes
+
+bool load_cached_mesh(
+    uint64_t mesh_hash,
+    Eigen::MatrixXd& vertices,
+    Eigen::MatrixXi& edges,
+    Eigen::MatrixXi& faces)
+{
+    if (geometry_cache_directory().empty()) {
+        return false;
+    }
+    MappedFile file;
+    BinaryParser parser(nullptr, 0);
+    return open_record(MESH, mesh_key(mesh_hash), file, parser)
+        && read_matrix(parser, vertices) && read_matrix(parser, edges)
+        && read_matrix(parser, faces) && parser.remaining() == 0;
+}
+
+void save_cached_mesh(
+    uint64_t mesh_hash,
+    const Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& edges,
+    const Eigen::MatrixXi& faces)
+{
+    if (geometry_cache_directory().empty()) {
+        return;
+    }
+    std::vector<char> content;
+    append_matrix(content, vertices);
+    append_matrix(content, edges);
+    append_matrix(content, faces);
+    write_record(MESH, mesh_key(mesh_hash), content);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Geometries
+
+bool load_cached_geometries(
+    const GeometryCacheKey& key,
+    std::vector<std::shared_ptr<const RigidBodyGeometry>>& geometries)
+{
+    if (geometry_cache_directory().empty()) {
+        return false;
+    }
+    MappedFile file;
+    BinaryParser parser(nullptr, 0);
+    if (!open_record(GEOMETRIES, geometries_key(key), file, parser)) {
+        return false;
+    }
+
+    const uint64_t num_geometries = parser.read<uint64_t>();
+    if (parser.failed() || num_geometries > parser.remaining()) {
+        return false;
+    }
+    std::vector<std::shared_ptr<const RigidBodyGeometry>> loaded_geometries;
+    for (uint64_t i = 0; i < num_geometries; i++) {
+        Eigen::MatrixXd vertices;
+        Eigen::MatrixXi edges, faces, faces_to_edges;
+        VectorMax3d center_of_mass, moment_of_inertia;
+        MatrixMax3d R0;
+        std::vector<size_t> vertex_to_edge, vertex_to_face, edge_to_face;
+        std::vector<size_t> codim_vertices_to_vertices, codim_edges_to_edges;
+        if (!read_matrix(parser, vertices) || !read_matrix(parser, edges)
+            || !read_matrix(parser, faces)
+            || !read_matrix(parser, center_of_mass)
+            || !read_matrix(parser, moment_of_inertia)
+            || !read_matrix(parser, R0)) {
+            return false;
+        }
+        const double volume = parser.read<double>();
+        const double average_edge_length = parser.read<double>();
+        const double r_max = parser.read<double>();
+        if (!read_indices(parser, vertex_to_edge)
+            || !read_indices(parser, vertex_to_face)
+            || !read_indices(parser, edge_to_face)
+            || !read_matrix(parser, faces_to_edges)
+            || !read_indices(parser, codim_vertices_to_vertices)
+            || !read_indices(parser, codim_edges_to_edges)) {
+            return false;
+        }
+
+        // The BVH is rebuilt because its nodes cannot be serialized.
+        loaded_geometries.push_back(std::make_shared<const RigidBodyGeometry>(
+            vertices, edges, faces, center_of_mass, volume, moment_of_inertia,
+            R0, average_edge_length, r_max,
+            MeshSelector(
+                vertex_to_edge, vertex_to_face, edge_to_face, faces_to_edges,
+                codim_vertices_to_vertices, codim_edges_to_edges)));
+    }
+    if (parser.remaining() != 0) {
+        return false;
+    }
+    geometries = std::move(loaded_geometries);
+    return true;
+}
+
+void save_cached_geometries(
+    const GeometryCacheKey& key,
+    const std::vector<std::shared_ptr<const RigidBodyGeometry>>& geometries)
+{
+    if (geometry_cache_directory().empty()) {
+        return;
+    }
+    std::vector<char> content;
+    append(content, uint64_t(geometries.size()));
+    for (const auto& geometry : geometries) {
+        append_matrix(content, geometry->vertices);
+        append_matrix(content, geometry->edges);
+        append_matrix(content, geometry->faces);
+        append_matrix(content, geometry->center_of_mass);
+        append_matrix(content, geometry->moment_of_inertia);
+        append_matrix(content, geometry->R0);
+        append(content, geometry->volume);
+        append(content, geometry->average_edge_length);
+        append(content, geometry->r_max);
+        const MeshSelector& selector = geometry->mesh_selector;
+        append_indices(content, selector.vertex_to_edge());
+        append_indices(content, selector.vertex_to_face());
+        append_indices(content, selector.edge_to_face());
+        append_matrix(content, selector.face_to_edges());
+        append_indices(content, selector.codim_vertices_to_vertices());
+        append_indices(content, selector.codim_edges_to_edges());
+    }
+    write_record(GEOMETRIES, geometries_key(key), content);
+}
+
+} // namespace ipc::rigid
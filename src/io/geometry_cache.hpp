@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <physics/rigid_body.hpp>
+#include <utils/eigen_ext.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Content of a record of the geometry cache.
+enum GeometryCacheKind : uint32_t {
+    MESH = 0,      ///< Parsed mesh of a file
+    GEOMETRIES = 1 ///< Body geometries processed from a mesh
+};
+
+/**
+ * @brief Header of a record of the geometry cache (.geom).
+ *
+ * The header is followed by the key of the record (checked on load to guard
+ * against hash collisions) and its content. Matrices are stored as their
+ * number of rows and columns followed by their column-major coefficients,
+ * padded to 8 bytes so every array is aligned in the mapped file.
+ */
+struct GeometryCacheHeader {
+    char magic[8];         ///< "RIPCGEOM"
+    uint32_t version;      ///< Version of the format
+    uint32_t kind;         ///< GeometryCacheKind of the record
+    uint64_t key_size;     ///< Bytes of the key
+    uint64_t content_size; ///< Bytes of the content
+};
+static_assert(sizeof(GeometryCacheHeader) == 32);
+
+/// @brief Directory of the geometry cache (empty if the cache is disabled).
+///
+/// Defaults to the RIGID_IPC_GEOMETRY_CACHE environment variable.
+const std::string& geometry_cache_directory();
+
+/// @brief Set the directory of the geometry cache (empty to disable it).
+void set_geometry_cache_directory(const std::string& directory);
+
+/// @brief Hash the content of a file (e.g., a mapped mesh file).
+uint64_t hash_file_content(const char* data, size_t size);
+
+/// @brief Inputs of the processing of a mesh file into body geometries.
+///
+/// The density is not part of the key because the mass properties of a
+/// geometry are for a unit density.
+struct GeometryCacheKey {
+    uint64_t mesh_hash; ///< hash_file_content() of the mesh file
+    int dim;
+    VectorMax3d scale;
+    MatrixMax3d rotation; ///< Rotation baked into the vertices
+    bool split_components;
+    bool use_principal_axes;
+};
+
+/// @brief Load the parsed mesh of a file from the cache.
+/// @return False if the mesh is not cached.
+bool load_cached_mesh(
+    uint64_t mesh_hash,
+    Eigen::MatrixXd& vertices,
+    Eigen::MatrixXi& edges,
+    Eigen::MatrixXi& faces);
+
+/// @brief Save the parsed mesh of a file to the cache.
+void save_cached_mesh(
+    uint64_t mesh_hash,
+    const Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& edges,
+    const Eigen::MatrixXi& faces);
+
+/// @brief Load processed body geometries from the cache.
+/// @return False if the geometries are not cached.
+bool load_cached_geometries(
+    const GeometryCacheKey& key,
+    std::vector<std::shared_ptr<const RigidBodyGeometry>>& geometries);
+
+/// @brief Save processed body geometries to the cache.
+void save_cached_geometries(
+    const GeometryCacheKey& key,
+    const std::vector<std::shared_ptr<const RigidBodyGeometry>>& geometries);
+
+} // namespace ipc::rigid
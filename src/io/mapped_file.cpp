@@ -0,0 +1,68 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ipc::rigid {
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+#ifdef _WIN32
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    m_buffer.assign(
+        std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    if (file_stat.st_size == 0) { // Empty files cannot be mapped
+        ::close(fd);
+        return true;
+    }
+    void* data =
+        mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping stays valid
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<const char*>(data);
+    m_size = file_stat.st_size;
+    m_is_mapped = true;
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    m_buffer.clear();
+#else
+    if (m_is_mapped) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_is_mapped = false;
+}
+
+} // namespace ipc::rigid
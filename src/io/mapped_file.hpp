@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ipc::rigid {
+
+/// @brief Read-only memory mapping of a whole file.
+///
+/// On Windows the file is read into a buffer instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    /// @brief Map a file (an empty file is mapped to an empty range).
+    /// @return False if the file could not be opened or mapped.
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+protected:
+    const char* m_data = nullptr; ///< Mapped file
+    size_t m_size = 0;            ///< Size of the mapped file
+    bool m_is_mapped = false;     ///< Does m_data need to be unmapped?
+#ifdef _WIN32
+    std::vector<char> m_buffer; ///< Content of the file (no mmap)
+#endif
+};
+
+} // namespace ipc::rigid
@@ -9,15 +9,21 @@
 
 #include "read_obj.hpp"
 
+#include <algorithm>
+#include <charconv>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <string_view>
 
 #include <igl/edges.h>
-#include <igl/list_to_matrix.h>
+#include <tbb/parallel_for.h>
 
+#include <io/mapped_file.hpp>
 #include <logger.hpp>
 
 namespace ipc::rigid {
@@ -253,41 +259,285 @@ bool read_obj(
     return read_obj(obj_file_name, V, TC, N, F, FTC, FN, L);
 }
 
+namespace {
+    /// Elements parsed from a range of whole lines of an obj file.
+    struct ObjChunk {
+        std::vector<double> vertices; ///< Flattened vertex positions
+        std::vector<int> faces;       ///< Flattened vertex indices
+        std::vector<int> edges;       ///< Flattened polyline segments
+        /// Entries of faces/edges relative to the vertices of the chunk
+        std::vector<size_t> relative_faces, relative_edges;
+        size_t num_vertices = 0;
+        int vertex_dim = -1;  ///< Number of coordinates of every vertex
+        int face_degree = -1; ///< Number of vertices of every face
+        size_t num_lines = 0;
+        /// Ignored lines (chunk line number and content)
+        std::vector<std::pair<size_t, std::string>> warnings;
+        std::string error; ///< First error (empty if none)
+        size_t error_line = 0;
+    };
+
+    inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    inline const char* skip_blanks(const char* p, const char* end)
+    {
+        while (p < end && is_blank(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    inline bool parse_double(const char*& p, const char* end, double& x)
+    {
+        p = skip_blanks(p, end);
+        if (p < end && *p == '+') { // Not accepted by from_chars
+            p++;
+        }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        std::from_chars_result result = std::from_chars(p, end, x);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        p = result.ptr;
+        return true;
+#else
+        // strtod needs a null terminated copy (the mapped file is not)
+        char buffer[64];
+        size_t n = 0;
+        while (p + n < end && n < sizeof(buffer) - 1 && !is_blank(p[n])
+               && p[n] != '\n') {
+            buffer[n] = p[n];
+            n++;
+        }
+        buffer[n] = '\0';
+        char* parsed_end;
+        x = std::strtod(buffer, &parsed_end);
+        if (parsed_end == buffer) {
+            return false;
+        }
+        p += parsed_end - buffer;
+        return true;
+#endif
+    }
+
+    inline bool parse_int(const char*& p, const char* end, long& i)
+    {
+        p = skip_blanks(p, end);
+        if (p < end && *p == '+') {
+            p++;
+        }
+        std::from_chars_result result = std::from_chars(p, end, i);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+
+    /// Parse the lines in [begin, end) of an obj file.
+    void parse_obj_chunk(const char* begin, const char* end, ObjChunk& chunk)
+    {
+        // Convert a (possibly negative) obj index to a zero based index
+        const auto shift = [&chunk](long i, std::vector<size_t>& relative,
+                                    size_t entry) -> int {
+            if (i < 0) {
+                relative.push_back(entry);
+                return int(i + chunk.num_vertices);
+            }
+            return int(i - 1);
+        };
+
+        for (const char* line = begin; line < end; chunk.num_lines++) {
+            const char* line_end =
+                static_cast<const char*>(std::memchr(line, '\n', end - line));
+            if (line_end == nullptr) {
+                line_end = end;
+            }
+            const char* p = skip_blanks(line, line_end);
+            const char* type_end = p;
+            while (type_end < line_end && !is_blank(*type_end)) {
+                type_end++;
+            }
+            const std::string_view type(p, type_end - p);
+            p = type_end;
+
+            if (type == "v") {
+                double x;
+                int dim = 0;
+                while (parse_double(p, line_end, x)) {
+                    chunk.vertices.push_back(x);
+                    dim++;
+                }
+                if (chunk.vertex_dim < 0) {
+                    chunk.vertex_dim = dim;
+                } else if (chunk.vertex_dim != dim) {
+                    chunk.vertex_dim = 0; // Not rectangular
+                }
+                chunk.num_vertices++;
+            } else if (type == "f") {
+                int degree = 0;
+                long i;
+                while ((p = skip_blanks(p, line_end)) < line_end) {
+                    if (!parse_int(p, line_end, i)) {
+                        chunk.error = "face has invalid element format";
+                        break;
+                    }
+                    chunk.faces.push_back(
+                        shift(i, chunk.relative_faces, chunk.faces.size()));
+                    degree++;
+                    // Texture coordinates and normals are not used
+                    while (p < line_end && !is_blank(*p)) {
+                        p++;
+                    }
+                }
+                if (chunk.error.empty() && degree == 0) {
+                    chunk.error = "face has invalid format";
+                }
+                if (chunk.face_degree < 0) {
+                    chunk.face_degree = degree;
+                } else if (chunk.face_degree != degree) {
+                    chunk.face_degree = 0; // Not rectangular
+                }
+            } else if (type == "l") {
+                std::vector<int> polyline;
+                long i;
+                while (parse_int(p, line_end, i)) {
+                    polyline.push_back(i);
+                }
+                if (polyline.size() < 2) {
+                    chunk.error =
+                        "line element should have at least 2 vertices";
+                }
+                for (size_t j = 1; j < polyline.size(); j++) {
+                    for (long k : { polyline[j - 1], polyline[j] }) {
+                        chunk.edges.push_back(
+                            shift(k, chunk.relative_edges, chunk.edges.size()));
+                    }
+                }
+            } else if (
+                type.empty() || type == "vn" || type == "vt" || type[0] == '#'
+                || type[0] == 'g' || type[0] == 's' || type == "usemtl"
+                || type == "mtllib") {
+                // ignore empty lines, comments, normals, texture
+                // coordinates, and other stuff
+            } else {
+                const bool has_cr = line_end[-1] == '\r';
+                chunk.warnings.emplace_back(
+                    chunk.num_lines,
+                    std::string(line, line_end - line - has_cr));
+            }
+
+            if (!chunk.error.empty()) {
+                chunk.error_line = chunk.num_lines;
+                return;
+            }
+            line = line_end + 1;
+        }
+    }
+} // namespace
+
 bool read_obj(
     const std::string str,
     Eigen::MatrixXd& V,
     Eigen::MatrixXi& E,
     Eigen::MatrixXi& F)
 {
-    std::vector<std::vector<double>> vV, vTC, vN;
-    std::vector<std::vector<int>> vF, vFTC, vFN, vL;
-    bool success = read_obj(str, vV, vTC, vN, vF, vFTC, vFN, vL);
-    if (!success) {
-        // read_obj(str,vV,vTC,vN,vF,vFTC,vFN) should have already printed
-        // an error message
-        return false;
-    }
-    bool V_rect = igl::list_to_matrix(vV, V);
-    if (!V_rect) {
-        // igl::list_to_matrix(vV,V) already printed error message
+    MappedFile file;
+    if (!file.open(str)) {
+        spdlog::error("read_obj: {:s} could not be opened!", str);
         return false;
     }
-    bool F_rect = igl::list_to_matrix(vF, F);
-    if (!F_rect) {
-        // igl::list_to_matrix(vF,F) already printed error message
-        return false;
+    const char* data = file.data();
+    const char* data_end = data + file.size();
+
+    // Split the file into chunks of whole lines parsed in parallel
+    const size_t min_chunk_size = 1 << 20; // 1 MiB
+    const size_t num_chunks = std::max(file.size() / min_chunk_size, size_t(1));
+    std::vector<const char*> chunk_begins(num_chunks + 1, data_end);
+    chunk_begins[0] = data;
+    for (size_t i = 1; i < num_chunks; i++) {
+        const char* p = std::max(
+            data + i * (file.size() / num_chunks), chunk_begins[i - 1]);
+        p = static_cast<const char*>(std::memchr(p, '\n', data_end - p));
+        chunk_begins[i] = p == nullptr ? data_end : p + 1;
     }
-    std::vector<std::vector<int>> vE;
-    for (const std::vector<int>& polyline : vL) {
-        for (int i = 1; i < polyline.size(); i++) {
-            vE.push_back({ { polyline[i - 1], polyline[i] } });
+
+    std::vector<ObjChunk> chunks(num_chunks);
+    tbb::parallel_for(size_t(0), num_chunks, [&](size_t i) {
+        parse_obj_chunk(chunk_begins[i], chunk_begins[i + 1], chunks[i]);
+    });
+
+    // Report the messages in the order of the file and count the elements
+    std::vector<size_t> vertex_offsets(num_chunks + 1, 0);
+    std::vector<size_t> face_offsets(num_chunks + 1, 0);
+    std::vector<size_t> edge_offsets(num_chunks + 1, 0);
+    size_t line_offset = 0;
+    int dim = -1, face_degree = -1;
+    for (size_t i = 0; i < num_chunks; i++) {
+        const ObjChunk& chunk = chunks[i];
+        for (const auto& [line_no, line] : chunk.warnings) {
+            spdlog::warn(
+                "read_obj: ignored non-comment line {:d}: {:s}",
+                line_offset + line_no + 1, line);
+        }
+        if (!chunk.error.empty()) {
+            spdlog::error(
+                "read_obj: {:s} (line {:d})", chunk.error,
+                line_offset + chunk.error_line + 1);
+            return false;
+        }
+        line_offset += chunk.num_lines;
+
+        if (chunk.num_vertices) {
+            dim = dim < 0 || dim == chunk.vertex_dim ? chunk.vertex_dim : 0;
         }
+        if (chunk.faces.size()) {
+            face_degree = face_degree < 0 || face_degree == chunk.face_degree
+                ? chunk.face_degree
+                : 0;
+        }
+        vertex_offsets[i + 1] = vertex_offsets[i] + chunk.num_vertices;
+        face_offsets[i + 1] = face_offsets[i] + chunk.faces.size();
+        edge_offsets[i + 1] = edge_offsets[i] + chunk.edges.size();
+    }
+    if (dim == 0) {
+        spdlog::error("read_obj: vertices not rectangular matrix!");
+        return false;
     }
-    bool E_rect = igl::list_to_matrix(vE, E);
-    if (!E_rect) {
-        spdlog::error("read_obj: edges not rectangular matrix!");
+    if (face_degree == 0) {
+        spdlog::error("read_obj: faces not rectangular matrix!");
         return false;
     }
+
+    // Copy the chunks straight into the matrices
+    const size_t num_vertices = vertex_offsets.back();
+    const size_t num_faces = face_offsets.back() / std::max(face_degree, 1);
+    const size_t num_edges = edge_offsets.back() / 2;
+    V.resize(num_vertices, num_vertices ? dim : 0);
+    F.resize(num_faces, num_faces ? face_degree : 0);
+    E.resize(num_edges, num_edges ? 2 : 0);
+    tbb::parallel_for(size_t(0), num_chunks, [&](size_t i) {
+        const ObjChunk& chunk = chunks[i];
+        const size_t vertex_offset = vertex_offsets[i];
+        for (size_t j = 0; j < chunk.vertices.size(); j++) {
+            V(vertex_offset + j / dim, j % dim) = chunk.vertices[j];
+        }
+        const size_t face_offset = face_offsets[i] / std::max(face_degree, 1);
+        for (size_t j = 0; j < chunk.faces.size(); j++) {
+            F(face_offset + j / face_degree, j % face_degree) = chunk.faces[j];
+        }
+        for (size_t j : chunk.relative_faces) {
+            F(face_offset + j / face_degree, j % face_degree) += vertex_offset;
+        }
+        const size_t edge_offset = edge_offsets[i] / 2;
+        for (size_t j = 0; j < chunk.edges.size(); j++) {
+            E(edge_offset + j / 2, j % 2) = chunk.edges[j];
+        }
+        for (size_t j : chunk.relative_edges) {
+            E(edge_offset + j / 2, j % 2) += vertex_offset;
+        }
+    });
+
     if (F.size()) {
         Eigen::MatrixXi faceE;
         igl::edges(F, faceE);
@@ -62,9 +62,14 @@ bool read_obj(
     std::vector<std::vector<int>>& L);
 
 /// @brief Eigen Wrappers of read_obj.
+///
+/// The file is memory-mapped and split into chunks of lines that are parsed
+/// in parallel and then copied into the matrices. Texture coordinates and
+/// normals are skipped.
+///
 /// @retruns These will return true only if the data is perfectly
-///          "rectangular": All faces are the same degree, all have the same
-///          number of textures/normals etc.
+///          "rectangular": All faces are the same degree and all vertices
+///          have the same number of coordinates.
 bool read_obj(
     const std::string str,
     Eigen::MatrixXd& V,
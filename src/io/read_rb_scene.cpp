@@ -1,5 +1,8 @@
 #include "read_rb_scene.hpp"
 
+#include <deque>
+#include <map>
+#include <tuple>
 #include <unordered_set>
 
 #include <Eigen/Geometry>
@@ -9,8 +12,11 @@
 #include <igl/PI.h>
 #include <igl/read_triangle_mesh.h>
 #include <igl/remove_unreferenced.h>
+#include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
+#include <io/geometry_cache.hpp>
+#include <io/mapped_file.hpp>
 #include <io/read_obj.hpp>
 #include <io/serialize_json.hpp>
 #include <logger.hpp>
@@ -24,6 +30,131 @@ inline bool contains(const std::unordered_set<T>& set, const T& val)
     return set.find(val) != set.end();
 }
 
+namespace {
+    struct Mesh {
+        Eigen::MatrixXd vertices;
+        Eigen::MatrixXi edges, faces;
+        bool is_hashed = false; ///< Is the mesh file in the geometry cache?
+        uint64_t hash = 0;      ///< Hash of the content of the mesh file
+    };
+
+    /// Input of the construction of a (possibly split) body geometry.
+    struct GeometryArgs {
+        const Mesh* mesh;
+        VectorMax3d scale;
+        MatrixMax3d rotation; ///< Baked into the vertices
+        bool split_components;
+        bool use_principal_axes;
+    };
+
+    /// Per-body state read from the scene, applied to a shared geometry.
+    struct BodyArgs {
+        std::string name;
+        size_t geometry_id;
+        bool split_components;
+        PoseD pose, velocity, force;
+        double density;
+        VectorMax6b is_dof_fixed;
+        bool oriented;
+        int group_id;
+        RigidBodyType type;
+        double kinematic_max_time;
+        std::deque<PoseD> kinematic_poses;
+    };
+
+    /// Mesh path, scale, split_components, principal axes, baked rotation
+    typedef std::tuple<
+        std::string,
+        std::vector<double>,
+        bool,
+        bool,
+        std::vector<double>>
+        GeometryKey;
+
+    std::vector<double> to_std_vector(const VectorMax3d& v)
+    {
+        return std::vector<double>(v.data(), v.data() + v.size());
+    }
+
+    /// Build the geometries of a body (one per component if split).
+    std::vector<std::shared_ptr<const RigidBodyGeometry>> build_geometries(
+        const Eigen::MatrixXd& vertices,
+        const Eigen::MatrixXi& edges,
+        const Eigen::MatrixXi& faces,
+        bool split_components,
+        bool use_principal_axes)
+    {
+        std::vector<std::shared_ptr<const RigidBodyGeometry>> geometries;
+        if (!split_components) {
+            geometries.push_back(std::make_shared<const RigidBodyGeometry>(
+                vertices, edges, faces, use_principal_axes));
+            return geometries;
+        }
+
+        // TODO: Handle codimensional edges too
+        assert(faces.cols() == 3);
+        Eigen::VectorXi C;
+        igl::facet_components(faces, C);
+        int num_components = C.maxCoeff();
+        std::vector<std::vector<int>> CFs(num_components + 1);
+        for (int j = 0; j < faces.cols(); j++) {
+            for (int i = 0; i < faces.rows(); i++) {
+                CFs[C[i]].push_back(faces(i, j));
+            }
+        }
+
+        for (int ci = 0; ci < CFs.size(); ci++) {
+            Eigen::MatrixXi F = Eigen::Map<Eigen::MatrixXi>(
+                CFs[ci].data(), CFs[ci].size() / 3, 3);
+            Eigen::MatrixXd CV;
+            Eigen::MatrixXi CF;
+            Eigen::VectorXi I;
+            igl::remove_unreferenced(vertices, F, CV, CF, I);
+            Eigen::MatrixXi CE;
+            igl::edges(CF, CE);
+            geometries.push_back(std::make_shared<const RigidBodyGeometry>(
+                CV, CE, CF, use_principal_axes));
+        }
+        return geometries;
+    }
+
+    bool load_mesh(const fs::path& mesh_path, Mesh& mesh)
+    {
+        if (!geometry_cache_directory().empty()) {
+            MappedFile file;
+            if (file.open(mesh_path.string())) {
+                mesh.hash = hash_file_content(file.data(), file.size());
+                mesh.is_hashed = true;
+                if (load_cached_mesh(
+                        mesh.hash, mesh.vertices, mesh.edges, mesh.faces)) {
+                    spdlog::info(
+                        "loaded cached mesh: {:s}", mesh_path.string());
+                    return true;
+                }
+            }
+        }
+
+        spdlog::info("loading mesh: {:s}", mesh_path.string());
+        bool success;
+        if (mesh_path.extension() == ".obj") {
+            success = read_obj(
+                mesh_path.string(), mesh.vertices, mesh.edges, mesh.faces);
+        } else {
+            success = igl::read_triangle_mesh(
+                mesh_path.string(), mesh.vertices, mesh.faces);
+            // Initialize edges
+            if (mesh.faces.size()) {
+                igl::edges(mesh.faces, mesh.edges);
+            }
+        }
+        assert(mesh.faces.size() == 0 || mesh.faces.cols() == 3);
+        if (success && mesh.is_hashed) {
+            save_cached_mesh(mesh.hash, mesh.vertices, mesh.edges, mesh.faces);
+        }
+        return success;
+    }
+} // namespace
+
 bool read_rb_scene_from_str(const std::string str, std::vector<RigidBody>& rbs)
 {
     using nlohmann::json;
@@ -60,6 +191,14 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
 
     std::unordered_map<std::string, int> rb_name_to_count;
 
+    // The mesh files are loaded in parallel, then the body arguments are read
+    // serially, and finally the geometries (mass properties, BVH, ...) and
+    // the bodies are built in parallel. Bodies instancing the same mesh share
+    // its geometry, so every mesh is only loaded and processed once.
+    std::vector<json> bodies_json_args;
+    std::unordered_map<std::string, Mesh> meshes;
+    std::vector<fs::path> mesh_paths; // Unique meshes to load
+
     for (auto& jrb : scene["rigid_bodies"]) {
         // NOTE:
         // All units by default are expressed in standard SI units
@@ -103,10 +242,6 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
             continue;
         }
 
-        Eigen::MatrixXd vertices;
-        Eigen::MatrixXi faces, edges;
-        std::string rb_name;
-
         std::string mesh_fname = args["mesh"].get<std::string>();
         if (mesh_fname != "") {
             fs::path mesh_path(mesh_fname);
@@ -114,31 +249,50 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
                 // TODO: First check a path relative to the input file
                 mesh_path = fs::path(RIGID_IPC_MESHES_DIR) / mesh_path;
             }
-            spdlog::info("loading mesh: {:s}", mesh_path.string());
-            bool success;
-            if (mesh_path.extension() == ".obj") {
-                success = read_obj(mesh_path.string(), vertices, edges, faces);
-            } else {
-                success = igl::read_triangle_mesh(
-                    mesh_path.string(), vertices, faces);
-                // Initialize edges
-                if (faces.size()) {
-                    igl::edges(faces, edges);
-                }
-            }
-            assert(faces.size() == 0 || faces.cols() == 3);
-            if (!success) {
-                return false;
+            args["mesh"] = mesh_path.string();
+            if (meshes.emplace(mesh_path.string(), Mesh()).second) {
+                mesh_paths.push_back(mesh_path);
             }
+        }
+        bodies_json_args.push_back(std::move(args));
+    }
+
+    std::vector<char> is_mesh_loaded(mesh_paths.size());
+    tbb::parallel_for(size_t(0), mesh_paths.size(), [&](size_t i) {
+        // The map is not modified, so concurrent lookups are safe.
+        Mesh& mesh = meshes.find(mesh_paths[i].string())->second;
+        is_mesh_loaded[i] = load_mesh(mesh_paths[i], mesh);
+    });
+    for (char is_loaded : is_mesh_loaded) {
+        if (!is_loaded) {
+            return false;
+        }
+    }
+
+    std::deque<Mesh> inline_meshes; // Inline meshes are not shared
+    std::map<GeometryKey, size_t> geometry_ids;
+    std::vector<GeometryArgs> geometries_args;
+    std::vector<BodyArgs> bodies_args;
+    bodies_args.reserve(bodies_json_args.size());
 
-            rb_name = mesh_path.stem().string();
+    for (const json& args : bodies_json_args) {
+        const Mesh* mesh;
+        std::string rb_name;
+
+        std::string mesh_fname = args["mesh"].get<std::string>();
+        if (mesh_fname != "") {
+            mesh = &meshes.at(mesh_fname);
+            rb_name = fs::path(mesh_fname).stem().string();
         } else {
             // Assumes that edges contains the edges of the faces too.
-            from_json(args["vertices"], vertices);
-            from_json(args["edges"], edges);
-            from_json(args["faces"], faces);
+            Mesh& inline_mesh = inline_meshes.emplace_back();
+            from_json(args["vertices"], inline_mesh.vertices);
+            from_json(args["edges"], inline_mesh.edges);
+            from_json(args["faces"], inline_mesh.faces);
+            mesh = &inline_mesh;
             rb_name = "RigidBody";
         }
+        const Eigen::MatrixXd& vertices = mesh->vertices;
 
         if (dim == -1) {
             if (vertices.cols() != 0) { // Why would we have an empty body?
@@ -152,10 +306,9 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
                 "Mixing 2D and 3D bodies are not currently allowed.");
         }
 
-        if (dim == 2 && faces.size() != 0) {
+        if (dim == 2 && mesh->faces.size() != 0) {
+            // The faces will not be used
             spdlog::warn("Ignoring faces for 2D rigid body.");
-            // Delete the faces since they will not be uses
-            faces.resize(0, 0);
         }
 
         VectorMax3d position;
@@ -182,7 +335,6 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
             assert(scale.size() >= dim);
             scale.conservativeResize(dim);
         }
-        vertices *= scale.asDiagonal();
 
         // Rotate around the models origin NOT the rigid bodies center of mass
         VectorMax3d rotation = read_angular_field(args["rotation"], dim);
@@ -195,8 +347,6 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
         } else {
             R = Eigen::Rotation2Dd(rotation(0)).toRotationMatrix();
         }
-        vertices = vertices * R.transpose();
-        rotation.setZero(angular_dim); // Zero initial body rotation
 
         VectorMax3d linear_velocity;
         from_json(args["linear_velocity"], linear_velocity);
@@ -222,14 +372,6 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
             is_dof_fixed.conservativeResize(ndof);
         }
 
-        double density = args["density"];
-        bool is_oriented = args["oriented"];
-
-        int group_id = args["group_id"];
-
-        RigidBodyType rb_type = args["type"];
-        double kinematic_max_time = args["kinematic_max_time"];
-
         std::vector<json> json_kinematic_poses = args["kinematic_poses"];
         std::deque<PoseD> kinematic_poses;
         for (const auto& json_pose : json_kinematic_poses) {
@@ -243,45 +385,91 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
             kinematic_poses.push_back(pose);
         }
 
-        if (args["split_components"].get<bool>()) {
-            // TODO: Handle codimensional edges too
-            assert(faces.cols() == 3);
-            Eigen::VectorXi C;
-            igl::facet_components(faces, C);
-            int num_components = C.maxCoeff();
-            std::vector<std::vector<int>> CFs(num_components + 1);
-            for (int j = 0; j < faces.cols(); j++) {
-                for (int i = 0; i < faces.rows(); i++) {
-                    CFs[C[i]].push_back(faces(i, j));
-                }
-            }
+        bool split_components = args["split_components"].get<bool>();
 
-            for (int ci = 0; ci < CFs.size(); ci++) {
-                Eigen::MatrixXi F = Eigen::Map<Eigen::MatrixXi>(
-                    CFs[ci].data(), CFs[ci].size() / 3, 3);
-                Eigen::MatrixXd CV;
-                Eigen::MatrixXi CF;
-                Eigen::VectorXi I;
-                igl::remove_unreferenced(vertices, F, CV, CF, I);
-                Eigen::MatrixXi CE;
-                igl::edges(CF, CE);
-                // WARNING: angular velocity and torque will be around the
-                // components center of mass not the entire meshes.
-                rbs.emplace_back(
-                    CV, CE, CF, PoseD(position, VectorMax3d::Zero(angular_dim)),
-                    PoseD(linear_velocity, angular_velocity),
-                    PoseD(force, torque), density, is_dof_fixed, is_oriented,
-                    group_id, rb_type, kinematic_max_time, kinematic_poses);
-                rbs.back().name = fmt::format("{}-part{:03d}", rb_name, ci);
-            }
+        // The rotation is baked into the mesh, so the initial body rotation is
+        // zero and bodies only share a geometry if they have the same rotation.
+        bool use_principal_axes = RigidBody::use_principal_axes(is_dof_fixed);
+        VectorMax3d body_rotation = VectorMax3d::Zero(angular_dim);
+
+        GeometryKey key(
+            mesh_fname, to_std_vector(scale), split_components,
+            use_principal_axes, to_std_vector(rotation));
+        auto cached_geometry_id = geometry_ids.find(key);
+        size_t geometry_id;
+        if (mesh_fname != "" && cached_geometry_id != geometry_ids.end()) {
+            geometry_id = cached_geometry_id->second;
         } else {
-            rbs.emplace_back(
-                vertices, edges, faces,
-                PoseD(position, VectorMax3d::Zero(angular_dim)),
-                PoseD(linear_velocity, angular_velocity), PoseD(force, torque),
-                density, is_dof_fixed, is_oriented, group_id, rb_type,
-                kinematic_max_time, kinematic_poses);
-            rbs.back().name = rb_name;
+            geometry_id = geometries_args.size();
+            geometries_args.push_back(GeometryArgs {
+                mesh, scale, R,
+                split_components, use_principal_axes });
+            if (mesh_fname != "") {
+                geometry_ids.emplace(key, geometry_id);
+            }
+        }
+
+        bodies_args.push_back(BodyArgs {
+            rb_name, geometry_id, split_components,
+            PoseD(position, body_rotation),
+            PoseD(linear_velocity, angular_velocity), PoseD(force, torque),
+            args["density"].get<double>(), is_dof_fixed,
+            args["oriented"].get<bool>(), args["group_id"].get<int>(),
+            args["type"].get<RigidBodyType>(),
+            args["kinematic_max_time"].get<double>(), kinematic_poses });
+    }
+
+    std::vector<std::vector<std::shared_ptr<const RigidBodyGeometry>>>
+        geometries(geometries_args.size());
+    tbb::parallel_for(size_t(0), geometries_args.size(), [&](size_t i) {
+        const GeometryArgs& geometry_args = geometries_args[i];
+        const Mesh& mesh = *geometry_args.mesh;
+        // Only the geometries of mesh files are cached
+        const GeometryCacheKey cache_key {
+            mesh.hash,
+            dim,
+            geometry_args.scale,
+            geometry_args.rotation,
+            geometry_args.split_components,
+            geometry_args.use_principal_axes,
+        };
+        if (mesh.is_hashed
+            && load_cached_geometries(cache_key, geometries[i])) {
+            return;
+        }
+
+        Eigen::MatrixXd V = mesh.vertices * geometry_args.scale.asDiagonal()
+            * geometry_args.rotation.transpose();
+        geometries[i] = build_geometries(
+            V, mesh.edges, dim == 2 ? Eigen::MatrixXi() : mesh.faces,
+            geometry_args.split_components, geometry_args.use_principal_axes);
+        if (mesh.is_hashed) {
+            save_cached_geometries(cache_key, geometries[i]);
+        }
+    });
+
+    // WARNING: When splitting the components, angular velocity and torque
+    // will be around the components center of mass not the entire meshes.
+    std::vector<std::vector<RigidBody>> bodies(bodies_args.size());
+    tbb::parallel_for(size_t(0), bodies_args.size(), [&](size_t i) {
+        const BodyArgs& body_args = bodies_args[i];
+        const auto& rb_geometries = geometries[body_args.geometry_id];
+        for (int ci = 0; ci < rb_geometries.size(); ci++) {
+            bodies[i].emplace_back(
+                rb_geometries[ci], body_args.pose, body_args.velocity,
+                body_args.force, body_args.density, body_args.is_dof_fixed,
+                body_args.oriented, body_args.group_id, body_args.type,
+                body_args.kinematic_max_time, body_args.kinematic_poses);
+            bodies[i].back().name = body_args.split_components
+                ? fmt::format("{}-part{:03d}", body_args.name, ci)
+                : body_args.name;
+        }
+    });
+
+    // Append the bodies in the scene order
+    for (std::vector<RigidBody>& body_parts : bodies) {
+        for (RigidBody& rb : body_parts) {
+            rbs.push_back(std::move(rb));
         }
     }
 
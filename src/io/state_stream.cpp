@@ -0,0 +1,73 @@
+#include "state_stream.hpp"
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+bool StateStreamWriter::open(
+    const std::string& filename, const nlohmann::json& args)
+{
+    close();
+    m_file.open(filename, std::ios::out | std::ios::trunc);
+    if (!m_file) {
+        spdlog::error("Unable to open state stream: {}", filename);
+        return false;
+    }
+    m_filename = filename;
+    m_num_states = 0;
+    m_file << nlohmann::json { { "args", args } }.dump() << '\n' << std::flush;
+    return bool(m_file);
+}
+
+bool StateStreamWriter::write(const nlohmann::json& state)
+{
+    assert(is_open());
+    // Never split a line, so a partial file only loses the last state.
+    m_file << state.dump() << '\n' << std::flush;
+    if (!m_file) {
+        spdlog::error("Unable to write to state stream: {}", m_filename);
+        return false;
+    }
+    m_num_states++;
+    return true;
+}
+
+void StateStreamWriter::close()
+{
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+}
+
+bool StateStreamReader::open(const std::string& filename)
+{
+    m_file.open(filename);
+    std::string line;
+    if (!m_file || !std::getline(m_file, line)) {
+        spdlog::error("Unable to open state stream: {}", filename);
+        return false;
+    }
+    nlohmann::json header = nlohmann::json::parse(line, nullptr, false);
+    if (header.is_discarded() || !header.contains("args")) {
+        spdlog::error("Invalid state stream: {}", filename);
+        return false;
+    }
+    m_args = std::move(header["args"]);
+    return true;
+}
+
+bool StateStreamReader::next(nlohmann::json& state)
+{
+    std::string line;
+    if (!std::getline(m_file, line)) {
+        return false;
+    }
+    state = nlohmann::json::parse(line, nullptr, false);
+    if (state.is_discarded()) {
+        spdlog::warn("Ignoring the incomplete last state of the state stream");
+        return false;
+    }
+    return true;
+}
+
+} // namespace ipc::rigid
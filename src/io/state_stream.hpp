@@ -0,0 +1,54 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Append the states of a simulation to a JSON Lines file as they are
+ * computed.
+ *
+ * The first line holds the simulation arguments and every following line
+ * one state. Lines are flushed as they are written, so the file of a crashed
+ * run holds every completed step and can be loaded with StateStreamReader.
+ */
+class StateStreamWriter {
+public:
+    /// @brief Create the file and write the arguments line.
+    bool open(const std::string& filename, const nlohmann::json& args);
+    /// @brief Append a state.
+    bool write(const nlohmann::json& state);
+    void close();
+
+    bool is_open() const { return m_file.is_open(); }
+    const std::string& filename() const { return m_filename; }
+    size_t num_states() const { return m_num_states; }
+
+protected:
+    std::ofstream m_file;
+    std::string m_filename;
+    size_t m_num_states = 0;
+};
+
+/// @brief Read the states written by a StateStreamWriter one at a time.
+class StateStreamReader {
+public:
+    /// @brief Open the file and read the arguments line.
+    bool open(const std::string& filename);
+
+    /// @brief Read the next state.
+    /// @return False at the end of the file or at an incomplete line (e.g., the
+    /// last line of a crashed run).
+    bool next(nlohmann::json& state);
+
+    const nlohmann::json& args() const { return m_args; }
+
+protected:
+    std::ifstream m_file;
+    nlohmann::json m_args;
+};
+
+} // namespace ipc::rigid
@@ -0,0 +1,289 @@
+#include "trajectory.hpp"
+
+#include <cstring>
+#include <limits>
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+static const char TRAJECTORY_MAGIC[8] = { 'R', 'I', 'P', 'C',
+                                          'T', 'R', 'A', 'J' };
+static const uint32_t TRAJECTORY_VERSION = 1;
+
+/// Frames start at a multiple of 8 bytes so the mapped scalars are aligned.
+static uint64_t align_offset(uint64_t offset) { return (offset + 7) & ~7ull; }
+
+struct TrajectoryIndexEntry {
+    uint64_t offset; ///< Offset of the frame in the file
+    double time;     ///< Time of the frame
+};
+
+static size_t frame_stride(const TrajectoryHeader& header)
+{
+    return header.num_bodies * PoseD::dim_to_ndof(header.dim)
+        * (header.has_velocity ? 2 : 1) * header.scalar_size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Writer
+
+bool TrajectoryWriter::open(
+    const std::string& filename,
+    int dim,
+    size_t num_bodies,
+    double timestep,
+    const nlohmann::json& metadata,
+    bool single_precision,
+    bool write_velocities)
+{
+    close();
+    m_filename = filename;
+    m_file.open(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!m_file) {
+        spdlog::error("Unable to open trajectory file: {}", filename);
+        return false;
+    }
+
+    std::string metadata_str = metadata.dump();
+    std::memset(&m_header, 0, sizeof(TrajectoryHeader));
+    std::memcpy(m_header.magic, TRAJECTORY_MAGIC, sizeof(m_header.magic));
+    m_header.version = TRAJECTORY_VERSION;
+    m_header.dim = dim;
+    m_header.num_bodies = num_bodies;
+    m_header.timestep = timestep;
+    m_header.scalar_size = single_precision ? sizeof(float) : sizeof(double);
+    m_header.has_velocity = write_velocities;
+    m_header.metadata_size = metadata_str.size();
+
+    m_data_offset =
+        align_offset(sizeof(TrajectoryHeader) + m_header.metadata_size);
+    m_frame_times.clear();
+    m_frame_buffer.resize(frame_stride(m_header));
+
+    m_file.write(
+        reinterpret_cast<const char*>(&m_header), sizeof(TrajectoryHeader));
+    m_file.write(metadata_str.data(), metadata_str.size());
+    const char padding[8] = {};
+    m_file.write(
+        padding,
+        m_data_offset - sizeof(TrajectoryHeader) - m_header.metadata_size);
+    return bool(m_file);
+}
+
+template <typename Scalar>
+void TrajectoryWriter::write_dof(
+    const PosesD& poses, size_t num_bodies, char* data) const
+{
+    const int ndof = PoseD::dim_to_ndof(m_header.dim);
+    const size_t body_stride = m_header.has_velocity ? 2 * ndof : ndof;
+    for (size_t i = 0; i < num_bodies; i++) {
+        Scalar* body_data = reinterpret_cast<Scalar*>(data) + i * body_stride;
+        if (i < poses.size()) {
+            VectorMax6d dof = poses[i].dof();
+            for (int j = 0; j < ndof; j++) {
+                body_data[j] = Scalar(dof[j]);
+            }
+        } else {
+            std::fill(body_data, body_data + ndof, Scalar(0));
+        }
+    }
+}
+
+bool TrajectoryWriter::write_frame(
+    double time, const PosesD& poses, const PosesD& velocities)
+{
+    assert(is_open());
+    assert(poses.size() == m_header.num_bodies);
+
+    const size_t num_bodies = m_header.num_bodies;
+    const size_t ndof = PoseD::dim_to_ndof(m_header.dim);
+    char* data = m_frame_buffer.data();
+    if (m_header.scalar_size == sizeof(float)) {
+        write_dof<float>(poses, num_bodies, data);
+        if (m_header.has_velocity) {
+            write_dof<float>(velocities, num_bodies, data + ndof * 4);
+        }
+    } else {
+        write_dof<double>(poses, num_bodies, data);
+        if (m_header.has_velocity) {
+            write_dof<double>(velocities, num_bodies, data + ndof * 8);
+        }
+    }
+
+    // Flush complete frames so an unfinished file can be recovered
+    m_file.write(data, m_frame_buffer.size()).flush();
+    m_frame_times.push_back(time);
+    return bool(m_file);
+}
+
+bool TrajectoryWriter::close()
+{
+    if (!m_file.is_open()) {
+        return true;
+    }
+
+    // Index of the frames
+    const size_t stride = m_frame_buffer.size();
+    std::vector<TrajectoryIndexEntry> index(m_frame_times.size());
+    for (size_t i = 0; i < index.size(); i++) {
+        index[i].offset = m_data_offset + i * stride;
+        index[i].time = m_frame_times[i];
+    }
+    m_header.num_frames = index.size();
+    m_header.index_offset = m_data_offset + index.size() * stride;
+    m_file.write(
+        reinterpret_cast<const char*>(index.data()),
+        index.size() * sizeof(TrajectoryIndexEntry));
+
+    // Finish the header
+    m_file.seekp(0);
+    m_file.write(
+        reinterpret_cast<const char*>(&m_header), sizeof(TrajectoryHeader));
+
+    bool success = bool(m_file);
+    m_file.close();
+    return success;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader
+
+bool TrajectoryReader::open(const std::string& filename)
+{
+    close();
+
+    if (!m_file.open(filename)) {
+        spdlog::error("Unable to open trajectory file: {}", filename);
+        return false;
+    }
+
+    if (m_file.size() < sizeof(TrajectoryHeader)) {
+        spdlog::error("Invalid trajectory file: {}", filename);
+        close();
+        return false;
+    }
+    std::memcpy(&m_header, m_file.data(), sizeof(TrajectoryHeader));
+    if (std::memcmp(m_header.magic, TRAJECTORY_MAGIC, sizeof(m_header.magic))
+            != 0
+        || m_header.version != TRAJECTORY_VERSION
+        || (m_header.dim != 2 && m_header.dim != 3)
+        || (m_header.scalar_size != sizeof(float)
+            && m_header.scalar_size != sizeof(double))
+        // The frame stride must not overflow
+        || m_header.num_bodies > std::numeric_limits<uint64_t>::max()
+                / (2 * PoseD::dim_to_ndof(3) * sizeof(double))
+        || m_header.metadata_size
+            > m_file.size() - sizeof(TrajectoryHeader)) {
+        spdlog::error("Invalid trajectory file: {}", filename);
+        close();
+        return false;
+    }
+
+    const char* metadata = m_file.data() + sizeof(TrajectoryHeader);
+    m_metadata = nlohmann::json::parse(
+        metadata, metadata + m_header.metadata_size, nullptr, false);
+    if (m_metadata.is_discarded()) {
+        m_metadata = nlohmann::json::object();
+    }
+
+    m_data_offset =
+        align_offset(sizeof(TrajectoryHeader) + m_header.metadata_size);
+    m_frame_stride = frame_stride(m_header);
+    if (m_header.index_offset != 0) {
+        // The frames and the index of a closed file must be inside of it
+        const uint64_t num_frames = m_header.num_frames;
+        const uint64_t index_offset = m_header.index_offset;
+        if (index_offset < m_data_offset || index_offset > m_file.size()
+            || (m_frame_stride > 0
+                && num_frames
+                    > (index_offset - m_data_offset) / m_frame_stride)
+            || num_frames > (m_file.size() - index_offset)
+                    / sizeof(TrajectoryIndexEntry)) {
+            spdlog::error("Invalid trajectory file: {}", filename);
+            close();
+            return false;
+        }
+        m_num_frames = num_frames;
+    } else if (m_frame_stride > 0 && m_file.size() > m_data_offset) {
+        // Not closed (e.g., the run crashed), so keep the complete frames
+        m_num_frames = (m_file.size() - m_data_offset) / m_frame_stride;
+        spdlog::warn(
+            "Trajectory file was not closed; recovered {:d} frames",
+            m_num_frames);
+    } else {
+        m_num_frames = 0;
+    }
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+    m_file.close();
+    m_num_frames = 0;
+}
+
+double TrajectoryReader::time(size_t frame) const
+{
+    assert(frame < m_num_frames);
+    if (m_header.index_offset == 0) {
+        return frame * m_header.timestep;
+    }
+    TrajectoryIndexEntry entry;
+    std::memcpy(
+        &entry,
+        m_file.data() + m_header.index_offset
+            + frame * sizeof(TrajectoryIndexEntry),
+        sizeof(TrajectoryIndexEntry));
+    return entry.time;
+}
+
+PoseD TrajectoryReader::read_body_dof(
+    size_t frame, size_t body, size_t offset) const
+{
+    assert(frame < m_num_frames && body < m_header.num_bodies);
+    const int ndof = PoseD::dim_to_ndof(m_header.dim);
+    const size_t body_stride = m_header.has_velocity ? 2 * ndof : ndof;
+    const size_t start = body * body_stride + offset;
+    const char* data =
+        m_file.data() + m_data_offset + frame * m_frame_stride;
+
+    VectorMax6d dof(ndof);
+    for (int j = 0; j < ndof; j++) {
+        if (m_header.scalar_size == sizeof(float)) {
+            dof[j] = reinterpret_cast<const float*>(data)[start + j];
+        } else {
+            dof[j] = reinterpret_cast<const double*>(data)[start + j];
+        }
+    }
+    return PoseD(dof);
+}
+
+PosesD TrajectoryReader::read_dof(size_t frame, size_t offset) const
+{
+    PosesD poses(m_header.num_bodies);
+    for (size_t i = 0; i < poses.size(); i++) {
+        poses[i] = read_body_dof(frame, i, offset);
+    }
+    return poses;
+}
+
+PosesD TrajectoryReader::poses(size_t frame) const
+{
+    return read_dof(frame, 0);
+}
+
+PoseD TrajectoryReader::pose(size_t frame, size_t body) const
+{
+    return read_body_dof(frame, body, 0);
+}
+
+PosesD TrajectoryReader::velocities(size_t frame) const
+{
+    if (!m_header.has_velocity) {
+        return PosesD(m_header.num_bodies, PoseD::Zero(m_header.dim));
+    }
+    return read_dof(frame, PoseD::dim_to_ndof(m_header.dim));
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <io/mapped_file.hpp>
+#include <physics/pose.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Header of a binary trajectory file (.traj).
+ *
+ * The header is followed by the JSON metadata (e.g., the simulation
+ * arguments), the frames, and an index of the frames. Every frame has the same
+ * stride: for each body its pose dof and, optionally, its velocity dof stored
+ * as float32 or float64. The index holds the offset and time of each frame.
+ * The frame count and index are written when the file is closed, so the
+ * frames of an unfinished file are recovered from its size.
+ */
+struct TrajectoryHeader {
+    char magic[8];          ///< "RIPCTRAJ"
+    uint32_t version;       ///< Version of the format
+    uint32_t dim;           ///< Dimension of the scene (2 or 3)
+    uint64_t num_bodies;    ///< Number of bodies in each frame
+    double timestep;        ///< Timestep of the simulation
+    uint32_t scalar_size;   ///< Bytes per scalar (4 or 8)
+    uint32_t has_velocity;  ///< Do frames hold the velocities?
+    uint64_t num_frames;    ///< Number of frames (0 if not closed)
+    uint64_t index_offset;  ///< Offset of the frame index (0 if not closed)
+    uint64_t metadata_size; ///< Bytes of the JSON metadata
+};
+static_assert(sizeof(TrajectoryHeader) == 64);
+
+/// @brief Write a binary trajectory one frame at a time.
+class TrajectoryWriter {
+public:
+    ~TrajectoryWriter() { close(); }
+
+    /// @brief Create the file and write the header and metadata.
+    bool open(
+        const std::string& filename,
+        int dim,
+        size_t num_bodies,
+        double timestep,
+        const nlohmann::json& metadata,
+        bool single_precision = false,
+        bool write_velocities = true);
+
+    /// @brief Append a frame (velocities are ignored if not written).
+    bool write_frame(
+        double time, const PosesD& poses, const PosesD& velocities = {});
+
+    /// @brief Write the index and finish the header.
+    bool close();
+
+    bool is_open() const { return m_file.is_open(); }
+    /// @brief Name of the file (kept after it is closed).
+    const std::string& filename() const { return m_filename; }
+
+protected:
+    template <typename Scalar>
+    void write_dof(const PosesD& poses, size_t num_bodies, char* data) const;
+
+    std::ofstream m_file;
+    std::string m_filename;
+    TrajectoryHeader m_header;
+    uint64_t m_data_offset;
+    std::vector<double> m_frame_times;
+    std::vector<char> m_frame_buffer;
+};
+
+/// @brief Memory-mapped reader of a binary trajectory with O(1) access to
+/// any frame.
+class TrajectoryReader {
+public:
+    TrajectoryReader() = default;
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+    ~TrajectoryReader() { close(); }
+
+    bool open(const std::string& filename);
+    void close();
+
+    int dim() const { return m_header.dim; }
+    size_t num_bodies() const { return m_header.num_bodies; }
+    double timestep() const { return m_header.timestep; }
+    size_t num_frames() const { return m_num_frames; }
+    bool has_velocity() const { return m_header.has_velocity; }
+    const nlohmann::json& metadata() const { return m_metadata; }
+
+    /// @brief Time of a frame.
+    double time(size_t frame) const;
+    /// @brief Poses of the bodies in a frame.
+    PosesD poses(size_t frame) const;
+    /// @brief Pose of a single body in a frame.
+    PoseD pose(size_t frame, size_t body) const;
+    /// @brief Velocities of the bodies in a frame (zero if not stored).
+    PosesD velocities(size_t frame) const;
+
+protected:
+    /// @brief Read the dof of every body at an offset (in scalars) of their
+    /// records in a frame.
+    PosesD read_dof(size_t frame, size_t offset) const;
+    /// @brief Read the dof of a body at an offset (in scalars) of its record
+    /// in a frame.
+    PoseD read_body_dof(size_t frame, size_t body, size_t offset) const;
+
+    MappedFile m_file;
+
+    TrajectoryHeader m_header;
+    nlohmann::json m_metadata;
+    uint64_t m_data_offset = 0;
+    size_t m_frame_stride = 0;
+    size_t m_num_frames = 0;
+};
+
+} // namespace ipc::rigid
@@ -1,232 +1,396 @@
 #include "write_gltf.hpp"
 
-#define TINYGLTF_IMPLEMENTATION
-#define TINYGLTF_NO_INCLUDE_JSON
-#define TINYGLTF_NO_STB_IMAGE
-#define TINYGLTF_NO_STB_IMAGE_WRITE
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+
+#include <ghc/fs_std.hpp> // filesystem
 #include <nlohmann/json.hpp>
-#include <tiny_gltf.h>
+
+#include <logger.hpp>
 
 namespace ipc::rigid {
 
+void gltf_transform(const PoseD& pose, float* transform)
+{
+    assert(pose.dim() == 3);
+    const Eigen::Quaternion<double> q = pose.construct_quaternion();
+    transform[0] = float(pose.position.x());
+    transform[1] = float(pose.position.y());
+    transform[2] = float(pose.position.z());
+    transform[3] = float(q.x());
+    transform[4] = float(q.y());
+    transform[5] = float(q.z());
+    transform[6] = float(q.w());
+}
+
+void GltfAnimation::clear()
+{
+    m_num_bodies = 0;
+    m_transforms.clear();
+}
+
+void GltfAnimation::push_back(const PosesD& poses)
+{
+    assert(num_frames() == 0 || poses.size() == m_num_bodies);
+    m_num_bodies = poses.size();
+    const size_t start = m_transforms.size();
+    m_transforms.resize(start + 7 * poses.size());
+    for (size_t i = 0; i < poses.size(); i++) {
+        gltf_transform(poses[i], &m_transforms[start + 7 * i]);
+    }
+}
+
+namespace {
+    // Constants of the glTF 2.0 specification
+    const int GLTF_FLOAT = 5126;
+    const int GLTF_UNSIGNED_INT = 5125;
+    const int GLTF_TRIANGLES = 4;
+    const int GLTF_ARRAY_BUFFER = 34962;
+    const int GLTF_ELEMENT_ARRAY_BUFFER = 34963;
+    const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+    const uint32_t GLB_JSON_CHUNK = 0x4E4F534A; // "JSON"
+    const uint32_t GLB_BIN_CHUNK = 0x004E4942;  // "BIN"
+    /// Placeholder for the embedded buffer in the JSON
+    const char* EMBEDDED_BUFFER_URI = "@BUFFER@";
+
+    /// Writes the binary buffer through a staging buffer, as raw bytes or
+    /// encoded in base64 (for buffers embedded in the JSON).
+    class BufferWriter {
+    public:
+        BufferWriter(std::ostream& out, bool encode_base64)
+            : m_out(out)
+            , m_encode_base64(encode_base64)
+        {
+            m_staging.reserve(STAGING_SIZE);
+        }
+
+        template <typename T> void write(const T& value)
+        {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            m_staging.insert(m_staging.end(), bytes, bytes + sizeof(T));
+            if (m_staging.size() >= STAGING_SIZE) {
+                flush(/*is_last=*/false);
+            }
+        }
+
+        /// Write the staged bytes (base64 keeps a partial group until last).
+        void flush(bool is_last = true)
+        {
+            if (!m_encode_base64) {
+                m_out.write(m_staging.data(), m_staging.size());
+                m_staging.clear();
+                return;
+            }
+
+            static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                          "abcdefghijklmnopqrstuvwxyz"
+                                          "0123456789+/";
+            const size_t num_groups = is_last ? (m_staging.size() + 2) / 3
+                                              : m_staging.size() / 3;
+            std::string encoded;
+            encoded.reserve(4 * num_groups);
+            for (size_t i = 0; i < num_groups; i++) {
+                const size_t n = std::min<size_t>(3, m_staging.size() - 3 * i);
+                uint32_t group = 0;
+                for (size_t j = 0; j < n; j++) {
+                    group |= uint32_t(uint8_t(m_staging[3 * i + j]))
+                        << (16 - 8 * j);
+                }
+                for (size_t j = 0; j < 4; j++) {
+                    encoded.push_back(
+                        j <= n ? alphabet[(group >> (18 - 6 * j)) & 0x3F]
+                               : '=');
+                }
+            }
+            m_out << encoded;
+            m_staging.erase(
+                m_staging.begin(),
+                m_staging.begin()
+                    + std::min(3 * num_groups, m_staging.size()));
+        }
+
+    protected:
+        static constexpr size_t STAGING_SIZE = 3 << 18; // 768 KiB
+        std::ostream& m_out;
+        bool m_encode_base64;
+        std::vector<char> m_staging;
+    };
+} // namespace
+
 bool write_gltf(
     const std::string& filename,
     const RigidBodyAssembler& bodies,
-    const std::vector<PosesD>& poses,
+    size_t num_frames,
+    const GltfTransformReader& read_transform,
     double timestep,
     bool embed_buffers,
     bool write_binary,
     bool prettyPrint)
 {
-    typedef float Float;
-    int float_component_type;
-    if (std::is_same<Float, float>::value) {
-        float_component_type = TINYGLTF_COMPONENT_TYPE_FLOAT;
-    } else {
-        // assert(std::is_same<Float, double>::value);
-        float_component_type = TINYGLTF_COMPONENT_TYPE_DOUBLE;
+    using nlohmann::json;
+
+    assert(bodies.dim() == 3);
+    const size_t num_bodies = bodies.num_bodies();
+    const size_t num_steps = num_frames;
+    assert(num_steps > 0);
+
+    // The first frame is the rest transform of the nodes
+    std::vector<float> rest_transforms(7 * num_bodies);
+    for (size_t i = 0; i < num_bodies; i++) {
+        read_transform(0, i, &rest_transforms[7 * i]);
+    }
+
+    // The buffer holds the meshes, the times, and then the translations and
+    // rotations of each body, so the layout (and the JSON describing it) is
+    // known before any data is written.
+    json accessors = json::array(), buffer_views = json::array();
+    uint64_t byte_length = 0;
+    const auto add_view = [&](const std::string& name, uint64_t view_length,
+                              int target) {
+        json view = { { "name", name },
+                      { "buffer", 0 },
+                      { "byteOffset", byte_length },
+                      { "byteLength", view_length } };
+        if (target) {
+            view["target"] = target;
+        }
+        buffer_views.push_back(view);
+        byte_length += view_length;
+        return buffer_views.size() - 1;
+    };
+    const auto add_accessor = [&](const std::string& name, size_t view,
+                                  int component_type, size_t count,
+                                  const std::string& type) {
+        accessors.push_back({ { "name", name },
+                              { "bufferView", view },
+                              { "componentType", component_type },
+                              { "count", count },
+                              { "type", type } });
+        return accessors.size() - 1;
+    };
+
+    json nodes = json::array(), meshes = json::array();
+    for (size_t i = 0; i < num_bodies; i++) {
+        const RigidBody& body = bodies[i];
+        const float* transform = &rest_transforms[7 * i];
+        json node = { { "name", body.name },
+                      { "translation",
+                        { transform[0], transform[1], transform[2] } },
+                      { "rotation",
+                        { transform[3], transform[4], transform[5],
+                          transform[6] } } };
+
+        // Bodies without faces (e.g., codimensional) only have a transform
+        if (body.num_faces() > 0) {
+            size_t vertices = add_accessor(
+                body.name + "Vertices",
+                add_view(
+                    body.name + "Vertices",
+                    sizeof(float) * body.vertices().size(), GLTF_ARRAY_BUFFER),
+                GLTF_FLOAT, body.num_vertices(), "VEC3");
+            const Eigen::RowVector3d min = body.vertices().colwise().minCoeff();
+            const Eigen::RowVector3d max = body.vertices().colwise().maxCoeff();
+            accessors[vertices]["min"] = { float(min.x()), float(min.y()),
+                                           float(min.z()) };
+            accessors[vertices]["max"] = { float(max.x()), float(max.y()),
+                                           float(max.z()) };
+            size_t faces = add_accessor(
+                body.name + "Faces",
+                add_view(
+                    body.name + "Faces", sizeof(uint32_t) * body.faces().size(),
+                    GLTF_ELEMENT_ARRAY_BUFFER),
+                GLTF_UNSIGNED_INT, body.faces().size(), "SCALAR");
+
+            node["mesh"] = meshes.size();
+            meshes.push_back(
+                { { "name", body.name },
+                  { "primitives",
+                    json::array(
+                        { { { "attributes", { { "POSITION", vertices } } },
+                            { "indices", faces },
+                            { "mode", GLTF_TRIANGLES } } }) } });
+        }
+        nodes.push_back(node);
     }
 
-    using namespace tinygltf;
+    size_t times = add_accessor(
+        "Times", add_view("Times", sizeof(float) * num_steps, 0), GLTF_FLOAT,
+        num_steps, "SCALAR");
+    accessors[times]["min"] = json::array({ 0.0 });
+    accessors[times]["max"] =
+        json::array({ float((num_steps - 1) * timestep) });
 
-    assert(bodies.dim() == 3);
-    size_t num_bodies = bodies.num_bodies();
-    assert(poses.size() > 0);
-    size_t num_steps = poses.size();
-
-    Model model;
-    model.defaultScene = 0;
-
-    model.asset.version = "2.0";
-    model.asset.generator = "RigidIPC";
-
-    Scene& scene = model.scenes.emplace_back();
-    scene.name = "RigidIPCSimulation";
-    scene.nodes.resize(num_bodies);
-    std::iota(scene.nodes.begin(), scene.nodes.end(), 0);
-
-    model.nodes.resize(num_bodies);
-    model.animations.resize(1);
-    Animation& animation = model.animations[0];
-    animation.name = "Simulation";
-    animation.channels.resize(2 * num_bodies);
-    animation.samplers.resize(2 * num_bodies);
-    model.meshes.resize(num_bodies);
-    // Four accessors per bidy: vertices, faces, translations, and rotations
-    model.accessors.resize(4 * num_bodies + 1);
-    {
-        Accessor& accessor = model.accessors[2 * num_bodies];
-        accessor.name = "Times";
-        accessor.bufferView = 2 * num_bodies;
-        accessor.componentType = float_component_type;
-        accessor.count = num_steps;
-        accessor.minValues.push_back(timestep);
-        accessor.maxValues.push_back(num_steps * timestep);
-        accessor.type = TINYGLTF_TYPE_SCALAR;
+    json channels = json::array(), samplers = json::array();
+    for (size_t i = 0; i < num_bodies; i++) {
+        const std::string& name = bodies[i].name;
+        size_t translations = add_accessor(
+            name + "Translations",
+            add_view(name + "Translations", 3 * sizeof(float) * num_steps, 0),
+            GLTF_FLOAT, num_steps, "VEC3");
+        size_t rotations = add_accessor(
+            name + "Rotations",
+            add_view(name + "Rotations", 4 * sizeof(float) * num_steps, 0),
+            GLTF_FLOAT, num_steps, "VEC4");
+
+        channels.push_back(
+            { { "sampler", samplers.size() },
+              { "target", { { "node", i }, { "path", "translation" } } } });
+        samplers.push_back({ { "input", times },
+                             { "output", translations },
+                             { "interpolation", "LINEAR" } });
+        channels.push_back(
+            { { "sampler", samplers.size() },
+              { "target", { { "node", i }, { "path", "rotation" } } } });
+        samplers.push_back({ { "input", times },
+                             { "output", rotations },
+                             { "interpolation", "LINEAR" } });
     }
 
-    for (int i = 0; i < num_bodies; i++) {
-        Node& node = model.nodes[i];
-        node.mesh = i;
-        node.name = bodies[i].name;
-        node.translation = { { poses[0][i].position.x(),
-                               poses[0][i].position.y(),
-                               poses[0][i].position.z() } };
-        Eigen::Quaternion<double> q = poses[0][i].construct_quaternion();
-        node.rotation = { { q.x(), q.y(), q.z(), q.w() } };
-
-        animation.channels[2 * i + 0].sampler = 2 * i;
-        animation.channels[2 * i + 0].target_node = i;
-        animation.channels[2 * i + 0].target_path = "translation";
-        animation.channels[2 * i + 1].sampler = 2 * i + 1;
-        animation.channels[2 * i + 1].target_node = i;
-        animation.channels[2 * i + 1].target_path = "rotation";
-
-        animation.samplers[2 * i + 0].input = 2 * num_bodies;
-        animation.samplers[2 * i + 0].output = 2 * num_bodies + 2 * i + 1;
-        animation.samplers[2 * i + 0].interpolation = "LINEAR";
-        animation.samplers[2 * i + 1].input = 2 * num_bodies;
-        animation.samplers[2 * i + 1].output = 2 * num_bodies + 2 * i + 2;
-        animation.samplers[2 * i + 1].interpolation = "LINEAR";
-
-        Mesh& mesh = model.meshes[i];
-        mesh.name = bodies[i].name;
-        Primitive& primitive = mesh.primitives.emplace_back();
-        primitive.attributes["POSITION"] = 2 * i;
-        primitive.indices = 2 * i + 1;
-        primitive.mode = TINYGLTF_MODE_TRIANGLES;
-
-        Accessor* accessor = &model.accessors[2 * i];
-        accessor->name = bodies[i].name + "Vertices";
-        accessor->bufferView = 2 * i;
-        accessor->componentType = float_component_type;
-        accessor->count = bodies[i].num_vertices();
-        // accessor->max = ...;
-        // accessor->min = ...;
-        accessor->type = TINYGLTF_TYPE_VEC3;
-
-        accessor = &model.accessors[2 * i + 1];
-        accessor->name = bodies[i].name + "Faces";
-        accessor->bufferView = 2 * i + 1;
-        accessor->componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
-        accessor->count = 3 * bodies[i].num_faces();
-        accessor->type = TINYGLTF_TYPE_SCALAR;
-
-        accessor = &model.accessors[2 * num_bodies + 2 * i + 1];
-        accessor->name = bodies[i].name + "Translations";
-        accessor->bufferView = 2 * num_bodies + 2 * i + 1;
-        accessor->componentType = float_component_type;
-        accessor->count = num_steps;
-        accessor->type = TINYGLTF_TYPE_VEC3;
-
-        accessor = &model.accessors[2 * num_bodies + 2 * i + 2];
-        accessor->name = bodies[i].name + "Rotations";
-        accessor->bufferView = 2 * num_bodies + 2 * i + 2;
-        accessor->componentType = float_component_type;
-        accessor->count = num_steps;
-        accessor->type = TINYGLTF_TYPE_VEC4;
-
-        BufferView& buffer_view = model.bufferViews[2 * i];
+    std::vector<size_t> scene_nodes(num_bodies);
+    std::iota(scene_nodes.begin(), scene_nodes.end(), 0);
+
+    json buffer = { { "byteLength", byte_length } };
+    fs::path bin_path(filename);
+    bin_path.replace_extension(".bin");
+    if (!write_binary) {
+        buffer["uri"] = embed_buffers ? EMBEDDED_BUFFER_URI
+                                      : bin_path.filename().string();
     }
 
-    ///////////////////////////////////////////////////////////////////////////
-
-    model.bufferViews.resize(4 * num_bodies + 1);
-    size_t byte_offset = 0;
-    for (int i = 0; i < num_bodies; i++) {
-        BufferView* buffer_view = &model.bufferViews[2 * i];
-        buffer_view->name = bodies[i].name + "Vertices";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = sizeof(Float) * bodies[i].vertices.size();
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
-
-        buffer_view = &model.bufferViews[2 * i + 1];
-        buffer_view->name = bodies[i].name + "Faces";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = sizeof(unsigned int) * bodies[i].faces.size();
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
+    json gltf = {
+        { "asset", { { "version", "2.0" }, { "generator", "RigidIPC" } } },
+        { "scene", 0 },
+        { "scenes",
+          json::array({ { { "name", "RigidIPCSimulation" },
+                          { "nodes", scene_nodes } } }) },
+        { "nodes", nodes },
+        { "meshes", meshes },
+        { "animations",
+          json::array({ { { "name", "Simulation" },
+                          { "channels", channels },
+                          { "samplers", samplers } } }) },
+        { "accessors", accessors },
+        { "bufferViews", buffer_views },
+        { "buffers", json::array({ buffer }) },
+    };
+    std::string gltf_str = gltf.dump(prettyPrint ? 2 : -1);
+
+    if (write_binary) {
+        // The chunks are padded to four bytes (the buffer already is)
+        gltf_str.resize((gltf_str.size() + 3) & ~size_t(3), ' ');
+        // The lengths of a GLB file are 32-bit
+        const uint64_t glb_length = 12 + 8 + gltf_str.size() + 8 + byte_length;
+        if (glb_length > std::numeric_limits<uint32_t>::max()) {
+            spdlog::error(
+                "Animation is too large for a GLB file ({:d} bytes): {}",
+                glb_length, filename);
+            return false;
+        }
     }
-    {
-        BufferView& buffer_view = model.bufferViews[2 * num_bodies];
-        buffer_view.name = "Times";
-        buffer_view.buffer = 0;
-        buffer_view.byteLength = num_steps * sizeof(Float);
-        buffer_view.byteOffset = byte_offset;
-        byte_offset += buffer_view.byteLength;
+
+    std::ofstream file(filename, std::ios::binary);
+    std::ofstream bin_file;
+    if (!file) {
+        spdlog::error("Unable to open glTF file: {}", filename);
+        return false;
     }
-    for (int i = 0; i < num_bodies; i++) {
-        BufferView* buffer_view =
-            &model.bufferViews[2 * num_bodies + 2 * i + 1];
-        buffer_view->name = bodies[i].name + "Translations";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = 3 * sizeof(Float) * num_steps;
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
-
-        buffer_view = &model.bufferViews[2 * num_bodies + 2 * i + 2];
-        buffer_view->name = bodies[i].name + "Rotations";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = 4 * sizeof(Float) * num_steps;
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
+
+    std::ostream* buffer_out = &file;
+    if (write_binary) {
+        const uint32_t json_length = gltf_str.size();
+        const uint32_t bin_length = byte_length;
+        const uint32_t header[3] = { GLB_MAGIC, 2,
+                                     12 + 8 + json_length + 8 + bin_length };
+        const uint32_t json_header[2] = { json_length, GLB_JSON_CHUNK };
+        const uint32_t bin_header[2] = { bin_length, GLB_BIN_CHUNK };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(
+            reinterpret_cast<const char*>(json_header), sizeof(json_header));
+        file << gltf_str;
+        file.write(
+            reinterpret_cast<const char*>(bin_header), sizeof(bin_header));
+    } else if (embed_buffers) {
+        // Stream the encoded buffer in place of the placeholder
+        const size_t split = gltf_str.find(EMBEDDED_BUFFER_URI);
+        assert(split != std::string::npos);
+        file << gltf_str.substr(0, split)
+             << "data:application/octet-stream;base64,";
+        gltf_str.erase(0, split + std::strlen(EMBEDDED_BUFFER_URI));
+    } else {
+        file << gltf_str;
+        bin_file.open(bin_path.string(), std::ios::binary);
+        if (!bin_file) {
+            spdlog::error("Unable to open glTF buffer: {}", bin_path.string());
+            return false;
+        }
+        buffer_out = &bin_file;
     }
 
-    ///////////////////////////////////////////////////////////////////////////
-
-    std::vector<unsigned char> byte_data(byte_offset);
-    size_t byte_i = 0;
-    for (int i = 0; i < num_bodies; i++) {
-        Eigen::MatrixXd V = bodies[i].vertices;
-        for (int r = 0; r < V.rows(); r++) {
-            for (int c = 0; c < V.cols(); c++) {
-                Float v = V(r, c);
-                std::memcpy(&byte_data[byte_i], &v, sizeof(Float));
-                byte_i += sizeof(Float);
+    BufferWriter out(*buffer_out, !write_binary && embed_buffers);
+    for (size_t i = 0; i < num_bodies; i++) {
+        const RigidBody& body = bodies[i];
+        if (body.num_faces() == 0) {
+            continue;
+        }
+        for (int r = 0; r < body.vertices().rows(); r++) {
+            for (int c = 0; c < body.vertices().cols(); c++) {
+                out.write(float(body.vertices()(r, c)));
             }
         }
-
-        Eigen::MatrixXi F = bodies[i].faces;
-        for (int r = 0; r < F.rows(); r++) {
-            for (int c = 0; c < F.cols(); c++) {
-                unsigned int fij = F(r, c);
-                std::memcpy(&byte_data[byte_i], &fij, sizeof(unsigned int));
-                byte_i += sizeof(unsigned int);
+        for (int r = 0; r < body.faces().rows(); r++) {
+            for (int c = 0; c < body.faces().cols(); c++) {
+                out.write(uint32_t(body.faces()(r, c)));
             }
         }
     }
-    for (int i = 0; i < num_steps; i++) {
-        Float t = i * timestep;
-        std::memcpy(&byte_data[byte_i], &t, sizeof(Float));
-        byte_i += sizeof(Float);
+    for (size_t j = 0; j < num_steps; j++) {
+        out.write(float(j * timestep));
     }
-    for (int i = 0; i < num_bodies; i++) {
-        for (int j = 0; j < num_steps; j++) {
-            Eigen::Vector3d p = poses[j][i].position;
-            for (int d = 0; d < p.size(); d++) {
-                Float pd = p[d];
-                std::memcpy(&byte_data[byte_i], &pd, sizeof(Float));
-                byte_i += sizeof(Float);
+    // The translations and rotations of a body are contiguous, so each body
+    // is read once for each of them.
+    float transform[7];
+    for (size_t i = 0; i < num_bodies; i++) {
+        for (size_t j = 0; j < num_steps; j++) {
+            read_transform(j, i, transform);
+            for (int d = 0; d < 3; d++) {
+                out.write(transform[d]);
             }
         }
-
-        for (int j = 0; j < num_steps; j++) {
-            Eigen::Quaternion<double> quat = poses[j][i].construct_quaternion();
-            Eigen::Vector4d q(quat.x(), quat.y(), quat.z(), quat.w());
-            for (int d = 0; d < q.size(); d++) {
-                Float qd = q[d];
-                std::memcpy(&byte_data[byte_i], &qd, sizeof(Float));
-                byte_i += sizeof(Float);
+        for (size_t j = 0; j < num_steps; j++) {
+            read_transform(j, i, transform);
+            for (int d = 3; d < 7; d++) {
+                out.write(transform[d]);
             }
         }
     }
-    assert(byte_i == byte_data.size());
+    out.flush();
 
-    model.buffers.emplace_back().data = byte_data;
-    return TinyGLTF().WriteGltfSceneToFile(
-        &model, filename,
-        /*embedImages=*/true, embed_buffers, prettyPrint, write_binary);
+    if (!write_binary && embed_buffers) {
+        file << gltf_str; // Rest of the JSON
+    }
+    return bool(file) && (!bin_file.is_open() || bool(bin_file));
+}
+
+bool write_gltf(
+    const std::string& filename,
+    const RigidBodyAssembler& bodies,
+    const GltfAnimation& animation,
+    double timestep,
+    bool embed_buffers,
+    bool write_binary,
+    bool prettyPrint)
+{
+    assert(animation.num_bodies() == bodies.num_bodies());
+    return write_gltf(
+        filename, bodies, animation.num_frames(),
+        [&](size_t frame, size_t body, float* transform) {
+            std::copy_n(animation.transform(frame, body), 7, transform);
+        },
+        timestep, embed_buffers, write_binary, prettyPrint);
 }
 
 } // namespace ipc::rigid
@@ -1,15 +1,69 @@
 #pragma once
 
+#include <functional>
 #include <string>
+#include <vector>
 
 #include <physics/rigid_body_assembler.hpp>
 
 namespace ipc::rigid {
 
+/// @brief Convert a (3D) pose to a glTF transform: the translation (3 floats)
+/// followed by the (x, y, z, w) rotation quaternion (4 floats).
+void gltf_transform(const PoseD& pose, float* transform);
+
+/// @brief Transforms of the bodies in every frame of an animation, stored as
+/// glTF transforms.
+///
+/// Frames are recorded as they are computed, so exporting needs neither the
+/// saved states nor their poses.
+class GltfAnimation {
+public:
+    void clear();
+
+    /// @brief Record the (3D) poses of the bodies in the next frame.
+    void push_back(const PosesD& poses);
+
+    size_t num_bodies() const { return m_num_bodies; }
+    size_t num_frames() const
+    {
+        return m_num_bodies ? m_transforms.size() / (7 * m_num_bodies) : 0;
+    }
+
+    /// @brief Transform of a body in a frame.
+    const float* transform(size_t frame, size_t body) const
+    {
+        return m_transforms.data() + 7 * (frame * m_num_bodies + body);
+    }
+
+protected:
+    size_t m_num_bodies = 0;
+    std::vector<float> m_transforms;
+};
+
+/// @brief Read the glTF transform (7 floats) of a body in a frame.
+typedef std::function<void(size_t frame, size_t body, float* transform)>
+    GltfTransformReader;
+
+/// @brief Write the animation of the bodies to a glTF (or GLB) file.
+///
+/// The transforms are read as they are written, one body at a time, so the
+/// frames can come from a file without being loaded in memory.
+bool write_gltf(
+    const std::string& filename,
+    const RigidBodyAssembler& bodies,
+    size_t num_frames,
+    const GltfTransformReader& read_transform,
+    double timestep,
+    bool embed_buffers = true,
+    bool write_binary = true,
+    bool prettyPrint = true);
+
+/// @brief Write a recorded animation of the bodies to a glTF (or GLB) file.
 bool write_gltf(
     const std::string& filename,
     const RigidBodyAssembler& bodies,
-    const std::vector<PosesD>& poses,
+    const GltfAnimation& animation,
     double timestep,
     bool embed_buffers = true,
     bool write_binary = true,
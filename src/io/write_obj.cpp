@@ -51,6 +51,20 @@ bool write_obj(
 bool write_obj(
     const std::string str, const SimulationProblem& problem, bool write_mtl)
 {
+    std::vector<Eigen::MatrixXd> body_vertices(problem.num_bodies());
+    for (int i = 0; i < problem.num_bodies(); i++) {
+        body_vertices[i] = problem.vertices(i);
+    }
+    return write_obj(str, problem, body_vertices, write_mtl);
+}
+
+bool write_obj(
+    const std::string str,
+    const SimulationProblem& problem,
+    const std::vector<Eigen::MatrixXd>& body_vertices,
+    bool write_mtl)
+{
+    assert(body_vertices.size() == problem.num_bodies());
     std::ofstream s(str);
     if (!s.is_open()) {
         spdlog::error("IOError: write_obj() could not open {}", str);
@@ -71,7 +85,7 @@ bool write_obj(
 
     size_t start_vi = 1;
     for (int i = 0; i < problem.num_bodies(); i++) {
-        Eigen::MatrixXd V = problem.vertices(i);
+        const Eigen::MatrixXd& V = body_vertices[i];
         const auto& F = problem.faces(i);
         const auto& E = problem.edges(i);
         if (F.rows() == 0 && E.rows() == 0) {
@@ -30,4 +30,12 @@ bool write_obj(
     const SimulationProblem& problem,
     bool write_mtl);
 
+/// Write the bodies of a problem at the given world vertices of each body
+/// (e.g., a snapshot of an earlier state).
+bool write_obj(
+    const std::string str,
+    const SimulationProblem& problem,
+    const std::vector<Eigen::MatrixXd>& body_vertices,
+    bool write_mtl);
+
 } // namespace ipc::rigid
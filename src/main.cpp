@@ -9,6 +9,7 @@
 #include <ghc/fs_std.hpp> // filesystem
 
 #include <SimState.hpp>
+#include <io/geometry_cache.hpp>
 #ifdef RIGID_IPC_WITH_OPENGL
 #include <viewer/UISimState.hpp>
 #endif
@@ -55,6 +56,18 @@ int main(int argc, char* argv[])
         "--chkpt,--checkpoint-frequency", checkpoint_freq,
         "number of time-steps between checkpoints (ngui only)");
 
+    bool stream_states = false;
+    app.add_flag(
+        "--stream", stream_states,
+        "write the states to disk as they are computed (ngui only)");
+
+    std::string trajectory_precision = "none";
+    app.add_option(
+           "--trajectory", trajectory_precision,
+           "write a binary trajectory of the poses and velocities (ngui only)")
+        ->check(CLI::IsMember({ "none", "float32", "float64" }))
+        ->default_val(trajectory_precision);
+
     spdlog::level::level_enum loglevel = spdlog::level::info;
     app.add_option("--log,--loglevel", loglevel, "log level")
         ->default_val(loglevel)
@@ -65,6 +78,12 @@ int main(int argc, char* argv[])
     app.add_option("--nthreads", nthreads, "maximum number of threads to use")
         ->default_val(nthreads);
 
+    std::string geometry_cache = geometry_cache_directory();
+    app.add_option(
+           "--geometry-cache", geometry_cache,
+           "directory caching the processed meshes (empty to disable)")
+        ->default_val(geometry_cache);
+
     std::string patch = "";
     app.add_option("--patch", patch, "patch to input file (ngui only)")
         ->default_val(patch);
@@ -72,6 +91,7 @@ int main(int argc, char* argv[])
     CLI11_PARSE(app, argc, argv);
 
     set_logger_level(loglevel);
+    set_geometry_cache_directory(geometry_cache);
 
     if (nthreads <= 0) {
         nthreads = tbb::task_scheduler_init::default_num_threads();
@@ -127,6 +147,10 @@ int main(int argc, char* argv[])
             sim.m_checkpoint_frequency = checkpoint_freq;
         }
 
+        sim.m_stream_states = stream_states;
+        sim.m_write_trajectory = trajectory_precision != "none";
+        sim.m_trajectory_single_precision = trajectory_precision == "float32";
+
         sim.run_simulation(fout);
     }
 }
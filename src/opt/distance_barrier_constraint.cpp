@@ -1,5 +1,6 @@
 #include "distance_barrier_constraint.hpp"
 
+#include <atomic>
 #include <mutex>
 #include <tbb/parallel_for_each.h>
 
@@ -157,106 +158,82 @@ double DistanceBarrierConstraint::compute_earliest_toi_narrow_phase(
     NAMED_PROFILE_POINT(
         "DistanceBarrierConstraint::compute_earliest_toi_narrow_phase",
         NARROW_PHASE);
-    // NOTE: These are disabled because they are not thread safe
-    // NAMED_PROFILE_POINT(
-    //     "DistanceBarrierConstraint::compute_earliest_toi_narrow_phase:"
-    //     "edge_edge",
-    //     FV_NARROW_PHASE);
-    // NAMED_PROFILE_POINT(
-    //     "DistanceBarrierConstraint::compute_earliest_toi_narrow_phase:"
-    //     "face_vertex",
-    //     EE_NARROW_PHASE);
-    // NAMED_PROFILE_POINT(
-    //     "DistanceBarrierConstraint::compute_earliest_toi_narrow_phase:"
-    //     "edge_vertex",
-    //     EV_NARROW_PHASE);
+    // The candidates of each type are profiled in
+    // detect_body_pair_collisions().
 
     PROFILE_START(NARROW_PHASE);
 
     int collision_count = 0;
+    std::atomic<size_t> filtered_count(0);
     double earliest_toi = 1;
     std::mutex earliest_toi_mutex;
 
-    const size_t num_ev = candidates.ev_candidates.size();
-    const size_t num_ee = candidates.ee_candidates.size();
-    const size_t num_fv = candidates.fv_candidates.size();
-
-    // Do a single block range over all three candidate vectors
-    tbb::parallel_for(
-        tbb::blocked_range<int>(0, candidates.size()),
-        [&](tbb::blocked_range<int> r) {
-            for (int i = r.begin(); i < r.end(); i++) {
-                double toi = std::numeric_limits<double>::infinity();
-                bool are_colliding;
-
-                if (i < num_ev) {
-                    // PROFILE_START(EV_NARROW_PHASE);
-                    are_colliding = edge_vertex_ccd(
-                        bodies, poses_t0, poses_t1, candidates.ev_candidates[i],
-                        toi, trajectory_type, earliest_toi,
-                        minimum_separation_distance);
-                    // PROFILE_END(EV_NARROW_PHASE);
-                } else if (i - num_ev < num_ee) {
-                    // PROFILE_START(EE_NARROW_PHASE);
-                    are_colliding = edge_edge_ccd(
-                        bodies, poses_t0, poses_t1,
-                        candidates.ee_candidates[i - num_ev], toi,
-                        trajectory_type, earliest_toi,
-                        minimum_separation_distance);
-                    // PROFILE_END(EE_NARROW_PHASE);
-                } else {
-                    assert(i - num_ev - num_ee < num_fv);
-                    // PROFILE_START(FV_NARROW_PHASE);
-                    are_colliding = face_vertex_ccd(
-                        bodies, poses_t0, poses_t1,
-                        candidates.fv_candidates[i - num_ev - num_ee], toi,
-                        trajectory_type, earliest_toi,
-                        minimum_separation_distance);
-                    // PROFILE_END(FV_NARROW_PHASE);
-                }
+    std::vector<BodyPairCandidates> body_pairs;
+    group_candidates_by_body_pair(bodies, candidates, body_pairs);
+
+    // Process all candidates of a body pair as a single task
+    tbb::parallel_for_each(
+        body_pairs, [&](const BodyPairCandidates& body_pair) {
+            double pair_earliest_toi;
+            {
+                std::scoped_lock lock(earliest_toi_mutex);
+                pair_earliest_toi = earliest_toi;
+            }
 
-                if (are_colliding && toi == 0) {
-                    if (i < num_ev) {
+            const auto on_impact = [&](int collision_type, size_t ci,
+                                       double toi) {
+                if (toi == 0) {
+                    switch (collision_type) {
+                    case CollisionType::EDGE_VERTEX:
                         spdlog::error("Edge-vertex CCD resulted in toi=0!");
                         save_ccd_candidate(
                             bodies, poses_t0, poses_t1,
-                            candidates.ev_candidates[i]);
-                    } else if (i - num_ev < num_ee) {
+                            candidates.ev_candidates[ci]);
+                        break;
+                    case CollisionType::EDGE_EDGE:
                         spdlog::error("Edge-edge CCD resulted in toi=0!");
                         save_ccd_candidate(
                             bodies, poses_t0, poses_t1,
-                            candidates.ee_candidates[i - num_ev]);
-                    } else {
-                        assert(i - num_ev - num_ee < num_fv);
+                            candidates.ee_candidates[ci]);
+                        break;
+                    case CollisionType::FACE_VERTEX:
                         spdlog::error("Face-vertex CCD resulted in toi=0!");
                         save_ccd_candidate(
                             bodies, poses_t0, poses_t1,
-                            candidates.fv_candidates[i - num_ev - num_ee]);
+                            candidates.fv_candidates[ci]);
+                        break;
                     }
                 }
 
-                if (are_colliding) {
-                    std::scoped_lock lock(earliest_toi_mutex);
-                    collision_count++;
-                    if (toi < earliest_toi) {
-                        earliest_toi = toi;
-                    }
+                std::scoped_lock lock(earliest_toi_mutex);
+                collision_count++;
+                if (toi < earliest_toi) {
+                    earliest_toi = toi;
                 }
-            }
+                // Shrink the search interval of the remaining candidates
+                pair_earliest_toi = earliest_toi;
+            };
+
+            filtered_count += detect_body_pair_collisions(
+                bodies, poses_t0, poses_t1, candidates, body_pair,
+                trajectory_type, on_impact, pair_earliest_toi,
+                minimum_separation_distance);
         });
 
     double percent_correct = candidates.size() == 0
         ? 100
         : (double(collision_count) / candidates.size() * 100);
     PROFILE_MESSAGE(
-        NARROW_PHASE, "num_candidates,num_collisions,percentage",
+        NARROW_PHASE, "num_candidates,num_filtered,num_collisions,percentage",
         fmt::format(
-            "{:d},{:d},{:g}%", candidates.size(), collision_count,
-            percent_correct));
+            "{:d},{:d},{:d},{:g}%", candidates.size(), filtered_count.load(),
+            collision_count, percent_correct));
 
     spdlog::debug(
-        "num_candidates={:d} num_collisions={:d} percentage={:g}%",
-        candidates.size(), collision_count, percent_correct);
+        "num_candidates={:d} num_filtered={:d} num_collisions={:d} "
+        "percentage={:g}%",
+        candidates.size(), filtered_count.load(), collision_count,
+        percent_correct);
 
     PROFILE_END(NARROW_PHASE);
 
@@ -271,14 +248,19 @@ void DistanceBarrierConstraint::construct_constraint_set(
 {
     static PosesD cached_poses;
     static Constraints cached_constraint_set;
+    // The objective can be evaluated from multiple threads (line search)
+    static std::mutex cache_mutex;
 
     if (bodies.num_bodies() <= 1) {
         return;
     }
 
-    if (poses == cached_poses) {
-        constraint_set = cached_constraint_set;
-        return;
+    {
+        std::scoped_lock lock(cache_mutex);
+        if (poses == cached_poses) {
+            constraint_set = cached_constraint_set;
+            return;
+        }
     }
 
     PROFILE_POINT("DistanceBarrierConstraint::construct_constraint_set");
@@ -301,6 +283,7 @@ void DistanceBarrierConstraint::construct_constraint_set(
 
     PROFILE_END();
 
+    std::scoped_lock lock(cache_mutex);
     cached_poses = poses;
     cached_constraint_set = constraint_set;
 }
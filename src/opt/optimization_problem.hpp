@@ -56,18 +56,39 @@ public:
     /// @returns A vector of booleans indicating if a DoF is fixed.
     virtual const VectorXb& is_dof_fixed() const = 0;
 
-    virtual Eigen::VectorXi free_dof() const
+    /// @returns The number of consecutive DoF that are coupled (e.g., the DoF
+    ///          of a body).
+    virtual int dof_block_size() const { return 1; }
+
+    /// @brief Fill-reducing ordering of the DoF blocks for factorizing the
+    ///        Hessian at x (e.g., from the contacts between bodies).
+    /// @return False if the problem does not provide an ordering.
+    virtual bool
+    dof_block_ordering(const Eigen::VectorXd& x, std::vector<int>& order)
+    {
+        return false;
+    }
+
+    /// @returns The DoF that are not fixed (see free_dof_version()).
+    virtual const Eigen::VectorXi& free_dof() const
     {
-        const VectorXb& is_fixed = is_dof_fixed();
-        Eigen::VectorXi free_dof(is_fixed.size() - is_fixed.count());
-        for (int i = 0, j = 0; i < is_fixed.size(); i++) {
-            if (!is_fixed(i)) {
-                free_dof(j++) = i;
+        // The fixed DoF are constant by default, so they are gathered once.
+        if (!m_is_default_free_dof_set) {
+            const VectorXb& is_fixed = is_dof_fixed();
+            m_default_free_dof.resize(is_fixed.size() - is_fixed.count());
+            for (int i = 0, j = 0; i < is_fixed.size(); i++) {
+                if (!is_fixed(i)) {
+                    m_default_free_dof(j++) = i;
+                }
             }
+            m_is_default_free_dof_set = true;
         }
-        return free_dof;
+        return m_default_free_dof;
     }
 
+    /// @returns A counter incremented every time the free DoF change.
+    virtual size_t free_dof_version() const { return 0; }
+
     /// Determine if there is a collision between two configurations
     virtual bool
     has_collisions(const Eigen::VectorXd& xi, const Eigen::VectorXd& xj) = 0;
@@ -96,8 +117,16 @@ public:
     /// Get the time-step
     virtual double timestep() const = 0;
 
+    /// Can compute_objective be called from multiple threads at once?
+    virtual bool is_objective_thread_safe() const { return false; }
+
     virtual bool is_barrier_problem() const { return false; }
     virtual bool is_constrained_problem() const { return false; }
+
+private:
+    /// Free DoF of the default free_dof()
+    mutable Eigen::VectorXi m_default_free_dof;
+    mutable bool m_is_default_free_dof_set = false;
 };
 
 /// Helper Functions for checking finite differences
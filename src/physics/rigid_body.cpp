@@ -18,14 +18,12 @@ void center_vertices(
     Eigen::MatrixXd& vertices,
     const Eigen::MatrixXi& edges,
     const Eigen::MatrixXi& faces,
-    PoseD& pose)
+    VectorMax3d& center_of_mass)
 {
     int dim = vertices.cols();
 
-    vertices.rowwise() += pose.position.transpose();
-
     // compute the center of mass several times to get more accurate
-    pose.position.setZero(dim);
+    center_of_mass.setZero(dim);
     for (int i = 0; i < 10; i++) {
         double mass;
         VectorMax3d com;
@@ -34,64 +32,35 @@ void center_vertices(
             vertices, dim == 2 || faces.size() == 0 ? edges : faces, mass, com,
             inertia);
         vertices.rowwise() -= com.transpose();
-        pose.position += com;
+        center_of_mass += com;
         if (com.squaredNorm() < 1e-8) {
             break;
         }
     }
 }
 
-RigidBody::RigidBody(
+RigidBodyGeometry::RigidBodyGeometry(
     const Eigen::MatrixXd& vertices,
     const Eigen::MatrixXi& edges,
     const Eigen::MatrixXi& faces,
-    const PoseD& pose,
-    const PoseD& velocity,
-    const PoseD& force,
-    const double density,
-    const VectorMax6b& is_dof_fixed,
-    const bool oriented,
-    const int group_id,
-    const RigidBodyType type,
-    const double kinematic_max_time,
-    const std::deque<PoseD>& kinematic_poses)
-    : group_id(group_id)
-    , type(type)
-    , vertices(vertices)
+    const bool use_principal_axes)
+    : vertices(vertices)
     , edges(edges)
     , faces(faces)
-    , is_dof_fixed(is_dof_fixed)
-    , is_oriented(oriented)
     , mesh_selector(vertices.rows(), edges, faces)
-    , pose(pose)
-    , velocity(velocity)
-    , force(force)
-    , kinematic_max_time(kinematic_max_time)
-    , kinematic_poses(kinematic_poses)
 {
-    assert(dim() == pose.dim());
-    assert(dim() == velocity.dim());
-    assert(dim() == force.dim());
     assert(edges.size() == 0 || edges.cols() == 2);
     assert(faces.size() == 0 || faces.cols() == 3);
 
-    if (type == RigidBodyType::STATIC) {
-        this->is_dof_fixed.setOnes(this->is_dof_fixed.size());
-    } else if (this->is_dof_fixed.array().all()) {
-        this->type = RigidBodyType::STATIC;
-    }
-
-    center_vertices(this->vertices, edges, faces, this->pose);
-    VectorMax3d center_of_mass;
+    center_vertices(this->vertices, edges, faces, center_of_mass);
+    VectorMax3d com;
     MatrixMax3d I;
     compute_mass_properties(
         this->vertices,
         dim() == 2 || faces.size() == 0 ? edges : faces, //
-        mass, center_of_mass, I);
-    // assert(center_of_mass.squaredNorm() < 1e-8);
+        volume, com, I);
+    // assert(com.squaredNorm() < 1e-8);
 
-    // Mass above is actually volume in m³ and density is Kg/m³
-    mass *= density;
     if (dim() == 3) {
         // Got this from Chrono: https://bit.ly/2RpbTl1
         Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> es;
@@ -101,7 +70,7 @@ RigidBody::RigidBody(
         if (es.info() != Eigen::Success) {
             spdlog::error("Eigen decompostion of the inertia tensor failed!");
         }
-        moment_of_inertia = density * es.eigenvalues();
+        moment_of_inertia = es.eigenvalues();
         if ((moment_of_inertia.array() < 0).any()) {
             spdlog::warn(
                 "Negative moment of inertia ({}), inverting.",
@@ -118,52 +87,19 @@ RigidBody::RigidBody(
         }
         assert(R0.isUnitary(1e-9));
         assert(fabs(R0.determinant() - 1.0) <= 1.0e-9);
-        int num_rot_dof_fixed =
-            is_dof_fixed.tail(PoseD::dim_to_rot_ndof(dim())).count();
-        if (num_rot_dof_fixed == 2) {
+        if (!use_principal_axes) {
             // Convert moment of inertia to world coordinates
             // https://physics.stackexchange.com/a/268812
             moment_of_inertia = -I.diagonal().array() + I.diagonal().sum();
             R0.setIdentity();
-        } else if (num_rot_dof_fixed == 1) {
-            spdlog::warn("Rigid body dynamics with two rotational DoF has "
-                         "not been tested thoroughly.");
         }
-        // R = RᵢR₀
-        Eigen::AngleAxisd r = Eigen::AngleAxisd(
-            Eigen::Matrix3d(this->pose.construct_rotation_matrix() * R0));
-        this->pose.rotation = r.angle() * r.axis();
         // v = Rv₀ + p = RᵢR₀v₀ + p = RᵢR₀R₀ᵀv₀ + p
         this->vertices = this->vertices * R0; // R₀ᵀ * V₀ᵀ = V₀ * R₀
-        // ω = R₀ᵀω₀ (ω₀ expressed in body coordinates)
-        this->velocity.rotation = R0.transpose() * this->velocity.rotation;
-        Eigen::Matrix3d Q_t0 = this->pose.construct_rotation_matrix();
-        this->Qdot = Q_t0 * Hat(this->velocity.rotation);
-        // τ = R₀ᵀτ₀ (τ₀ expressed in body coordinates)
-        // NOTE: this transformation will be done later
-        // this->force.rotation = R0.transpose() * this->force.rotation;
     } else {
-        moment_of_inertia = density * I.diagonal();
+        moment_of_inertia = I.diagonal();
         R0 = Eigen::Matrix<double, 1, 1>::Identity();
     }
 
-    // Zero out the velocity and forces of fixed dof
-    this->velocity.zero_dof(is_dof_fixed, R0);
-    this->force.zero_dof(is_dof_fixed, R0);
-
-    // Update the previous pose and velocity to reflect the changes made
-    // here
-    this->pose_prev = this->pose;
-    this->velocity_prev = this->velocity;
-
-    this->acceleration = PoseD::Zero(dim());
-    this->Qddot.setZero();
-
-    // Compute and construct some useful constants
-    mass_matrix.resize(ndof());
-    mass_matrix.diagonal().head(pos_ndof()).setConstant(mass);
-    mass_matrix.diagonal().tail(rot_ndof()) = moment_of_inertia;
-
     r_max = this->vertices.rowwise().norm().maxCoeff();
 
     average_edge_length = 0;
@@ -180,16 +116,45 @@ RigidBody::RigidBody(
     init_bvh();
 }
 
-void RigidBody::init_bvh()
+RigidBodyGeometry::RigidBodyGeometry(
+    const Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& edges,
+    const Eigen::MatrixXi& faces,
+    const VectorMax3d& center_of_mass,
+    const double volume,
+    const VectorMax3d& moment_of_inertia,
+    const MatrixMax3d& R0,
+    const double average_edge_length,
+    const double r_max,
+    const MeshSelector& mesh_selector)
+    : vertices(vertices)
+    , edges(edges)
+    , faces(faces)
+    , center_of_mass(center_of_mass)
+    , volume(volume)
+    , moment_of_inertia(moment_of_inertia)
+    , R0(R0)
+    , average_edge_length(average_edge_length)
+    , r_max(r_max)
+    , mesh_selector(mesh_selector)
 {
-    PROFILE_POINT("RigidBody::init_bvh");
+    init_bvh();
+}
+
+void RigidBodyGeometry::init_bvh()
+{
+    PROFILE_POINT("RigidBodyGeometry::init_bvh");
     PROFILE_START();
 
+    size_t num_codim_vertices = mesh_selector.num_codim_vertices();
+    size_t num_codim_edges = mesh_selector.num_codim_edges();
+    size_t num_faces = faces.rows();
+
     // heterogenous bounding boxes
     std::vector<std::array<Eigen::Vector3d, 2>> aabbs(
-        num_codim_vertices() + num_codim_edges() + num_faces());
+        num_codim_vertices + num_codim_edges + num_faces);
 
-    for (size_t i = 0; i < num_codim_vertices(); i++) {
+    for (size_t i = 0; i < num_codim_vertices; i++) {
         size_t vi = mesh_selector.codim_vertices_to_vertices(i);
         if (dim() == 2) {
             aabbs[i][0][2] = 0;
@@ -199,8 +164,8 @@ void RigidBody::init_bvh()
         aabbs[i][1].head(dim()) = vertices.row(i);
     }
 
-    size_t start_i = num_codim_vertices();
-    for (size_t i = 0; i < num_codim_edges(); i++) {
+    size_t start_i = num_codim_vertices;
+    for (size_t i = 0; i < num_codim_edges; i++) {
         size_t ei = mesh_selector.codim_edges_to_edges(i);
         const auto& e0 = vertices.row(edges(ei, 0));
         const auto& e1 = vertices.row(edges(ei, 1));
@@ -213,8 +178,8 @@ void RigidBody::init_bvh()
         aabbs[start_i + i][1].head(dim()) = e0.cwiseMax(e1);
     }
 
-    start_i += num_codim_edges();
-    for (size_t i = 0; i < num_faces(); i++) {
+    start_i += num_codim_edges;
+    for (size_t i = 0; i < num_faces; i++) {
         assert(dim() == 3);
         const auto& f0 = vertices.row(faces(i, 0));
         const auto& f1 = vertices.row(faces(i, 1));
@@ -228,6 +193,131 @@ void RigidBody::init_bvh()
     PROFILE_END();
 }
 
+RigidBody::RigidBody(
+    std::shared_ptr<const RigidBodyGeometry> geometry,
+    const PoseD& pose,
+    const PoseD& velocity,
+    const PoseD& force,
+    const double density,
+    const VectorMax6b& is_dof_fixed,
+    const bool oriented,
+    const int group_id,
+    const RigidBodyType type,
+    const double kinematic_max_time,
+    const std::deque<PoseD>& kinematic_poses)
+    : group_id(group_id)
+    , type(type)
+    , geometry(geometry)
+    , is_dof_fixed(is_dof_fixed)
+    , is_oriented(oriented)
+    , pose(pose)
+    , velocity(velocity)
+    , force(force)
+    , kinematic_max_time(kinematic_max_time)
+    , kinematic_poses(kinematic_poses)
+{
+    assert(this->geometry != nullptr);
+    assert(dim() == pose.dim());
+    assert(dim() == velocity.dim());
+    assert(dim() == force.dim());
+
+    if (type == RigidBodyType::STATIC) {
+        this->is_dof_fixed.setOnes(this->is_dof_fixed.size());
+    } else if (this->is_dof_fixed.array().all()) {
+        this->type = RigidBodyType::STATIC;
+    }
+
+    // Move the input coordinates to the center of mass
+    this->pose.position +=
+        pose.construct_rotation_matrix() * this->geometry->center_of_mass;
+
+    // Volume is in m³ and density is Kg/m³
+    mass = density * this->geometry->volume;
+    moment_of_inertia = this->geometry->moment_of_inertia;
+    if (dim() == 2 || use_principal_axes(is_dof_fixed)) {
+        // NOTE: The world axes inertia of bodies with two fixed rotational DoF
+        // is not scaled by the density.
+        moment_of_inertia *= density;
+    }
+    if (dim() == 3) {
+        assert(
+            use_principal_axes(is_dof_fixed)
+            || this->geometry->R0.isIdentity());
+        int num_rot_dof_fixed =
+            is_dof_fixed.tail(PoseD::dim_to_rot_ndof(dim())).count();
+        if (num_rot_dof_fixed == 1) {
+            spdlog::warn("Rigid body dynamics with two rotational DoF has "
+                         "not been tested thoroughly.");
+        }
+        // R = RᵢR₀
+        Eigen::Matrix3d R =
+            pose.construct_rotation_matrix() * this->geometry->R0;
+        if (use_principal_axes(is_dof_fixed)) {
+            R0 = R;
+        } else {
+            R0 = this->geometry->R0; // Bodies rotating around world axes
+        }
+        Eigen::AngleAxisd r = Eigen::AngleAxisd(R);
+        this->pose.rotation = r.angle() * r.axis();
+        // ω = R₀ᵀω₀ (ω₀ expressed in body coordinates)
+        this->velocity.rotation = R0.transpose() * this->velocity.rotation;
+        Eigen::Matrix3d Q_t0 = this->pose.construct_rotation_matrix();
+        this->Qdot = Q_t0 * Hat(this->velocity.rotation);
+        // τ = R₀ᵀτ₀ (τ₀ expressed in body coordinates)
+        // NOTE: this transformation will be done later
+        // this->force.rotation = R0.transpose() * this->force.rotation;
+    } else {
+        R0 = this->geometry->R0;
+    }
+
+    // Zero out the velocity and forces of fixed dof
+    this->velocity.zero_dof(is_dof_fixed, R0);
+    this->force.zero_dof(is_dof_fixed, R0);
+
+    // Update the previous pose and velocity to reflect the changes made
+    // here
+    this->pose_prev = this->pose;
+    this->velocity_prev = this->velocity;
+
+    this->acceleration = PoseD::Zero(dim());
+    this->Qddot.setZero();
+
+    // Compute and construct some useful constants
+    mass_matrix.resize(ndof());
+    mass_matrix.diagonal().head(pos_ndof()).setConstant(mass);
+    mass_matrix.diagonal().tail(rot_ndof()) = moment_of_inertia;
+}
+
+RigidBody::RigidBody(
+    const Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& edges,
+    const Eigen::MatrixXi& faces,
+    const PoseD& pose,
+    const PoseD& velocity,
+    const PoseD& force,
+    const double density,
+    const VectorMax6b& is_dof_fixed,
+    const bool oriented,
+    const int group_id,
+    const RigidBodyType type,
+    const double kinematic_max_time,
+    const std::deque<PoseD>& kinematic_poses)
+    : RigidBody(
+        std::make_shared<const RigidBodyGeometry>(
+            vertices, edges, faces, use_principal_axes(is_dof_fixed)),
+        pose,
+        velocity,
+        force,
+        density,
+        is_dof_fixed,
+        oriented,
+        group_id,
+        type,
+        kinematic_max_time,
+        kinematic_poses)
+{
+}
+
 Eigen::MatrixXd RigidBody::world_velocities() const
 {
     // compute ẋ = Q̇ * x_B + q̇
@@ -235,10 +325,10 @@ Eigen::MatrixXd RigidBody::world_velocities() const
     if (dim() == 2) {
         MatrixMax3d Q_dt =
             pose.construct_rotation_matrix() * Hat(velocity.rotation);
-        return (vertices * Q_dt.transpose()).rowwise()
+        return (vertices() * Q_dt.transpose()).rowwise()
             + velocity.position.transpose();
     }
-    return (vertices * Qdot.transpose()).rowwise()
+    return (vertices() * Qdot.transpose()).rowwise()
         + velocity.position.transpose();
 }
 
@@ -263,8 +353,10 @@ void RigidBody::compute_bounding_box(
         box_max = box_max.cwiseMax(V1.colwise().maxCoeff().transpose());
     } else {
         // Use the maximum radius of the body to bound all rotations
-        box_min = pose_t0.position.cwiseMin(pose_t1.position).array() - r_max;
-        box_max = pose_t0.position.cwiseMax(pose_t1.position).array() + r_max;
+        box_min =
+            pose_t0.position.cwiseMin(pose_t1.position).array() - r_max();
+        box_max =
+            pose_t0.position.cwiseMax(pose_t1.position).array() + r_max();
     }
 
     PROFILE_END();
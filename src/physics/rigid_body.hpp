@@ -1,6 +1,7 @@
 #pragma once
 
 #include <deque>
+#include <memory> // shared_ptr
 
 #include <Eigen/Core>
 #include <nlohmann/json.hpp>
@@ -21,12 +22,99 @@ NLOHMANN_JSON_SERIALIZE_ENUM(
       { KINEMATIC, "kinematic" },
       { DYNAMIC, "dynamic" } });
 
+/**
+ * @brief Body space geometry and unit density mass properties of a rigid body.
+ *
+ * The geometry is immutable once built and shared by every body instancing
+ * the same mesh, so identical bodies only store their own state.
+ */
+class RigidBodyGeometry {
+public:
+    /**
+     * @brief Center the mesh at its center of mass and build its BVH.
+     *
+     * @param vertices  Vertices of the mesh in input coordinates
+     * @param edges     Vertices pairs defining the topology of the mesh
+     * @param faces     Vertices triplets defining the topology of the mesh
+     * @param use_principal_axes  Align the body space with the principal
+     *                            axes of inertia (3D only)
+     */
+    RigidBodyGeometry(
+        const Eigen::MatrixXd& vertices,
+        const Eigen::MatrixXi& edges,
+        const Eigen::MatrixXi& faces,
+        const bool use_principal_axes = true);
+
+    /**
+     * @brief Restore a geometry from its precomputed properties (e.g., loaded
+     * from a cache). Only the BVH is built.
+     */
+    RigidBodyGeometry(
+        const Eigen::MatrixXd& vertices,
+        const Eigen::MatrixXi& edges,
+        const Eigen::MatrixXi& faces,
+        const VectorMax3d& center_of_mass,
+        const double volume,
+        const VectorMax3d& moment_of_inertia,
+        const MatrixMax3d& R0,
+        const double average_edge_length,
+        const double r_max,
+        const MeshSelector& mesh_selector);
+
+    int dim() const { return vertices.cols(); }
+
+    Eigen::MatrixXd vertices; ///< Vertices positions in body space
+    Eigen::MatrixXi edges;    ///< Vertices connectivity
+    Eigen::MatrixXi faces;    ///< Vertices connectivity
+
+    /// @brief center of mass in input coordinates
+    VectorMax3d center_of_mass;
+    /// @brief volume (area in 2D), the mass for a unit density
+    double volume;
+    /// @brief moment of inertia for a unit density in body space
+    VectorMax3d moment_of_inertia;
+    /// @brief rotation from body space to input coordinates
+    MatrixMax3d R0;
+
+    double average_edge_length; ///< Average edge length
+    /// @brief maximum distance from CM to a vertex
+    double r_max;
+
+    /// @brief Local space BVH initalized at construction
+    BVH::BVH bvh;
+    MeshSelector mesh_selector;
+
+protected:
+    void init_bvh();
+};
+
 class RigidBody {
 public:
     /**
-     * @brief Create rigid body with center of mass at \f$\vec{0}\f$.
+     * @brief Create a rigid body instancing a shared geometry.
      *
-     * @param vertices  Vertices of the rigid body in body space
+     * @param geometry  Body space geometry of the rigid body
+     * @param pose      Position and rotation of the input coordinates of the
+     *                  geometry
+     */
+    RigidBody(
+        std::shared_ptr<const RigidBodyGeometry> geometry,
+        const PoseD& pose,
+        const PoseD& velocity,
+        const PoseD& force,
+        const double density,
+        const VectorMax6b& is_dof_fixed,
+        const bool oriented,
+        const int group_id,
+        const RigidBodyType type = RigidBodyType::DYNAMIC,
+        const double kinematic_max_time =
+            std::numeric_limits<double>::infinity(),
+        const std::deque<PoseD>& kinematic_poses = std::deque<PoseD>());
+
+    /**
+     * @brief Create rigid body with its own geometry.
+     *
+     * @param vertices  Vertices of the rigid body in input coordinates
      * @param faces     Vertices pairs defining the topology of the rigid
      *                  body
      */
@@ -78,6 +166,15 @@ public:
     {
     }
 
+    /// @brief Should the body space be aligned with the principal axes?
+    /// Bodies with two fixed rotational DoF rotate around a world axis, so
+    /// their body space stays aligned with the input coordinates.
+    static bool use_principal_axes(const VectorMax6b& is_dof_fixed)
+    {
+        return is_dof_fixed.size() == PoseD::dim_to_ndof(3)
+            && is_dof_fixed.tail(PoseD::dim_to_rot_ndof(3)).count() != 2;
+    }
+
     // --------------------------------------------------------------------
     // State Functions
     // --------------------------------------------------------------------
@@ -150,20 +247,23 @@ public:
 
     double edge_length(int edge_id) const
     {
-        return (vertices.row(edges(edge_id, 1))
-                - vertices.row(edges(edge_id, 0)))
+        return (vertices().row(edges()(edge_id, 1))
+                - vertices().row(edges()(edge_id, 0)))
             .norm();
     }
 
-    long num_vertices() const { return vertices.rows(); }
-    long num_edges() const { return edges.rows(); }
-    long num_faces() const { return faces.rows(); }
+    long num_vertices() const { return vertices().rows(); }
+    long num_edges() const { return edges().rows(); }
+    long num_faces() const { return faces().rows(); }
     long num_codim_vertices() const
     {
-        return mesh_selector.num_codim_vertices();
+        return mesh_selector().num_codim_vertices();
     }
-    long num_codim_edges() const { return mesh_selector.num_codim_edges(); }
-    int dim() const { return vertices.cols(); }
+    long num_codim_edges() const
+    {
+        return mesh_selector().num_codim_edges();
+    }
+    int dim() const { return geometry->dim(); }
     int ndof() const { return pose.ndof(); }
     int pos_ndof() const { return pose.pos_ndof(); }
     int rot_ndof() const { return pose.rot_ndof(); }
@@ -207,20 +307,35 @@ public:
     // --------------------------------------------------------------------
     // Geometry
     // --------------------------------------------------------------------
-    Eigen::MatrixXd vertices; ///< Vertices positions in body space
-    Eigen::MatrixXi edges;    ///< Vertices connectivity
-    Eigen::MatrixXi faces;    ///< Vertices connectivity
+    /// @brief Shared body space geometry
+    std::shared_ptr<const RigidBodyGeometry> geometry;
 
-    double average_edge_length; ///< Average edge length
+    /// @brief Vertices positions in body space
+    const Eigen::MatrixXd& vertices() const { return geometry->vertices; }
+    const Eigen::MatrixXi& edges() const { return geometry->edges; }
+    const Eigen::MatrixXi& faces() const { return geometry->faces; }
+
+    double average_edge_length() const
+    {
+        return geometry->average_edge_length;
+    }
+    /// @brief maximum distance from CM to a vertex
+    double r_max() const { return geometry->r_max; }
+
+    /// @brief Local space BVH
+    const BVH::BVH& bvh() const { return geometry->bvh; }
+    const MeshSelector& mesh_selector() const
+    {
+        return geometry->mesh_selector;
+    }
 
     /// @brief total mass (M) of the rigid body
     double mass;
     /// @brief moment of inertia measured with respect to the principal axes
     VectorMax3d moment_of_inertia;
-    /// @brief rotation from the principal axes to the input orientation
+    /// @brief rotation from the principal axes to the world orientation at
+    /// rest
     MatrixMax3d R0;
-    /// @brief maximum distance from CM to a vertex
-    double r_max;
     /// @brief the mass matrix of the rigid body
     DiagonalMatrixMax6d mass_matrix;
 
@@ -230,10 +345,6 @@ public:
     /// @brief Use edge orientation for normal in 2D restitution
     bool is_oriented;
 
-    /// @brief Local space BVH initalized at construction
-    BVH::BVH bvh;
-    MeshSelector mesh_selector;
-
     // --------------------------------------------------------------------
     // State
     // --------------------------------------------------------------------
@@ -259,9 +370,6 @@ public:
     // --------------------------------------------------------------------
     double kinematic_max_time;
     std::deque<PoseD> kinematic_poses;
-
-protected:
-    void init_bvh();
 };
 
 } // namespace ipc::rigid
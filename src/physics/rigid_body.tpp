@@ -12,7 +12,7 @@ template <typename T>
 MatrixX<T>
 RigidBody::world_vertices(const MatrixMax3<T>& R, const VectorMax3<T>& p) const
 {
-    return (vertices * R.transpose()).rowwise() + p.transpose();
+    return (vertices() * R.transpose()).rowwise() + p.transpose();
 }
 
 template <typename T>
@@ -20,7 +20,7 @@ VectorMax3<T> RigidBody::world_vertex(
     const MatrixMax3<T>& R, const VectorMax3<T>& p, const int vertex_idx) const
 {
     // compute X[i] = R(θ) * rᵢ + X
-    return (vertices.row(vertex_idx) * R.transpose()) + p.transpose();
+    return (vertices().row(vertex_idx) * R.transpose()) + p.transpose();
 }
 
 template <typename DScalar>
@@ -37,18 +37,19 @@ Eigen::MatrixXd RigidBody::world_vertices_diff(
     // Activate autodiff with the correct number of variables.
     Diff::activate(rot_ndof());
 
-    assert(rb_v0_i >= 0 && rb_v0_i <= V.rows() - vertices.rows());
+    assert(rb_v0_i >= 0 && rb_v0_i <= V.rows() - vertices().rows());
     assert(V.cols() == dim());
-    assert(rb_v0_i <= jac.rows() - vertices.size());
+    assert(rb_v0_i <= jac.rows() - vertices().size());
     assert(jac.cols() == ndof());
-    bool compute_hess = hess.size() >= vertices.size() * ndof()
+    bool compute_hess = hess.size() >= vertices().size() * ndof()
         && std::is_base_of<Diff::DDouble2, DScalar>();
     assert(
-        !compute_hess || rb_v0_i <= (hess.size() / ndof()) - vertices.size());
+        !compute_hess
+        || rb_v0_i <= (hess.size() / ndof()) - vertices().size());
 
     auto R = construct_rotation_matrix(
         VectorMax3<DScalar>(Diff::dTvars<DScalar>(0, pose.rotation)));
-    MatrixX<DScalar> V_diff = vertices * R.transpose();
+    MatrixX<DScalar> V_diff = vertices() * R.transpose();
 
     for (int i = 0; i < V_diff.rows(); i++) {
         for (int j = 0; j < V_diff.cols(); j++) {
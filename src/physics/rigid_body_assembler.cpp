@@ -5,6 +5,7 @@
 #include <igl/PI.h>
 #include <ipc/broad_phase/hash_grid.hpp>
 #include <ipc/distance/edge_edge.hpp>
+#include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
 #include <logger.hpp>
@@ -26,76 +27,72 @@ void RigidBodyAssembler::init(const std::vector<RigidBody>& rigid_bodies)
     m_body_edge_id.resize(num_bodies + 1);
 
     // Store the starting position of each RB vertex in the global vertices
+    std::vector<size_t> body_codim_edge_id(num_bodies + 1);
     m_body_vertex_id[0] = m_body_face_id[0] = m_body_edge_id[0] = 0;
+    body_codim_edge_id[0] = 0;
     for (size_t i = 0; i < num_bodies; ++i) {
         auto& rb = rigid_bodies[i];
         m_body_vertex_id[i + 1] = m_body_vertex_id[i] + rb.num_vertices();
-        m_body_face_id[i + 1] = m_body_face_id[i] + rb.faces.rows();
-        m_body_edge_id[i + 1] = m_body_edge_id[i] + rb.edges.rows();
+        m_body_face_id[i + 1] = m_body_face_id[i] + rb.faces().rows();
+        m_body_edge_id[i + 1] = m_body_edge_id[i] + rb.edges().rows();
+        body_codim_edge_id[i + 1] = body_codim_edge_id[i]
+            + rb.mesh_selector().codim_edges_to_edges().size();
     }
 
-    // global edges and faces
+    int rb_ndof = num_bodies ? rigid_bodies[0].ndof() : 0;
     m_edges.resize(m_body_edge_id.back(), 2);
     m_faces.resize(m_body_face_id.back(), 3);
     m_faces_to_edges.resize(m_body_face_id.back(), 3);
-    m_codim_edges_to_edges.clear();
-    for (size_t i = 0; i < num_bodies; ++i) {
-        auto& rb = rigid_bodies[i];
-        if (rb.edges.size() != 0) {
-            m_edges.block(m_body_edge_id[i], 0, rb.edges.rows(), 2) =
-                rb.edges.array() + m_body_vertex_id[i];
+    m_codim_edges_to_edges.resize(body_codim_edge_id.back());
+    m_vertex_to_body_map.resize(num_vertices());
+    m_vertex_group_ids.resize(num_vertices());
+    m_rb_mass_matrix.resize(num_bodies * rb_ndof);
+    is_rb_dof_fixed.resize(num_bodies * rb_ndof);
+    is_dof_fixed.resize(num_vertices(), rb_ndof);
+
+    // Every body writes to its own blocks of the global arrays, so the
+    // bodies can be concatenated in parallel in a deterministic order.
+    tbb::parallel_for(size_t(0), num_bodies, [&](size_t i) {
+        const RigidBody& rb = rigid_bodies[i];
+
+        // global edges and faces
+        if (rb.edges().size() != 0) {
+            m_edges.block(m_body_edge_id[i], 0, rb.edges().rows(), 2) =
+                rb.edges().array() + m_body_vertex_id[i];
         }
-        if (rb.faces.size() != 0) {
-            m_faces.block(m_body_face_id[i], 0, rb.faces.rows(), 3) =
-                rb.faces.array() + m_body_vertex_id[i];
-            m_faces_to_edges.block(m_body_face_id[i], 0, rb.faces.rows(), 3) =
-                rb.mesh_selector.face_to_edges().array() + m_body_edge_id[i];
+        if (rb.faces().size() != 0) {
+            m_faces.block(m_body_face_id[i], 0, rb.faces().rows(), 3) =
+                rb.faces().array() + m_body_vertex_id[i];
+            m_faces_to_edges.block(m_body_face_id[i], 0, rb.faces().rows(), 3) =
+                rb.mesh_selector().face_to_edges().array() + m_body_edge_id[i];
         }
-        for (const auto& ei : rb.mesh_selector.codim_edges_to_edges()) {
-            m_codim_edges_to_edges.push_back(ei + m_body_edge_id[i]);
+        const auto& codim_edges = rb.mesh_selector().codim_edges_to_edges();
+        for (size_t j = 0; j < codim_edges.size(); j++) {
+            m_codim_edges_to_edges[body_codim_edge_id[i] + j] =
+                codim_edges[j] + m_body_edge_id[i];
         }
-    }
-    // vertex to body map
-    m_vertex_to_body_map.resize(num_vertices());
-    for (size_t i = 0; i < num_bodies; ++i) {
-        auto& rb = rigid_bodies[i];
+
+        // vertex to body map and vertex to group id map
         m_vertex_to_body_map.segment(m_body_vertex_id[i], rb.num_vertices())
             .setConstant(int(i));
-    }
-    // vertex to group id map
-    m_vertex_group_ids.resize(num_vertices());
-    for (size_t i = 0; i < num_bodies; ++i) {
-        auto& rb = rigid_bodies[i];
         m_vertex_group_ids.segment(m_body_vertex_id[i], rb.num_vertices())
             .setConstant(rb.group_id);
-    }
 
-    // rigid body mass-matrix
-    int rb_ndof = num_bodies ? rigid_bodies[0].ndof() : 0;
-    m_rb_mass_matrix.resize(num_bodies * rb_ndof);
-    for (int i = 0; i < int(num_bodies); ++i) {
+        // rigid body mass-matrix
         m_rb_mass_matrix.diagonal().segment(i * rb_ndof, rb_ndof) =
-            rigid_bodies[i].mass_matrix.diagonal();
-    }
+            rb.mass_matrix.diagonal();
 
-    // rigid_body dof_fixed flag
-    is_rb_dof_fixed.resize(num_bodies * rb_ndof);
-    for (int i = 0; i < int(num_bodies); ++i) {
-        auto& rb = rigid_bodies[size_t(i)];
+        // rigid_body dof_fixed flag
         is_rb_dof_fixed.segment(rb_ndof * i, rb_ndof) = rb.is_dof_fixed;
-    }
 
-    // rigid_body vertex dof_fixed flag
-    is_dof_fixed.resize(num_vertices(), rb_ndof);
-    for (size_t i = 0; i < num_bodies; ++i) {
-        auto& rb = rigid_bodies[i];
+        // rigid_body vertex dof_fixed flag
         is_dof_fixed.block(m_body_vertex_id[i], 0, rb.num_vertices(), rb_ndof) =
             rb.is_dof_fixed.transpose().replicate(rb.num_vertices(), 1);
-    }
+    });
 
     average_edge_length = 0;
     for (const auto& body : rigid_bodies) {
-        average_edge_length += body.edges.rows() * body.average_edge_length;
+        average_edge_length += body.edges().rows() * body.average_edge_length();
     }
     average_edge_length /= m_edges.rows();
     assert(std::isfinite(average_edge_length));
@@ -282,13 +279,13 @@ std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies_brute_force(
 {
     std::vector<std::pair<int, int>> close_body_pairs;
     for (int i = 0; i < num_bodies(); i++) {
-        double ri = m_rbs[i].r_max;
+        double ri = m_rbs[i].r_max();
         for (int j = i + 1; j < num_bodies(); j++) {
             if (m_rbs[i].group_id == m_rbs[j].group_id) {
                 continue;
             }
 
-            double rj = m_rbs[j].r_max;
+            double rj = m_rbs[j].r_max();
             double distance = sqrt(edge_edge_distance(
                 poses_t0[i].position, poses_t1[i].position,
                 poses_t0[j].position, poses_t1[j].position));
@@ -367,7 +364,7 @@ std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies_hash_grid(
         V.row(2 * i + 1) = poses_t1[i].position;
         E(i, 0) = 2 * i + 0;
         E(i, 1) = 2 * i + 1;
-        max_radius = std::max(m_rbs[i].r_max, max_radius);
+        max_radius = std::max(m_rbs[i].r_max(), max_radius);
         group_ids[2 * i + 1] = group_ids[2 * i] = m_rbs[i].group_id;
     }
 
@@ -378,7 +375,7 @@ std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies_hash_grid(
     for (int i = 0; i < num_bodies(); i++) {
         hashgrid.addEdge(
             V.row(E(i, 0)), V.row(E(i, 1)), V.row(E(i, 0)), V.row(E(i, 1)), i,
-            m_rbs[i].r_max);
+            m_rbs[i].r_max());
     }
 
     auto can_collide = [&group_ids](size_t vi, size_t vj) {
@@ -10,7 +10,7 @@ MatrixX<T> RigidBodyAssembler::world_vertices(const Poses<T>& poses) const
     MatrixX<T> V(num_vertices(), dim());
     for (size_t i = 0; i < num_bodies(); ++i) {
         const RigidBody& rb = m_rbs[i];
-        V.block(m_body_vertex_id[i], 0, rb.vertices.rows(), rb.dim()) =
+        V.block(m_body_vertex_id[i], 0, rb.vertices().rows(), rb.dim()) =
             rb.world_vertices(poses[i]);
     }
     return V;
@@ -26,7 +26,7 @@ MatrixX<T> RigidBodyAssembler::world_vertices(
     MatrixX<T> V(num_vertices(), dim());
     for (size_t i = 0; i < num_bodies(); ++i) {
         const RigidBody& rb = m_rbs[i];
-        V.block(m_body_vertex_id[i], 0, rb.vertices.rows(), rb.dim()) =
+        V.block(m_body_vertex_id[i], 0, rb.vertices().rows(), rb.dim()) =
             rb.world_vertices(rotations[i], positions[i]);
     }
     return V;
@@ -72,18 +72,18 @@ public:
 
     const Eigen::MatrixXi& edges(size_t i) const override
     {
-        return m_assembler[i].edges;
+        return m_assembler[i].edges();
     }
 
     virtual const std::vector<size_t>&
     codim_edges_to_edges(size_t i) const override
     {
-        return m_assembler[i].mesh_selector.codim_edges_to_edges();
+        return m_assembler[i].mesh_selector().codim_edges_to_edges();
     }
 
     const Eigen::MatrixXi& faces(size_t i) const override
     {
-        return m_assembler[i].faces;
+        return m_assembler[i].faces();
     }
 
     Eigen::MatrixXd velocities() const override
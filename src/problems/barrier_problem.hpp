@@ -139,6 +139,14 @@ public:
     virtual double barrier_stiffness() const = 0;
     virtual void barrier_stiffness(const double kappa) = 0;
 
+    /// @brief Hash of the active constraint set at x.
+    ///
+    /// Solvers compare hashes to detect a change in the contacts.
+    virtual size_t active_constraint_set_hash(const Eigen::VectorXd& x)
+    {
+        return 0;
+    }
+
 protected:
     bool m_use_barriers = true;
 };
@@ -1,5 +1,8 @@
 #include "distance_barrier_rb_problem.hpp"
 
+#include <algorithm>
+#include <map>
+
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 
@@ -14,6 +17,7 @@
 
 #include <constants.hpp>
 #include <geometry/distance.hpp>
+#include <solvers/ordered_ldlt.hpp>
 #include <solvers/solver_factory.hpp>
 #include <utils/not_implemented_error.hpp>
 
@@ -28,6 +32,11 @@ DistanceBarrierRBProblem::DistanceBarrierRBProblem()
     , m_had_collisions(false)
     , static_friction_speed_bound(1e-3)
     , friction_iterations(1)
+    , friction_constraint_dhat(-1)
+    , friction_constraint_kappa(-1)
+    , friction_constraint_mu(-1)
+    , use_warm_start(false)
+    , m_free_dof_version(0)
     , body_energy_integration_method(DEFAULT_BODY_ENERGY_INTEGRATION_METHOD)
 {
 }
@@ -53,6 +62,7 @@ bool DistanceBarrierRBProblem::settings(const nlohmann::json& params)
     body_energy_integration_method =
         params["rigid_body_problem"]["time_stepper"]
             .get<BodyEnergyIntegrationMethod>();
+    use_warm_start = params["rigid_body_problem"]["warm_start"];
     bool success = RigidBodyProblem::settings(params["rigid_body_problem"]);
     if (!success) {
         return false;
@@ -85,6 +95,7 @@ nlohmann::json DistanceBarrierRBProblem::settings() const
     json["friction_iterations"] = friction_iterations;
     json["static_friction_speed_bound"] = static_friction_speed_bound;
     json["time_stepper"] = body_energy_integration_method;
+    json["warm_start"] = use_warm_start;
     return json;
 }
 
@@ -99,7 +110,7 @@ nlohmann::json DistanceBarrierRBProblem::state() const
     return json;
 }
 
-Eigen::VectorXi DistanceBarrierRBProblem::free_dof() const
+void DistanceBarrierRBProblem::update_free_dof()
 {
     const VectorXb& is_dof_fixed = this->is_dof_fixed();
     std::vector<int> free_dofs;
@@ -109,7 +120,13 @@ Eigen::VectorXi DistanceBarrierRBProblem::free_dof() const
             free_dofs.push_back(i);
         }
     }
-    return Eigen::Map<Eigen::VectorXi>(free_dofs.data(), free_dofs.size());
+    const Eigen::Map<Eigen::VectorXi> new_free_dof(
+        free_dofs.data(), free_dofs.size());
+    if (new_free_dof.size() != m_free_dof.size()
+        || new_free_dof != m_free_dof) {
+        m_free_dof = new_free_dof;
+        m_free_dof_version++;
+    }
 }
 
 ////////////////////////////////////////////////////////////
@@ -118,6 +135,12 @@ Eigen::VectorXi DistanceBarrierRBProblem::free_dof() const
 void DistanceBarrierRBProblem::simulation_step(
     bool& had_collisions, bool& _has_intersections, bool solve_collisions)
 {
+    // Extrapolate the previous step before the poses are advanced
+    PosesD extrapolated_poses;
+    if (use_warm_start) {
+        extrapolated_poses = extrapolate_poses();
+    }
+
     // Advance the poses, but leave the current pose unchanged for now.
     for (size_t i = 0; i < num_bodies(); i++) {
         m_assembler[i].pose_prev = m_assembler[i].pose;
@@ -136,6 +159,9 @@ void DistanceBarrierRBProblem::simulation_step(
 
     // Solve constraints updates the constraints and takes the step
     update_constraints();
+    if (use_warm_start) {
+        update_warm_start(extrapolated_poses);
+    }
     opt_result = solve_constraints();
     _has_intersections = take_step(opt_result.x);
     step_kinematic_bodies();
@@ -149,6 +175,10 @@ void DistanceBarrierRBProblem::update_constraints()
 
     RigidBodyProblem::update_constraints();
 
+    // The body types (and the constraints) can change between time-steps
+    m_barrier_cache = nullptr;
+    x_warm_start.resize(0);
+
     Constraints collision_constraints;
     m_constraint.construct_constraint_set(
         m_assembler, poses_t0, collision_constraints);
@@ -158,6 +188,9 @@ void DistanceBarrierRBProblem::update_constraints()
         x0, collision_constraints, grad_barrier_t0, hess,
         /*compute_grad=*/true, /*compute_hess=*/false);
 
+    if (coefficient_friction > 0) {
+        world_vertices_t0 = m_assembler.world_vertices(poses_t0);
+    }
     update_friction_constraints(collision_constraints, poses_t0);
 
     init_augmented_lagrangian();
@@ -165,6 +198,130 @@ void DistanceBarrierRBProblem::update_constraints()
     PROFILE_END();
 }
 
+PosesD DistanceBarrierRBProblem::extrapolate_poses() const
+{
+    const double h = timestep();
+    PosesD poses = m_assembler.rb_poses_t1();
+    for (int i = 0; i < num_bodies(); i++) {
+        const RigidBody& rb = m_assembler[i];
+        if (rb.type != RigidBodyType::DYNAMIC) {
+            continue; // Kinematic bodies use their prescribed poses
+        }
+
+        // Assume the acceleration of the previous step stays constant:
+        // qᵗ⁺¹ = qᵗ + h (vᵗ + h aᵗ) with aᵗ = (vᵗ - vᵗ⁻¹) / h
+        poses[i].position +=
+            h * (2 * rb.velocity.position - rb.velocity_prev.position);
+        if (dim() == 2) {
+            poses[i].rotation +=
+                h * (2 * rb.velocity.rotation - rb.velocity_prev.rotation);
+        } else {
+            // The angular velocity is not additive in the rotation vector, so
+            // only extrapolate the velocity (same as x_pred).
+            poses[i].rotation += h * rb.velocity.rotation;
+        }
+    }
+    return poses;
+}
+
+void DistanceBarrierRBProblem::update_warm_start(
+    const PosesD& extrapolated_poses)
+{
+    x_warm_start.resize(0);
+    // Without CCD along the Newton update the clamped point can intersect
+    if (!m_use_barriers || !is_ccd_aligned_with_newton_update()) {
+        return;
+    }
+
+    PROFILE_POINT("DistanceBarrierRBProblem::update_warm_start");
+    PROFILE_START();
+
+    int ndof = PoseD::dim_to_ndof(dim());
+    Eigen::VectorXd x = this->poses_to_dofs(extrapolated_poses);
+    for (int i = 0; i < num_bodies(); i++) {
+        if (m_assembler[i].type != RigidBodyType::DYNAMIC) {
+            x.segment(ndof * i, ndof) = x_pred.segment(ndof * i, ndof);
+        }
+    }
+    const VectorXb& is_dof_fixed = this->is_dof_fixed();
+    for (int i = 0; i < x.size(); i++) {
+        if (is_dof_fixed[i] || is_dof_satisfied[i]) {
+            x[i] = x0[i];
+        }
+    }
+
+    // Stop short of the earliest impact to stay clear of the barrier's
+    // singularity. This does not count as a collision of the step.
+    double toi = m_constraint.compute_earliest_toi(
+        m_assembler, poses_t0, this->dofs_to_poses(x));
+    if (toi <= 1) {
+        x = x0 + (0.8 * toi) * (x - x0);
+    }
+    spdlog::debug("warm_start toi={:g}", toi);
+
+    if (toi > 0) {
+        x_warm_start = x;
+    }
+
+    PROFILE_END();
+}
+
+// Move the previous friction constraints of the collision constraints with
+// the same (sorted) primitives between bodies that barely moved. The other
+// collision constraints are returned in new_constraints.
+template <
+    typename RigidBodyConstraint,
+    typename CollisionConstraint,
+    typename FrictionConstraint,
+    typename PrimitiveIds>
+static void reuse_friction_constraints(
+    const RigidBodyAssembler& bodies,
+    const std::vector<bool>& is_body_unchanged,
+    const std::vector<CollisionConstraint>& collision_constraints,
+    std::vector<FrictionConstraint>& prev_friction_constraints,
+    const PrimitiveIds& primitive_ids,
+    std::vector<FrictionConstraint>& friction_constraints,
+    std::vector<CollisionConstraint>& new_constraints)
+{
+    std::map<std::pair<long, long>, size_t> reusable;
+    for (size_t i = 0; i < prev_friction_constraints.size(); i++) {
+        const std::array<long, 2> ids =
+            RigidBodyConstraint(bodies, prev_friction_constraints[i])
+                .body_ids();
+        if (is_body_unchanged[ids[0]] && is_body_unchanged[ids[1]]) {
+            reusable.emplace(primitive_ids(prev_friction_constraints[i]), i);
+        }
+    }
+
+    friction_constraints.reserve(collision_constraints.size());
+    for (const CollisionConstraint& constraint : collision_constraints) {
+        auto it = reusable.find(primitive_ids(constraint));
+        if (it != reusable.end()) {
+            friction_constraints.push_back(
+                std::move(prev_friction_constraints[it->second]));
+            reusable.erase(it);
+        } else {
+            new_constraints.push_back(constraint);
+        }
+    }
+}
+
+template <typename T>
+static void append(std::vector<T>& a, std::vector<T>& b)
+{
+    a.insert(
+        a.end(), std::make_move_iterator(b.begin()),
+        std::make_move_iterator(b.end()));
+}
+
+template <typename T, typename Key>
+static void sort_by_key(std::vector<T>& a, const Key& key)
+{
+    std::sort(a.begin(), a.end(), [&](const T& lhs, const T& rhs) {
+        return key(lhs) < key(rhs);
+    });
+}
+
 void DistanceBarrierRBProblem::update_friction_constraints(
     const Constraints& collision_constraints, const PosesD& poses)
 {
@@ -176,13 +333,109 @@ void DistanceBarrierRBProblem::update_friction_constraints(
     PROFILE_START();
 
     // The fricition constraints are constant through out the entire
-    // lagging iteration.
-    friction_constraints.clear();
-    Eigen::MatrixXd V0 = m_assembler.world_vertices(poses);
-    construct_friction_constraint_set(
-        V0, edges(), faces(), collision_constraints,
-        barrier_activation_distance(), barrier_stiffness(),
-        coefficient_friction, friction_constraints);
+    // lagging iteration. A friction constraint only depends on the poses of
+    // its two bodies, so the ones of contacts that persist between bodies
+    // whose vertices moved at most FRICTION_CONSTRAINT_REUSE_TOL × d̂ are
+    // reused (e.g., the last lagging iteration of a step is at the starting
+    // poses of the next one).
+    std::vector<bool> is_body_unchanged(num_bodies(), false);
+    if (friction_constraint_poses.size() == poses.size()
+        && friction_constraint_dhat == barrier_activation_distance()
+        && friction_constraint_kappa == barrier_stiffness()
+        && friction_constraint_mu == coefficient_friction) {
+        const double max_displacement =
+            Constants::FRICTION_CONSTRAINT_REUSE_TOL
+            * barrier_activation_distance();
+        for (int i = 0; i < num_bodies(); i++) {
+            // Bound on the displacement of the body's vertices
+            const PoseD& prev_pose = friction_constraint_poses[i];
+            const double displacement =
+                (poses[i].position - prev_pose.position).norm()
+                + (poses[i].construct_rotation_matrix()
+                   - prev_pose.construct_rotation_matrix())
+                        .norm()
+                    * m_assembler[i].r_max();
+            is_body_unchanged[i] = displacement <= max_displacement;
+        }
+    }
+
+    // Primitives of a constraint (unique in a constraint set), sorted when
+    // they have the same type as the order can change between steps
+    const auto vv_ids = [](const auto& c) {
+        return std::make_pair(
+            std::min(c.vertex0_index, c.vertex1_index),
+            std::max(c.vertex0_index, c.vertex1_index));
+    };
+    const auto ev_ids = [](const auto& c) {
+        return std::make_pair(c.edge_index, c.vertex_index);
+    };
+    const auto ee_ids = [](const auto& c) {
+        return std::make_pair(
+            std::min(c.edge0_index, c.edge1_index),
+            std::max(c.edge0_index, c.edge1_index));
+    };
+    const auto fv_ids = [](const auto& c) {
+        return std::make_pair(c.face_index, c.vertex_index);
+    };
+
+    FrictionConstraints prev_friction_constraints;
+    std::swap(prev_friction_constraints, friction_constraints);
+    Constraints new_constraints;
+    reuse_friction_constraints<RigidBodyVertexVertexConstraint>(
+        m_assembler, is_body_unchanged, collision_constraints.vv_constraints,
+        prev_friction_constraints.vv_constraints, vv_ids,
+        friction_constraints.vv_constraints, new_constraints.vv_constraints);
+    reuse_friction_constraints<RigidBodyEdgeVertexConstraint>(
+        m_assembler, is_body_unchanged, collision_constraints.ev_constraints,
+        prev_friction_constraints.ev_constraints, ev_ids,
+        friction_constraints.ev_constraints, new_constraints.ev_constraints);
+    reuse_friction_constraints<RigidBodyEdgeEdgeConstraint>(
+        m_assembler, is_body_unchanged, collision_constraints.ee_constraints,
+        prev_friction_constraints.ee_constraints, ee_ids,
+        friction_constraints.ee_constraints, new_constraints.ee_constraints);
+    reuse_friction_constraints<RigidBodyFaceVertexConstraint>(
+        m_assembler, is_body_unchanged, collision_constraints.fv_constraints,
+        prev_friction_constraints.fv_constraints, fv_ids,
+        friction_constraints.fv_constraints, new_constraints.fv_constraints);
+
+    spdlog::debug(
+        "num_reused_friction_constraints={:d} "
+        "num_new_friction_constraints={:d}",
+        friction_constraints.size(), new_constraints.size());
+
+    if (new_constraints.size() > 0) {
+        FrictionConstraints new_friction_constraints;
+        Eigen::MatrixXd V0 = m_assembler.world_vertices(poses);
+        construct_friction_constraint_set(
+            V0, edges(), faces(), new_constraints,
+            barrier_activation_distance(), barrier_stiffness(),
+            coefficient_friction, new_friction_constraints);
+        append(
+            friction_constraints.vv_constraints,
+            new_friction_constraints.vv_constraints);
+        append(
+            friction_constraints.ev_constraints,
+            new_friction_constraints.ev_constraints);
+        append(
+            friction_constraints.ee_constraints,
+            new_friction_constraints.ee_constraints);
+        append(
+            friction_constraints.fv_constraints,
+            new_friction_constraints.fv_constraints);
+    }
+
+    // Order the constraints by their primitives, so the sums over them do
+    // not depend on which ones were reused (e.g., after a restart from a
+    // checkpoint all of them are new).
+    sort_by_key(friction_constraints.vv_constraints, vv_ids);
+    sort_by_key(friction_constraints.ev_constraints, ev_ids);
+    sort_by_key(friction_constraints.ee_constraints, ee_ids);
+    sort_by_key(friction_constraints.fv_constraints, fv_ids);
+
+    friction_constraint_poses = poses;
+    friction_constraint_dhat = barrier_activation_distance();
+    friction_constraint_kappa = barrier_stiffness();
+    friction_constraint_mu = coefficient_friction;
 
     PROFILE_END();
 }
@@ -232,6 +485,7 @@ void DistanceBarrierRBProblem::init_augmented_lagrangian()
             is_dof_satisfied.segment(ndof * i, ndof).setOnes();
         }
     }
+    update_free_dof();
 }
 
 void DistanceBarrierRBProblem::step_kinematic_bodies()
@@ -419,6 +673,8 @@ void DistanceBarrierRBProblem::update_augmented_lagrangian(
             angular_augmented_lagrangian_multiplier.lpNorm<Eigen::Infinity>(),
             eta_q, eta_Q);
     }
+
+    update_free_dof();
 }
 
 bool DistanceBarrierRBProblem::are_equality_constraints_satisfied(
@@ -434,7 +690,8 @@ bool DistanceBarrierRBProblem::are_equality_constraints_satisfied(
 OptimizationResults DistanceBarrierRBProblem::solve_constraints()
 {
     OptimizationResults opt_result;
-    opt_result.x = starting_point();
+    opt_result.x = x_warm_start.size() == x0.size() ? x_warm_start
+                                                    : starting_point();
     double momentum_balance, eps_d = 1e-2 * world_bbox_diagonal();
     int i = 0;
     int total_newton_iterations = 0;
@@ -666,23 +923,12 @@ double DistanceBarrierRBProblem::compute_objective(
     }
 
     // Compute a common constraint set to use for contacts and friction
-    // Start by updating the constraint set
-    Constraints constraints;
-    m_constraint.construct_constraint_set(
-        m_assembler, this->dofs_to_poses(x), constraints);
-
-    spdlog::debug(
-        "problem={} num_vertex_vertex_constraint={:d} "
-        "num_edge_vertex_constraints={:d} num_edge_edge_constraints={:d} "
-        "num_face_vertex_constraints={:d}",
-        name(), constraints.vv_constraints.size(),
-        constraints.ev_constraints.size(), constraints.ee_constraints.size(),
-        constraints.fv_constraints.size());
-
+    // (reused from the line search)
     Eigen::VectorXd grad_Bx;
     Eigen::SparseMatrix<double> hess_Bx;
-    double Bx = compute_barrier_term(
-        x, constraints, grad_Bx, hess_Bx, compute_grad, compute_hess);
+    int num_constraints;
+    double Bx = compute_cached_barrier_term(
+        x, grad_Bx, hess_Bx, num_constraints, compute_grad, compute_hess);
 
     // D(x) is the friction potential (Equation 15 in the IPC paper)
     Eigen::VectorXd grad_Dx;
@@ -1117,14 +1363,155 @@ double DistanceBarrierRBProblem::compute_barrier_term(
     bool compute_grad,
     bool compute_hess)
 {
-    // Start by updating the constraint set
-    PosesD poses = this->dofs_to_poses(x);
-    Constraints constraints;
-    m_constraint.construct_constraint_set(m_assembler, poses, constraints);
-    num_constraints = constraints.num_constraints();
+    double Bx = compute_cached_barrier_term(
+        x, grad, hess, num_constraints, compute_grad, compute_hess);
 
     m_num_contacts = std::max(m_num_contacts, num_constraints);
 
+    return Bx;
+}
+
+std::shared_ptr<const DistanceBarrierRBProblem::BarrierEvaluation>
+DistanceBarrierRBProblem::cached_barrier_evaluation(
+    const Eigen::VectorXd& x) const
+{
+    std::shared_ptr<const BarrierEvaluation> cache;
+    {
+        std::scoped_lock lock(m_barrier_cache_mutex);
+        cache = m_barrier_cache;
+    }
+    if (cache != nullptr && cache->x.size() == x.size() && cache->x == x
+        && cache->dhat == barrier_activation_distance()) {
+        return cache;
+    }
+    return nullptr;
+}
+
+size_t
+DistanceBarrierRBProblem::active_constraint_set_hash(const Eigen::VectorXd& x)
+{
+    // Reuse the constraint set of the last evaluation if possible
+    std::shared_ptr<const BarrierEvaluation> cache =
+        cached_barrier_evaluation(x);
+    Constraints new_constraints;
+    const Constraints* constraints_ptr = &new_constraints;
+    if (cache != nullptr) {
+        constraints_ptr = &cache->constraints;
+    } else {
+        m_constraint.construct_constraint_set(
+            m_assembler, this->dofs_to_poses(x), new_constraints);
+    }
+    const Constraints& constraints = *constraints_ptr;
+
+    size_t hash = 0;
+    const auto hash_combine = [&hash](long value) {
+        hash ^= std::hash<long>()(value) + 0x9e3779b9 + (hash << 6)
+            + (hash >> 2);
+    };
+    for (const auto& vv : constraints.vv_constraints) {
+        hash_combine(vv.vertex0_index);
+        hash_combine(vv.vertex1_index);
+    }
+    hash_combine(-1);
+    for (const auto& ev : constraints.ev_constraints) {
+        hash_combine(ev.edge_index);
+        hash_combine(ev.vertex_index);
+    }
+    hash_combine(-1);
+    for (const auto& ee : constraints.ee_constraints) {
+        hash_combine(ee.edge0_index);
+        hash_combine(ee.edge1_index);
+    }
+    hash_combine(-1);
+    for (const auto& fv : constraints.fv_constraints) {
+        hash_combine(fv.face_index);
+        hash_combine(fv.vertex_index);
+    }
+    return hash;
+}
+
+bool DistanceBarrierRBProblem::dof_block_ordering(
+    const Eigen::VectorXd& x, std::vector<int>& order)
+{
+    PROFILE_POINT("DistanceBarrierRBProblem::dof_block_ordering");
+    PROFILE_START();
+
+    // Reuse the constraint set of the last evaluation if possible
+    std::shared_ptr<const BarrierEvaluation> cache =
+        cached_barrier_evaluation(x);
+    Constraints new_constraints;
+    const Constraints* constraints_ptr = &new_constraints;
+    if (cache != nullptr) {
+        constraints_ptr = &cache->constraints;
+    } else if (m_use_barriers) {
+        m_constraint.construct_constraint_set(
+            m_assembler, this->dofs_to_poses(x), new_constraints);
+    }
+    const Constraints& constraints = *constraints_ptr;
+
+    // Edges of the contact graph (bodies coupled by the barrier or friction)
+    std::vector<std::pair<int, int>> edges;
+    const auto add_edges = [&](const auto& constraint_set) {
+        for (size_t ci = 0; ci < constraint_set.size(); ci++) {
+            std::array<long, 2> ids =
+                body_ids(m_assembler, constraint_set, ci);
+            if (ids[0] != ids[1]) {
+                edges.emplace_back(
+                    std::min(ids[0], ids[1]), std::max(ids[0], ids[1]));
+            }
+        }
+    };
+    add_edges(constraints);
+    add_edges(friction_constraints);
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // The ordering only depends on the graph, so reuse it while it is stable
+    if (edges != m_contact_graph_edges || m_contact_graph_ordering.empty()) {
+        m_contact_graph_ordering =
+            nested_dissection_ordering(num_bodies(), edges);
+        m_contact_graph_edges = std::move(edges);
+    }
+    order = m_contact_graph_ordering;
+
+    PROFILE_END();
+
+    return true;
+}
+
+double DistanceBarrierRBProblem::compute_cached_barrier_term(
+    const Eigen::VectorXd& x,
+    Eigen::VectorXd& grad,
+    Eigen::SparseMatrix<double>& hess,
+    int& num_constraints,
+    bool compute_grad,
+    bool compute_hess)
+{
+    const double dhat = barrier_activation_distance();
+    std::shared_ptr<const BarrierEvaluation> cache =
+        cached_barrier_evaluation(x);
+    bool is_cached = cache != nullptr;
+
+    if (is_cached && !compute_grad && !compute_hess) {
+        num_constraints = cache->constraints.num_constraints();
+        return cache->potential;
+    }
+
+    std::shared_ptr<BarrierEvaluation> evaluation;
+    if (!is_cached) {
+        // Start by updating the constraint set
+        PosesD poses = this->dofs_to_poses(x);
+        evaluation = std::make_shared<BarrierEvaluation>();
+        evaluation->x = x;
+        evaluation->dhat = dhat;
+        m_constraint.construct_constraint_set(
+            m_assembler, poses, evaluation->constraints);
+        evaluation->V = m_assembler.world_vertices(poses);
+        cache = evaluation;
+    }
+    const Constraints& constraints = cache->constraints;
+    num_constraints = constraints.num_constraints();
+
     spdlog::debug(
         "problem={} num_vertex_vertex_constraint={:d} "
         "num_edge_vertex_constraints={:d} num_edge_edge_constraints={:d} "
@@ -1133,10 +1520,25 @@ double DistanceBarrierRBProblem::compute_barrier_term(
         constraints.ev_constraints.size(), constraints.ee_constraints.size(),
         constraints.fv_constraints.size());
 
-    double Bx = compute_barrier_term(
-        x, constraints, grad, hess, compute_grad, compute_hess);
+    // V(x) is cached, but its derivatives depend on what is requested
+    Eigen::MatrixXd jac_V, hess_V;
+    if (compute_grad || compute_hess) {
+        m_assembler.world_vertices_diff(
+            x, jac_V, hess_V, /*compute_jac=*/true, compute_hess);
+    }
 
-    return Bx;
+    double potential = assemble_barrier_term(
+        x, constraints, cache->V, jac_V, hess_V, grad, hess,
+        /*compute_value=*/!is_cached, compute_grad, compute_hess);
+
+    if (is_cached) {
+        return cache->potential;
+    }
+
+    evaluation->potential = potential;
+    std::scoped_lock lock(m_barrier_cache_mutex);
+    m_barrier_cache = evaluation;
+    return potential;
 }
 
 // Convert from a local hessian to the triplets in the global hessian
@@ -1154,25 +1556,36 @@ void local_gradient_to_global(
     }
 }
 
-template <typename DerivedLocalHessian>
-void local_hessian_to_global_triplets(
-    const Eigen::MatrixBase<DerivedLocalHessian>& local_hessian,
+void BodyPairHessian::add(
+    const MatrixMax12d& local_hessian,
     const std::array<long, 2>& body_ids,
-    int ndof,
-    std::vector<Eigen::Triplet<double>>& triplets)
+    int ndof)
 {
     assert(local_hessian.rows() == 2 * ndof);
     assert(local_hessian.cols() == 2 * ndof);
     for (int b_i = 0; b_i < body_ids.size(); b_i++) {
         for (int b_j = 0; b_j < body_ids.size(); b_j++) {
-            for (int dof_i = 0; dof_i < ndof; dof_i++) {
-                for (int dof_j = 0; dof_j < ndof; dof_j++) {
-                    double v =
-                        local_hessian(ndof * b_i + dof_i, ndof * b_j + dof_j);
-                    int r = ndof * body_ids[b_i] + dof_i;
-                    int c = ndof * body_ids[b_j] + dof_j;
-                    triplets.emplace_back(r, c, v);
-                }
+            auto [block, is_new] = blocks.try_emplace(
+                std::make_pair(body_ids[b_i], body_ids[b_j]));
+            if (is_new) {
+                block->second.setZero(ndof, ndof);
+            }
+            block->second += local_hessian.block(
+                ndof * b_i, ndof * b_j, ndof, ndof);
+        }
+    }
+}
+
+void BodyPairHessian::to_triplets(
+    int ndof, std::vector<Eigen::Triplet<double>>& triplets) const
+{
+    triplets.reserve(triplets.size() + blocks.size() * ndof * ndof);
+    for (const auto& [body_pair, block] : blocks) {
+        for (int dof_i = 0; dof_i < ndof; dof_i++) {
+            for (int dof_j = 0; dof_j < ndof; dof_j++) {
+                triplets.emplace_back(
+                    ndof * body_pair.first + dof_i,
+                    ndof * body_pair.second + dof_j, block(dof_i, dof_j));
             }
         }
     }
@@ -1189,7 +1602,7 @@ void apply_chain_rule(
     const std::array<long, 2>& body_ids,
     const int dim,
     Eigen::VectorXd& grad,
-    std::vector<Eigen::Triplet<double>>& hess_triplets,
+    BodyPairHessian& hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1197,8 +1610,8 @@ void apply_chain_rule(
         return;
     }
 
-    // PROFILE_POINT("apply_chain_rule");
-    // PROFILE_START();
+    PROFILE_POINT("apply_chain_rule");
+    PROFILE_START();
 
     const int rb_ndof = PoseD::dim_to_ndof(dim);
 
@@ -1240,11 +1653,10 @@ void apply_chain_rule(
 
         hess = project_to_psd(hess);
 
-        local_hessian_to_global_triplets(
-            hess, body_ids, rb_ndof, hess_triplets);
+        hess_blocks.add(hess, body_ids, rb_ndof);
     }
 
-    // PROFILE_END();
+    PROFILE_END();
 }
 
 struct PotentialStorage {
@@ -1252,7 +1664,7 @@ struct PotentialStorage {
     PotentialStorage(size_t nvars) { gradient.setZero(nvars); }
     double potential = 0;
     Eigen::VectorXd gradient;
-    std::vector<Eigen::Triplet<double>> hessian_triplets;
+    BodyPairHessian hessian_blocks;
 };
 typedef tbb::enumerable_thread_specific<PotentialStorage>
     ThreadSpecificPotentials;
@@ -1260,6 +1672,7 @@ typedef tbb::enumerable_thread_specific<PotentialStorage>
 double merge_derivative_storage(
     const ThreadSpecificPotentials& potentials,
     size_t nvars,
+    int ndof,
     Eigen::VectorXd& grad,
     Eigen::SparseMatrix<double>& hess,
     bool compute_grad,
@@ -1276,6 +1689,7 @@ double merge_derivative_storage(
     }
 
     double potential = 0;
+    std::vector<Eigen::Triplet<double>> hess_triplets;
     for (const auto& p : potentials) {
         potential += p.potential;
 
@@ -1284,9 +1698,10 @@ double merge_derivative_storage(
         }
 
         if (compute_hess) {
+            hess_triplets.clear();
+            p.hessian_blocks.to_triplets(ndof, hess_triplets);
             Eigen::SparseMatrix<double> p_hess(nvars, nvars);
-            p_hess.setFromTriplets(
-                p.hessian_triplets.begin(), p.hessian_triplets.end());
+            p_hess.setFromTriplets(hess_triplets.begin(), hess_triplets.end());
             hess += p_hess;
         }
     }
@@ -1310,27 +1725,47 @@ double DistanceBarrierRBProblem::compute_barrier_term(
         return 0;
     }
 
-    PROFILE_POINT("DistanceBarrierRBProblem::compute_barrier_term");
-    // WARNING: PROFILE_POINTs are not thread safe
-    // NAMED_PROFILE_POINT(
-    //     "DistanceBarrierRBProblem::compute_barrier_term:value",
-    //     COMPUTE_BARRIER_VAL);
-    // NAMED_PROFILE_POINT(
-    //     "DistanceBarrierRBProblem::compute_barrier_term:gradient",
-    //     COMPUTE_BARRIER_GRAD);
-    // NAMED_PROFILE_POINT(
-    //     "DistanceBarrierRBProblem::compute_barrier_term:hessian",
-    //     COMPUTE_BARRIER_HESS);
-
-    PROFILE_START();
-
-    int rb_ndof = PoseD::dim_to_ndof(dim());
-
     // Compute V(x)
     Eigen::MatrixXd jac_V, hess_V;
     Eigen::MatrixXd V = m_assembler.world_vertices_diff(
         x, jac_V, hess_V, compute_grad || compute_hess, compute_hess);
 
+    return assemble_barrier_term(
+        x, constraints, V, jac_V, hess_V, grad, hess, /*compute_value=*/true,
+        compute_grad, compute_hess);
+}
+
+double DistanceBarrierRBProblem::assemble_barrier_term(
+    const Eigen::VectorXd& x,
+    const Constraints& constraints,
+    const Eigen::MatrixXd& V,
+    const Eigen::MatrixXd& jac_V,
+    const Eigen::MatrixXd& hess_V,
+    Eigen::VectorXd& grad,
+    Eigen::SparseMatrix<double>& hess,
+    bool compute_value,
+    bool compute_grad,
+    bool compute_hess)
+{
+    if (constraints.size() == 0) {
+        grad.setZero(x.size());
+        hess.resize(x.size(), x.size());
+        return 0;
+    }
+
+    PROFILE_POINT("DistanceBarrierRBProblem::compute_barrier_term");
+    NAMED_PROFILE_POINT(
+        "DistanceBarrierRBProblem::compute_barrier_term:value",
+        COMPUTE_BARRIER_VAL);
+    NAMED_PROFILE_POINT(
+        "DistanceBarrierRBProblem::compute_barrier_term:gradient",
+        COMPUTE_BARRIER_GRAD);
+    NAMED_PROFILE_POINT(
+        "DistanceBarrierRBProblem::compute_barrier_term:hessian",
+        COMPUTE_BARRIER_HESS);
+
+    PROFILE_START();
+
     double dhat = barrier_activation_distance();
 
     ThreadSpecificPotentials thread_storage(x.size());
@@ -1341,31 +1776,33 @@ double DistanceBarrierRBProblem::compute_barrier_term(
             auto& local_storage = thread_storage.local();
             auto& potential = local_storage.potential;
             auto& local_grad = local_storage.gradient;
-            auto& hess_triplets = local_storage.hessian_triplets;
+            auto& hess_blocks = local_storage.hessian_blocks;
 
             for (size_t ci = range.begin(); ci != range.end(); ++ci) {
                 const auto& constraint = constraints[ci];
 
-                // PROFILE_START(COMPUTE_BARRIER_VAL);
-                potential +=
-                    constraint.compute_potential(V, edges(), faces(), dhat);
-                // PROFILE_START(COMPUTE_BARRIER_VAL);
+                if (compute_value) {
+                    PROFILE_START(COMPUTE_BARRIER_VAL);
+                    potential +=
+                        constraint.compute_potential(V, edges(), faces(), dhat);
+                    PROFILE_END(COMPUTE_BARRIER_VAL);
+                }
 
                 VectorMax12d grad_B;
                 if (compute_grad || compute_hess) {
-                    // PROFILE_START(COMPUTE_BARRIER_GRAD);
+                    PROFILE_START(COMPUTE_BARRIER_GRAD);
                     grad_B = constraint.compute_potential_gradient(
                         V, edges(), faces(), dhat);
-                    // PROFILE_END(COMPUTE_BARRIER_GRAD);
+                    PROFILE_END(COMPUTE_BARRIER_GRAD);
                 }
 
                 MatrixMax12d hess_B;
                 if (compute_hess) {
-                    // PROFILE_START(COMPUTE_BARRIER_HESS);
+                    PROFILE_START(COMPUTE_BARRIER_HESS);
                     hess_B = constraint.compute_potential_hessian(
                         V, edges(), faces(), dhat,
                         /*project_hessian_to_psd=*/false);
-                    // PROFILE_END(COMPUTE_BARRIER_HESS);
+                    PROFILE_END(COMPUTE_BARRIER_HESS);
                 }
 
                 apply_chain_rule(
@@ -1373,12 +1810,13 @@ double DistanceBarrierRBProblem::compute_barrier_term(
                     constraint.vertex_indices(edges(), faces()),
                     vertex_local_body_ids(constraints, ci),
                     body_ids(m_assembler, constraints, ci), dim(), local_grad,
-                    hess_triplets, compute_grad, compute_hess);
+                    hess_blocks, compute_grad, compute_hess);
             }
         });
 
     double potential = merge_derivative_storage(
-        thread_storage, x.size(), grad, hess, compute_grad, compute_hess);
+        thread_storage, x.size(), PoseD::dim_to_ndof(dim()), grad, hess,
+        compute_grad, compute_hess);
 
     PROFILE_END();
 
@@ -1398,15 +1836,15 @@ double DistanceBarrierRBProblem::compute_barrier_term(
     return potential;
 }
 
-// NAMED_PROFILE_POINT(
-//     "DistanceBarrierRBProblem::compute_friction_potential:value",
-//     COMPUTE_FRICTION_VAL);
-// NAMED_PROFILE_POINT(
-//     "DistanceBarrierRBProblem::compute_friction_potential:gradient",
-//     COMPUTE_FRICTION_GRAD);
-// NAMED_PROFILE_POINT(
-//     "DistanceBarrierRBProblem::compute_friction_potential:hessian",
-//     COMPUTE_FRICTION_HESS);
+NAMED_PROFILE_POINT(
+    "DistanceBarrierRBProblem::compute_friction_potential:value",
+    COMPUTE_FRICTION_VAL);
+NAMED_PROFILE_POINT(
+    "DistanceBarrierRBProblem::compute_friction_potential:gradient",
+    COMPUTE_FRICTION_GRAD);
+NAMED_PROFILE_POINT(
+    "DistanceBarrierRBProblem::compute_friction_potential:hessian",
+    COMPUTE_FRICTION_HESS);
 template <typename RigidBodyConstraint, typename FrictionConstraint>
 double DistanceBarrierRBProblem::compute_friction_potential(
     const Eigen::MatrixXd& U,
@@ -1414,7 +1852,7 @@ double DistanceBarrierRBProblem::compute_friction_potential(
     const Eigen::MatrixXd& hess_V,
     const FrictionConstraint& constraint,
     Eigen::VectorXd& grad,
-    std::vector<Eigen::Triplet<double>>& hess_triplets,
+    BodyPairHessian& hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1435,25 +1873,25 @@ double DistanceBarrierRBProblem::compute_friction_potential(
 
     double epsv_times_h = static_friction_speed_bound * timestep();
 
-    // PROFILE_START(COMPUTE_FRICTION_VAL);
+    PROFILE_START(COMPUTE_FRICTION_VAL);
     double Dx = constraint.compute_potential(U, edges(), faces(), epsv_times_h);
-    // PROFILE_END(COMPUTE_FRICTION_VAL);
+    PROFILE_END(COMPUTE_FRICTION_VAL);
 
     VectorMax12d grad_D;
     if (compute_grad || compute_hess) {
-        // PROFILE_START(COMPUTE_FRICTION_GRAD);
+        PROFILE_START(COMPUTE_FRICTION_GRAD);
         grad_D = constraint.compute_potential_gradient(
             U, edges(), faces(), epsv_times_h);
-        // PROFILE_END(COMPUTE_FRICTION_GRAD);
+        PROFILE_END(COMPUTE_FRICTION_GRAD);
     }
 
     MatrixMax12d hess_D;
     if (compute_hess) {
-        // PROFILE_START(COMPUTE_FRICTION_HESS);
+        PROFILE_START(COMPUTE_FRICTION_HESS);
         hess_D = constraint.compute_potential_hessian(
             U, edges(), faces(), epsv_times_h,
             /*project_hessian_to_psd=*/false);
-        // PROFILE_END(COMPUTE_FRICTION_HESS);
+        PROFILE_END(COMPUTE_FRICTION_HESS);
     }
 
     RigidBodyConstraint rbc(m_assembler, constraint);
@@ -1461,7 +1899,7 @@ double DistanceBarrierRBProblem::compute_friction_potential(
         grad_D, jac_V, hess_D, hess_V,
         constraint.vertex_indices(edges(), faces()),
         rbc.vertex_local_body_ids(), rbc.body_ids(), dim(), //
-        grad, hess_triplets, compute_grad, compute_hess);
+        grad, hess_blocks, compute_grad, compute_hess);
 
     return Dx;
 }
@@ -1494,7 +1932,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
         DISPLACEMENT);
     PROFILE_START(DISPLACEMENT);
     // absolute linear dislacement of each point
-    Eigen::MatrixXd U = V1 - m_assembler.world_vertices(poses_t0);
+    Eigen::MatrixXd U = V1 - world_vertices_t0;
     PROFILE_END(DISPLACEMENT);
 
     ThreadSpecificPotentials thread_storage(x.size());
@@ -1505,7 +1943,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
             auto& local_storage = thread_storage.local();
             auto& potential = local_storage.potential;
             auto& local_grad = local_storage.gradient;
-            auto& hess_triplets = local_storage.hessian_triplets;
+            auto& hess_blocks = local_storage.hessian_blocks;
 
             for (size_t ci = range.begin(); ci != range.end(); ++ci) {
                 size_t local_ci = ci;
@@ -1515,7 +1953,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
                         RigidBodyVertexVertexConstraint>(
                         U, jac_V, hess_V,
                         friction_constraints.vv_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
+                        local_grad, hess_blocks, compute_grad, compute_hess);
                     continue;
                 }
 
@@ -1525,7 +1963,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
                         RigidBodyEdgeVertexConstraint>(
                         U, jac_V, hess_V,
                         friction_constraints.ev_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
+                        local_grad, hess_blocks, compute_grad, compute_hess);
                     continue;
                 }
 
@@ -1535,7 +1973,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
                         compute_friction_potential<RigidBodyEdgeEdgeConstraint>(
                             U, jac_V, hess_V,
                             friction_constraints.ee_constraints[local_ci],
-                            local_grad, hess_triplets, compute_grad,
+                            local_grad, hess_blocks, compute_grad,
                             compute_hess);
                     continue;
                 }
@@ -1546,12 +1984,13 @@ double DistanceBarrierRBProblem::compute_friction_term(
                     compute_friction_potential<RigidBodyFaceVertexConstraint>(
                         U, jac_V, hess_V,
                         friction_constraints.fv_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
+                        local_grad, hess_blocks, compute_grad, compute_hess);
             }
         });
 
     double potential = merge_derivative_storage(
-        thread_storage, x.size(), grad, hess, compute_grad, compute_hess);
+        thread_storage, x.size(), PoseD::dim_to_ndof(dim()), grad, hess,
+        compute_grad, compute_hess);
 
     PROFILE_END();
 
@@ -1583,9 +2022,19 @@ double DistanceBarrierRBProblem::compute_min_distance() const
 double
 DistanceBarrierRBProblem::compute_min_distance(const Eigen::VectorXd& x) const
 {
-    PosesD poses = this->dofs_to_poses(x);
-    double min_distance =
-        m_constraint.compute_minimum_distance(m_assembler, poses);
+    double min_distance;
+    std::shared_ptr<const BarrierEvaluation> cache =
+        cached_barrier_evaluation(x);
+    if (cache != nullptr) {
+        // Reduce over the constraints of the barrier evaluation at x instead
+        // of rebuilding the constraint set and V(x).
+        min_distance = sqrt(ipc::compute_minimum_distance(
+            cache->V, edges(), faces(), cache->constraints));
+    } else {
+        PosesD poses = this->dofs_to_poses(x);
+        min_distance =
+            m_constraint.compute_minimum_distance(m_assembler, poses);
+    }
     return std::isfinite(min_distance) ? min_distance : -1;
 }
 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 #include <tbb/concurrent_vector.h>
 
 #include <ipc/collision_constraint.hpp>
@@ -32,6 +36,36 @@ NLOHMANN_JSON_SERIALIZE_ENUM(
       { STABILIZED_NEWMARK, "stabilized_newmark" },
       { DEFAULT_BODY_ENERGY_INTEGRATION_METHOD, "default" } });
 
+/// @brief Local Hessians of the contact potentials summed per pair of bodies.
+///
+/// Constraints between the same bodies add to the same ndof × ndof blocks,
+/// so the global Hessian is built from one block per pair of bodies in
+/// contact instead of one per constraint.
+class BodyPairHessian {
+public:
+    /// @brief Add the local Hessian of a constraint between two bodies.
+    void add(
+        const MatrixMax12d& local_hessian,
+        const std::array<long, 2>& body_ids,
+        int ndof);
+
+    /// @brief Append the triplets of the global Hessian.
+    void
+    to_triplets(int ndof, std::vector<Eigen::Triplet<double>>& triplets) const;
+
+protected:
+    struct BodyPairHash {
+        size_t operator()(const std::pair<long, long>& p) const
+        {
+            return std::hash<long>()(p.first)
+                ^ (std::hash<long>()(p.second) << 1);
+        }
+    };
+    /// Block of the Hessian for each (row body, column body)
+    std::unordered_map<std::pair<long, long>, MatrixMax6d, BodyPairHash>
+        blocks;
+};
+
 /// This class is both a simulation and optimization problem.
 class DistanceBarrierRBProblem : public RigidBodyProblem,
                                  public virtual BarrierProblem {
@@ -76,7 +110,10 @@ public:
         return m_assembler.is_rb_dof_fixed;
     }
 
-    Eigen::VectorXi free_dof() const override;
+    int dof_block_size() const override { return PoseD::dim_to_ndof(dim()); }
+
+    const Eigen::VectorXi& free_dof() const override { return m_free_dof; }
+    size_t free_dof_version() const override { return m_free_dof_version; }
 
     /// Determine if there is a collision between two configurations
     bool has_collisions(
@@ -198,6 +235,12 @@ public:
         m_barrier_stiffness = kappa;
     }
 
+    size_t active_constraint_set_hash(const Eigen::VectorXd& x) override;
+
+    /// Nested dissection ordering of the bodies on the contact graph at x.
+    bool dof_block_ordering(
+        const Eigen::VectorXd& x, std::vector<int>& order) override;
+
     CollisionConstraint& constraint() override { return m_constraint; }
     const CollisionConstraint& constraint() const override
     {
@@ -205,6 +248,8 @@ public:
     }
     OptimizationSolver& solver() override { return *m_opt_solver; }
 
+    bool is_objective_thread_safe() const override { return true; }
+
     int num_contacts() const override { return m_num_contacts; };
 
     ////////////////////////////////////////////////////////////
@@ -241,6 +286,13 @@ protected:
     /// Update problem using current status of bodies.
     virtual void update_constraints() override;
 
+    /// Extrapolate the current poses using the velocity and acceleration of
+    /// the previous step. Call before the poses are advanced.
+    PosesD extrapolate_poses() const;
+    /// Build the initial Newton iterate from the extrapolated poses, clamped
+    /// to remain intersection-free along the trajectory from x0.
+    void update_warm_start(const PosesD& extrapolated_poses);
+
     /// Update problem using current status of bodies.
     void update_friction_constraints(
         const Constraints& collision_constraints, const PosesD& poses);
@@ -258,7 +310,7 @@ protected:
         const Eigen::MatrixXd& hess_V,
         const FrictionConstraint& constraint,
         Eigen::VectorXd& grad,
-        std::vector<Eigen::Triplet<double>>& hess_triplets,
+        BodyPairHessian& hess_blocks,
         bool compute_grad,
         bool compute_hess);
 
@@ -293,6 +345,29 @@ protected:
             /*compute_hess=*/false);
     }
 
+    /// Computes the barrier term from the distance constraints given V(x) and
+    /// its derivatives. The potential is only summed if compute_value is true.
+    double assemble_barrier_term(
+        const Eigen::VectorXd& x,
+        const Constraints& distance_constraints,
+        const Eigen::MatrixXd& V,
+        const Eigen::MatrixXd& jac_V,
+        const Eigen::MatrixXd& hess_V,
+        Eigen::VectorXd& grad,
+        Eigen::SparseMatrix<double>& hess,
+        bool compute_value,
+        bool compute_grad,
+        bool compute_hess);
+
+    /// Computes the barrier term at x reusing the evaluation cache.
+    double compute_cached_barrier_term(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        Eigen::SparseMatrix<double>& hess,
+        int& num_constraints,
+        bool compute_grad,
+        bool compute_hess);
+
 #ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
     // The following functions are used exclusivly to check that the
     // gradient and hessian match a finite difference version.
@@ -348,10 +423,43 @@ protected:
     /// @brief Gradient of barrier potential at the start of the time-step.
     Eigen::VectorXd grad_barrier_t0;
 
+    /// @brief Barrier quantities of the last point evaluated.
+    ///
+    /// The line search evaluates f(x) at the accepted point and the next
+    /// Newton iteration evaluates the derivatives at the same point, so the
+    /// constraint set, V(x), and the barrier potential are shared by the two.
+    /// The minimum distance for the adaptive κ is also reduced from them.
+    /// Evaluations are immutable once cached, so they can be read while
+    /// another thread replaces the cache.
+    struct BarrierEvaluation {
+        Eigen::VectorXd x;       ///< Point of the evaluation
+        double dhat;             ///< Activation distance used at x
+        Constraints constraints; ///< Active constraint set at x
+        Eigen::MatrixXd V;       ///< World vertices V(x)
+        double potential;        ///< Barrier potential ∑_{k ∈ C} b(d(x_k))
+    };
+    std::shared_ptr<const BarrierEvaluation> m_barrier_cache;
+    mutable std::mutex m_barrier_cache_mutex;
+
+    /// @brief Get the cached evaluation at x (nullptr if x is not cached).
+    std::shared_ptr<const BarrierEvaluation>
+    cached_barrier_evaluation(const Eigen::VectorXd& x) const;
+
+    /// Contacting body pairs the block ordering was computed from
+    std::vector<std::pair<int, int>> m_contact_graph_edges;
+    /// Nested dissection ordering of the bodies on the contact graph
+    std::vector<int> m_contact_graph_ordering;
+
     // Friction
     double static_friction_speed_bound;
     int friction_iterations;
     FrictionConstraints friction_constraints;
+    /// Poses and parameters the friction constraints were built with
+    PosesD friction_constraint_poses;
+    double friction_constraint_dhat, friction_constraint_kappa,
+        friction_constraint_mu;
+    /// World vertices at the start of the step (for the displacements)
+    Eigen::MatrixXd world_vertices_t0;
 
     // Augmented Lagrangian
     double linear_augmented_lagrangian_penalty;
@@ -359,8 +467,21 @@ protected:
     Eigen::VectorXd linear_augmented_lagrangian_multiplier;
     Eigen::MatrixXd angular_augmented_lagrangian_multiplier;
     Eigen::VectorXd x_pred; ///< Predicted DoF using unconstrained timestep
+
+    /// Start Newton from the extrapolated poses instead of x0 (opt-in).
+    bool use_warm_start;
+    /// Initial Newton iterate (empty if x0 should be used)
+    Eigen::VectorXd x_warm_start;
     VectorXb is_dof_satisfied;
 
+    /// Update the free DoF after the fixed or satisfied DoF change (they are
+    /// first set when the constraints are initialized by init()).
+    void update_free_dof();
+    /// DoF that are neither fixed nor satisfied
+    Eigen::VectorXi m_free_dof;
+    /// Incremented every time m_free_dof changes
+    size_t m_free_dof_version;
+
 private:
     /// Method for integrating the body energy.
     BodyEnergyIntegrationMethod body_energy_integration_method;
@@ -259,11 +259,11 @@ void SplitDistanceBarrierRBProblem::solve_velocities()
         // (90deg rotation counter clockwise)
         //
         // (1) first get vertices position wrt rigid bodies
-        const Eigen::Vector2d r0_A = body_A.vertices.row(r_A_id);
+        const Eigen::Vector2d r0_A = body_A.vertices().row(r_A_id);
         const Eigen::Vector2d r0_B0 =
-            body_B.vertices.row(r_B0_id); // edge vertex 0
+            body_B.vertices().row(r_B0_id); // edge vertex 0
         const Eigen::Vector2d r0_B1 =
-            body_B.vertices.row(r_B1_id); // edge vertex 1
+            body_B.vertices().row(r_B1_id); // edge vertex 1
         const Eigen::Vector2d r0_B = r0_B0 + alpha * (r0_B1 - r0_B0);
 
         // (2) and the angular displacement at time of collision
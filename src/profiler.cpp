@@ -2,6 +2,7 @@
 #include <logger.hpp>
 #include <map>
 #include <profiler.hpp>
+#include <thread>
 #include <utils/get_rss.hpp>
 
 #ifdef RIGID_IPC_PROFILE_FUNCTIONS
@@ -13,6 +14,14 @@ namespace profiler {
     // PROFILER POINT
     // -----------------------------------------------------------------
 
+    // Static initialization happens on the main thread
+    static const std::thread::id main_thread_id = std::this_thread::get_id();
+
+    ProfilerPoint::ThreadCounters::ThreadCounters()
+        : is_main_thread(std::this_thread::get_id() == main_thread_id)
+    {
+    }
+
     ProfilerPoint::ProfilerPoint(const std::string name)
         : m_name(name)
     {
@@ -21,44 +30,78 @@ namespace profiler {
 
     void ProfilerPoint::begin()
     {
-        if (is_active) {
-            throw fmt::format("ProfilePoint {} is already active!", name());
+        ThreadCounters& counters = m_counters.local();
+        if (counters.active_depth++ > 0) {
+            return; // Nested in an evaluation of this thread
+        }
+        if (counters.is_main_thread) {
+            counters.beginning_peak_rss = getPeakRSS();
         }
-        timer.start();
-        beginning_peak_rss = getPeakRSS();
-        is_active = true;
+        counters.beginning_time = Clock::now();
     }
 
     void ProfilerPoint::end()
     {
-        if (is_active) {
-            timer.stop();
-            m_total_time += timer.getElapsedTime();
-            m_num_evaluations++;
-            m_max_peak_rss_change = std::max(
-                m_max_peak_rss_change, getPeakRSS() - beginning_peak_rss);
-            is_active = false;
+        const Clock::time_point end_time = Clock::now();
+        ThreadCounters& counters = m_counters.local();
+        if (counters.active_depth == 0 || --counters.active_depth > 0) {
+            return;
+        }
+        counters.total_time += end_time - counters.beginning_time;
+        counters.num_evaluations++;
+        if (counters.is_main_thread) {
+            counters.max_peak_rss_change = std::max(
+                counters.max_peak_rss_change,
+                getPeakRSS() - counters.beginning_peak_rss);
+        }
+    }
+
+    size_t ProfilerPoint::num_evaluations() const
+    {
+        size_t num_evaluations = 0;
+        for (const ThreadCounters& counters : m_counters) {
+            num_evaluations += counters.num_evaluations;
+        }
+        return num_evaluations;
+    }
+
+    double ProfilerPoint::total_time() const
+    {
+        Clock::duration total_time = Clock::duration::zero();
+        for (const ThreadCounters& counters : m_counters) {
+            total_time += counters.total_time;
+        }
+        return std::chrono::duration<double>(total_time).count();
+    }
+
+    size_t ProfilerPoint::max_peak_rss_change() const
+    {
+        size_t max_peak_rss_change = 0;
+        for (const ThreadCounters& counters : m_counters) {
+            max_peak_rss_change =
+                std::max(max_peak_rss_change, counters.max_peak_rss_change);
         }
+        return max_peak_rss_change;
     }
 
     void ProfilerPoint::message_header(const std::string& header)
     {
+        std::scoped_lock lock(m_messages_mutex);
         m_message_header = header;
     }
 
     void ProfilerPoint::message(const std::string& m)
     {
+        std::scoped_lock lock(m_messages_mutex);
         m_messages.push_back(m);
     }
 
     void ProfilerPoint::clear()
     {
-        m_num_evaluations = 0;
-        m_total_time = 0;
-        m_max_peak_rss_change = 0;
+        m_counters.clear();
+        std::scoped_lock lock(m_messages_mutex);
         m_message_header = "";
         m_messages.clear();
-        is_active = false;
     }
 
     // -----------------------------------------------------------------
@@ -76,6 +119,7 @@ namespace profiler {
         if (main != nullptr) {
             main->clear();
         }
+        std::scoped_lock lock(points_mutex);
         for (auto& p : points) {
             p->clear();
         }
@@ -84,6 +128,7 @@ namespace profiler {
     std::shared_ptr<ProfilerPoint> Profiler::create_point(std::string name)
     {
         auto point = std::make_shared<ProfilerPoint>(name);
+        std::scoped_lock lock(points_mutex);
         points.push_back(point);
         return point;
     }
@@ -100,6 +145,7 @@ namespace profiler {
         outpath /= fmt::format("log-{}", current_time_string());
         fs::create_directories(outpath);
 
+        std::scoped_lock lock(points_mutex);
         write_summary(outpath.string(), fin);
         for (auto& p : points) {
             write_point_details(outpath.string(), *p);
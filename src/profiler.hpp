@@ -2,12 +2,15 @@
 
 #ifdef RIGID_IPC_PROFILE_FUNCTIONS
 
-#include <igl/Timer.h>
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <vector>
 
+#include <tbb/enumerable_thread_specific.h>
+
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
@@ -15,6 +18,11 @@
 namespace ipc::rigid {
 namespace profiler {
 
+    /// @brief Timer of a section of code that can be evaluated by
+    /// multiple threads at once.
+    ///
+    /// Every thread accumulates its own counters without synchronization,
+    /// and the counters of all threads are merged when they are reported.
     class ProfilerPoint {
     public:
         ProfilerPoint(const std::string name);
@@ -26,12 +34,11 @@ namespace profiler {
 
         const std::string& name() const { return m_name; }
 
-        size_t num_evaluations() const { return m_num_evaluations; }
-        const double& total_time() const { return m_total_time; }
-        const size_t& max_peak_rss_change() const
-        {
-            return m_max_peak_rss_change;
-        }
+        size_t num_evaluations() const;
+        /// Summed over the threads, so it can exceed the wall time of the
+        /// parallel code evaluating the point.
+        double total_time() const;
+        size_t max_peak_rss_change() const;
 
         void message_header(const std::string& header);
         const std::string& message_header() const { return m_message_header; }
@@ -39,16 +46,32 @@ namespace profiler {
         const std::vector<std::string>& messages() const { return m_messages; }
 
     protected:
+        typedef std::chrono::steady_clock Clock;
+
+        /// Counters of the evaluations of a single thread
+        struct ThreadCounters {
+            ThreadCounters();
+
+            size_t num_evaluations = 0;
+            Clock::duration total_time = Clock::duration::zero();
+            size_t max_peak_rss_change = 0;
+
+            Clock::time_point beginning_time;
+            size_t beginning_peak_rss = 0;
+            /// Depth of the nested evaluations, because a thread waiting on
+            /// parallel work can steal a task evaluating the same point.
+            /// Only the outermost evaluation is timed.
+            size_t active_depth = 0;
+            /// The peak RSS is process wide, so only the main thread
+            /// samples it (getting it is a system call).
+            bool is_main_thread;
+        };
+
         std::string m_name;
-        size_t m_num_evaluations;
-        double m_total_time;
-        size_t m_max_peak_rss_change;
+        tbb::enumerable_thread_specific<ThreadCounters> m_counters;
         std::string m_message_header;
         std::vector<std::string> m_messages;
-
-        igl::Timer timer;
-        bool is_active;
-        size_t beginning_peak_rss;
+        std::mutex m_messages_mutex;
     };
 
     class Profiler {
@@ -71,6 +94,8 @@ namespace profiler {
 
         std::shared_ptr<ProfilerPoint> main;
         std::vector<std::shared_ptr<ProfilerPoint>> points;
+        /// Points can be created concurrently by parallel code
+        std::mutex points_mutex;
     };
 
     class ProfilerLog {
@@ -0,0 +1,141 @@
+#include "conjugate_gradient.hpp"
+
+#include <Eigen/Cholesky>
+#include <tbb/parallel_for.h>
+
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+void BlockJacobiPreconditioner::compute(
+    const Eigen::SparseMatrix<double>& A, const std::vector<int>& block_starts)
+{
+    assert(A.rows() == A.cols());
+    assert(A.rows() == 0 || (!block_starts.empty() && block_starts[0] == 0));
+    m_block_starts = block_starts;
+    if (m_block_starts.empty() || m_block_starts.back() != A.rows()) {
+        m_block_starts.push_back(A.rows());
+    }
+    m_inverse_blocks.resize(m_block_starts.size() - 1);
+
+    tbb::parallel_for(size_t(0), m_inverse_blocks.size(), [&](size_t bi) {
+        const int start = m_block_starts[bi];
+        const int size = m_block_starts[bi + 1] - start;
+
+        // Gather the dense diagonal block
+        Eigen::MatrixXd block = Eigen::MatrixXd::Zero(size, size);
+        for (int j = 0; j < size; j++) {
+            for (Eigen::SparseMatrix<double>::InnerIterator it(A, start + j);
+                 it; ++it) {
+                const int i = it.row() - start;
+                if (i >= 0 && i < size) {
+                    block(i, j) = it.value();
+                }
+            }
+        }
+
+        Eigen::LLT<Eigen::MatrixXd> llt(block);
+        if (llt.info() == Eigen::Success) {
+            m_inverse_blocks[bi] =
+                llt.solve(Eigen::MatrixXd::Identity(size, size));
+        } else {
+            // Fall back to the (absolute) diagonal
+            Eigen::VectorXd diag = block.diagonal().cwiseAbs();
+            m_inverse_blocks[bi] =
+                (diag.array() > 0)
+                    .select(diag.cwiseInverse(), Eigen::VectorXd::Ones(size))
+                    .asDiagonal();
+        }
+    });
+}
+
+Eigen::VectorXd
+BlockJacobiPreconditioner::solve(const Eigen::VectorXd& r) const
+{
+    Eigen::VectorXd z(r.size());
+    tbb::parallel_for(size_t(0), m_inverse_blocks.size(), [&](size_t bi) {
+        const int start = m_block_starts[bi];
+        const int size = m_block_starts[bi + 1] - start;
+        z.segment(start, size) = m_inverse_blocks[bi] * r.segment(start, size);
+    });
+    return z;
+}
+
+void symmetric_sparse_matrix_vector_product(
+    const Eigen::SparseMatrix<double>& A,
+    const Eigen::VectorXd& x,
+    Eigen::VectorXd& y)
+{
+    assert(A.rows() == A.cols() && A.cols() == x.size());
+    y.resize(A.rows());
+    // A is symmetric, so (Ax)ᵢ is the dot product of the i-th column with x.
+    // This lets the columns of the column-major matrix be split over threads.
+    tbb::parallel_for(
+        tbb::blocked_range<Eigen::Index>(0, A.cols()),
+        [&](const tbb::blocked_range<Eigen::Index>& range) {
+            for (Eigen::Index i = range.begin(); i != range.end(); ++i) {
+                double yi = 0;
+                for (Eigen::SparseMatrix<double>::InnerIterator it(A, i); it;
+                     ++it) {
+                    yi += it.value() * x[it.row()];
+                }
+                y[i] = yi;
+            }
+        });
+}
+
+bool preconditioned_conjugate_gradient(
+    const Eigen::SparseMatrix<double>& A,
+    const Eigen::VectorXd& b,
+    const BlockJacobiPreconditioner& preconditioner,
+    const double tolerance,
+    const int max_iterations,
+    Eigen::VectorXd& x,
+    int& num_iterations)
+{
+    PROFILE_POINT("preconditioned_conjugate_gradient");
+    PROFILE_START();
+
+    num_iterations = 0;
+    if (x.size() != b.size()) {
+        x.setZero(b.size());
+    }
+
+    Eigen::VectorXd Ax;
+    symmetric_sparse_matrix_vector_product(A, x, Ax);
+    Eigen::VectorXd r = b - Ax;
+    const double threshold_sqr = tolerance * tolerance * b.squaredNorm();
+
+    Eigen::VectorXd z = preconditioner.solve(r);
+    Eigen::VectorXd p = z;
+    Eigen::VectorXd Ap;
+    double r_dot_z = r.dot(z);
+
+    bool success = true;
+    while (num_iterations < max_iterations
+           && r.squaredNorm() > threshold_sqr) {
+        symmetric_sparse_matrix_vector_product(A, p, Ap);
+        const double p_dot_Ap = p.dot(Ap);
+        if (!(p_dot_Ap > 0)) {
+            // Non-positive curvature: stop at the current iterate
+            success = num_iterations > 0;
+            break;
+        }
+
+        const double alpha = r_dot_z / p_dot_Ap;
+        x += alpha * p;
+        r -= alpha * Ap;
+        num_iterations++;
+
+        z = preconditioner.solve(r);
+        const double r_dot_z_new = r.dot(z);
+        p = z + (r_dot_z_new / r_dot_z) * p;
+        r_dot_z = r_dot_z_new;
+    }
+
+    PROFILE_END();
+
+    return success && x.allFinite();
+}
+
+} // namespace ipc::rigid
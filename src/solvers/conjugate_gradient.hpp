@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+namespace ipc::rigid {
+
+/// @brief Block-Jacobi preconditioner of a sparse symmetric matrix.
+///
+/// Each diagonal block (e.g., the DoF of a rigid body) is inverted densely.
+/// Blocks that are not positive definite fall back to their diagonal.
+class BlockJacobiPreconditioner {
+public:
+    /// @brief Invert the diagonal blocks of A.
+    /// @param block_starts Sorted index of the first row of every block.
+    void compute(
+        const Eigen::SparseMatrix<double>& A,
+        const std::vector<int>& block_starts);
+
+    /// @brief Apply the preconditioner (z = M⁻¹ r).
+    Eigen::VectorXd solve(const Eigen::VectorXd& r) const;
+
+protected:
+    std::vector<int> m_block_starts; ///< Includes the end as the last entry
+    std::vector<Eigen::MatrixXd> m_inverse_blocks;
+};
+
+/// @brief Compute y = A x for a symmetric sparse matrix in parallel.
+void symmetric_sparse_matrix_vector_product(
+    const Eigen::SparseMatrix<double>& A,
+    const Eigen::VectorXd& x,
+    Eigen::VectorXd& y);
+
+/**
+ * @brief Solve A x = b with the preconditioned conjugate gradient method.
+ *
+ * The solve stops when ‖b - A x‖ ≤ tolerance ‖b‖. If a search direction of
+ * non-positive curvature is found after the first iteration, the current
+ * iterate is returned (truncated Newton).
+ *
+ * @param[in,out] x  Initial guess and solution.
+ * @param[out] num_iterations Number of CG iterations taken.
+ * @return False if A has non-positive curvature along the first direction
+ *         or the iterates are not finite.
+ */
+bool preconditioned_conjugate_gradient(
+    const Eigen::SparseMatrix<double>& A,
+    const Eigen::VectorXd& b,
+    const BlockJacobiPreconditioner& preconditioner,
+    const double tolerance,
+    const int max_iterations,
+    Eigen::VectorXd& x,
+    int& num_iterations);
+
+} // namespace ipc::rigid
@@ -0,0 +1,238 @@
+#include "lbfgs_solver.hpp"
+
+#include <algorithm>
+
+#include <logger.hpp>
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+LBFGSSolver::LBFGSSolver()
+    : IPCSolver()
+    , history_size(8)
+    , hessian_refresh_interval(10)
+    , is_hessian_factorized(false)
+    , is_quasi_newton_direction(false)
+    , needs_hessian_refresh(true)
+    , iterations_since_refresh(0)
+    , constraint_set_hash(0)
+{
+}
+
+// Initialize the state of the solver using the settings saved in JSON
+void LBFGSSolver::settings(const nlohmann::json& json)
+{
+    IPCSolver::settings(json);
+    history_size = std::max(json["history_size"].get<int>(), 0);
+    hessian_refresh_interval =
+        std::max(json["hessian_refresh_interval"].get<int>(), 1);
+    num_hessian_refreshes = 0;
+    num_quasi_newton_steps = 0;
+}
+
+// Export the state of the solver using the settings saved in JSON
+nlohmann::json LBFGSSolver::settings() const
+{
+    nlohmann::json json = IPCSolver::settings();
+    json["history_size"] = history_size;
+    json["hessian_refresh_interval"] = hessian_refresh_interval;
+    return json;
+}
+
+// Solve the saved optimization problem to completion
+OptimizationResults LBFGSSolver::solve(const Eigen::VectorXd& x0)
+{
+    reset_history();
+    return IPCSolver::solve(x0);
+}
+
+void LBFGSSolver::reset_history()
+{
+    s_history.clear();
+    y_history.clear();
+    rho_history.clear();
+    needs_hessian_refresh = true;
+}
+
+bool LBFGSSolver::refresh_hessian(double& fx, double& regularization_coeff)
+{
+    bool success =
+        NewtonSolver::compute_search_direction(fx, regularization_coeff);
+    num_hessian_refreshes++;
+
+    reset_history();
+    needs_hessian_refresh = false;
+    iterations_since_refresh = 0;
+    // CG does not leave a factorization to reuse
+    is_hessian_factorized =
+        success && linear_solver_method == LinearSolverMethod::DIRECT;
+    is_quasi_newton_direction = false;
+    constraint_set_hash = barrier_problem_ptr()->active_constraint_set_hash(x);
+    prev_gradient_free = gradient_free;
+    return success;
+}
+
+bool LBFGSSolver::compute_search_direction(
+    double& fx, double& regularization_coeff)
+{
+    if (needs_hessian_refresh
+        || iterations_since_refresh >= hessian_refresh_interval) {
+        return refresh_hessian(fx, regularization_coeff);
+    }
+
+    fx = problem_ptr->compute_objective(x, gradient);
+    num_fx++;
+    num_grad_fx++;
+
+    // The Hessian's structure changes with the free DoF and the contacts
+    if (update_free_dof()
+        || barrier_problem_ptr()->active_constraint_set_hash(x)
+            != constraint_set_hash) {
+        spdlog::debug(
+            "solver={} iter={:d} msg=\"active set changed\"", name(),
+            iteration_number);
+        return refresh_hessian(fx, regularization_coeff);
+    }
+
+    slice_free_dof(gradient, free_dof, gradient_free);
+
+    // Curvature pair of the last step
+    Eigen::VectorXd s;
+    slice_free_dof(x - x_prev, free_dof, s);
+    Eigen::VectorXd y = gradient_free - prev_gradient_free;
+    prev_gradient_free = gradient_free;
+    const double y_dot_s = y.dot(s);
+    // Skip pairs without positive curvature to keep H positive definite
+    if (history_size > 0 && y_dot_s > 1e-10 * s.norm() * y.norm()) {
+        if (s_history.size() >= size_t(history_size)) {
+            s_history.pop_front();
+            y_history.pop_front();
+            rho_history.pop_front();
+        }
+        s_history.push_back(s);
+        y_history.push_back(y);
+        rho_history.push_back(1 / y_dot_s);
+    }
+    iterations_since_refresh++;
+
+    compute_quasi_newton_direction();
+    if (!direction_free.allFinite()
+        || gradient_free.dot(direction_free) >= 0) {
+        spdlog::warn(
+            "solver={} iter={:d} failure=\"quasi-newton direction not "
+            "descent direction\" failsafe=\"newton direction\"",
+            name(), iteration_number);
+        return refresh_hessian(fx, regularization_coeff);
+    }
+
+    is_quasi_newton_direction = true;
+    num_quasi_newton_steps++;
+    return true;
+}
+
+void LBFGSSolver::compute_quasi_newton_direction()
+{
+    PROFILE_POINT("LBFGSSolver::compute_quasi_newton_direction");
+    PROFILE_START();
+
+    // Two-loop recursion (Nocedal and Wright Algorithm 7.4)
+    Eigen::VectorXd q = gradient_free;
+    std::vector<double> alpha(s_history.size());
+    for (int i = int(s_history.size()) - 1; i >= 0; i--) {
+        alpha[i] = rho_history[i] * s_history[i].dot(q);
+        q -= alpha[i] * y_history[i];
+    }
+
+    // r = H₀ q
+    Eigen::VectorXd r;
+    if (is_hessian_factorized) {
+        r.setZero(q.size());
+        solve_factorized(q, r);
+    } else {
+        // Inverse of the inertia term M / h²
+        Eigen::VectorXd mass;
+        slice_free_dof(problem_ptr->mass_matrix().diagonal(), free_dof, mass);
+        const double h = problem_ptr->timestep();
+        r = (h * h) * q.cwiseQuotient(mass);
+    }
+
+    for (size_t i = 0; i < s_history.size(); i++) {
+        double beta = rho_history[i] * y_history[i].dot(r);
+        r += (alpha[i] - beta) * s_history[i];
+    }
+    direction_free = -r;
+
+    PROFILE_END();
+}
+
+bool LBFGSSolver::converged()
+{
+    bool is_converged = IPCSolver::converged();
+    if (is_quasi_newton_direction && is_energy_converged) {
+        // Only trust the convergence criteria with the exact Newton direction
+        spdlog::debug(
+            "solver={} iter={:d} msg=\"confirming convergence with the "
+            "exact hessian\"",
+            name(), iteration_number);
+        // Replace the quasi-Newton direction in place, so the line search
+        // never steps along a direction that has already converged.
+        num_quasi_newton_steps--;
+        double fx, regularization_coeff = 0;
+        if (!refresh_hessian(fx, regularization_coeff)) {
+            direction_free = -gradient_free;
+        }
+        slice_into_free_dof(gradient_free, free_dof, grad_direction);
+        slice_into_free_dof(direction_free, free_dof, direction);
+        return IPCSolver::converged();
+    }
+    return is_converged;
+}
+
+bool LBFGSSolver::line_search(
+    const Eigen::VectorXd& x,
+    const Eigen::VectorXd& dir,
+    const double fx,
+    const Eigen::VectorXd& grad_fx,
+    double& step_length)
+{
+    bool found_step =
+        IPCSolver::line_search(x, dir, fx, grad_fx, step_length);
+    if (!found_step && is_quasi_newton_direction) {
+        needs_hessian_refresh = true;
+    }
+    return found_step;
+}
+
+void LBFGSSolver::post_step_update()
+{
+    // Updates to κ or the augmented Lagrangian change the objective, so the
+    // curvature pairs no longer describe it.
+    bool updates_lagrangian = is_energy_converged
+        && !problem_ptr->are_equality_constraints_satisfied(x);
+    double kappa = barrier_problem_ptr()->barrier_stiffness();
+
+    IPCSolver::post_step_update();
+
+    if (updates_lagrangian
+        || kappa != barrier_problem_ptr()->barrier_stiffness()) {
+        reset_history();
+    }
+}
+
+std::string LBFGSSolver::stats_string() const
+{
+    return fmt::format(
+        "num_hessian_refreshes={:d} num_quasi_newton_steps={:d} {}",
+        num_hessian_refreshes, num_quasi_newton_steps,
+        IPCSolver::stats_string());
+}
+
+nlohmann::json LBFGSSolver::stats() const
+{
+    nlohmann::json stats_json = IPCSolver::stats();
+    stats_json["num_hessian_refreshes"] = num_hessian_refreshes;
+    stats_json["num_quasi_newton_steps"] = num_quasi_newton_steps;
+    return stats_json;
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <deque>
+
+#include <solvers/ipc_solver.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Limited-memory quasi-Newton (L-BFGS) variant of the IPC solver.
+ *
+ * The initial inverse Hessian of the two-loop recursion is the last
+ * factorized Hessian (or the inertia M/h² before any factorization), so most
+ * iterations only need a gradient. The exact Hessian is refreshed every
+ * hessian_refresh_interval iterations, when the free DoF, active contacts, or
+ * objective (κ or augmented Lagrangian) change, and to confirm convergence.
+ * The line search is the same CCD-filtered line search as Newton's.
+ */
+class LBFGSSolver : public IPCSolver {
+public:
+    LBFGSSolver();
+    virtual ~LBFGSSolver() = default;
+
+    /// Initialize the state of the solver using the settings saved in JSON
+    virtual void settings(const nlohmann::json& params) override;
+    /// Export the state of the solver using the settings saved in JSON
+    virtual nlohmann::json settings() const override;
+
+    /// An identifier for the solver class
+    static std::string solver_name() { return "lbfgs_solver"; }
+    /// An identifier for this solver
+    virtual std::string name() const override
+    {
+        return LBFGSSolver::solver_name();
+    }
+
+    /// Solve the saved optimization problem to completion
+    virtual OptimizationResults solve(const Eigen::VectorXd& x0) override;
+
+    virtual std::string stats_string() const override;
+    virtual nlohmann::json stats() const override;
+
+protected:
+    bool compute_search_direction(
+        double& fx, double& regularization_coeff) override;
+
+    bool converged() override;
+
+    bool line_search(
+        const Eigen::VectorXd& x,
+        const Eigen::VectorXd& dir,
+        const double fx,
+        const Eigen::VectorXd& grad_fx,
+        double& step_length) override;
+
+    void post_step_update() override;
+
+    /// @brief Evaluate the exact Hessian and use it for H₀.
+    bool refresh_hessian(double& fx, double& regularization_coeff);
+
+    /// @brief Compute the direction -H∇f with the two-loop recursion.
+    void compute_quasi_newton_direction();
+
+    /// @brief Drop the curvature pairs and require an exact Hessian.
+    void reset_history();
+
+    ///////////////////////////////////////////////////////////////////////
+    // User simulation parameters
+
+    /// @brief Number of curvature pairs (s, y) stored.
+    int history_size;
+    /// @brief Maximum number of iterations between exact Hessians.
+    int hessian_refresh_interval;
+
+    ///////////////////////////////////////////////////////////////////////
+    // Computed values
+
+    std::deque<Eigen::VectorXd> s_history; ///< Changes in the free DoF
+    std::deque<Eigen::VectorXd> y_history; ///< Changes in the gradient
+    std::deque<double> rho_history;        ///< 1 / (yᵀs)
+
+    Eigen::VectorXd prev_gradient_free; ///< Free gradient at x_prev
+    bool is_hessian_factorized;    ///< Does the linear solver hold H₀?
+    bool is_quasi_newton_direction; ///< Was the direction from L-BFGS?
+    bool needs_hessian_refresh;
+    int iterations_since_refresh;
+    size_t constraint_set_hash; ///< Active constraints at the last refresh
+
+private:
+    size_t num_hessian_refreshes = 0;
+    size_t num_quasi_newton_steps = 0;
+};
+
+} // namespace ipc::rigid
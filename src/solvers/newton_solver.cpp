@@ -1,8 +1,14 @@
 // Functions for optimizing functions.
 #include "newton_solver.hpp"
 
-#include <igl/slice.h>
-#include <igl/slice_into.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+
 #include <igl/writeOBJ.h>
 
 #include <constants.hpp>
@@ -18,10 +24,20 @@ NewtonSolver::NewtonSolver()
     , iteration_number(0)
     , convergence_criteria(ConvergenceCriteria::ENERGY)
     , m_line_search_lower_bound(Constants::DEFAULT_LINE_SEARCH_LOWER_BOUND)
+    , speculative_line_search_steps(1)
     , energy_conv_tol(Constants::DEFAULT_NEWTON_ENERGY_CONVERGENCE_TOL)
     , velocity_conv_tol(Constants::DEFAULT_NEWTON_VELOCITY_CONVERGENCE_TOL)
     , is_velocity_conv_tol_abs(false)
     , is_energy_converged(false)
+    , free_dof_version(0)
+    , linear_solver_method(LinearSolverMethod::DIRECT)
+    , linear_solver_ordering(LinearSolverOrdering::DEFAULT_ORDERING)
+    , is_free_dof_ordering_valid(false)
+    , is_factorization_ordered(false)
+    , separate_decoupled_blocks(false)
+    , cg_max_iterations(1000)
+    , cg_forcing_term(0.5)
+    , cg_prev_gradient_norm(-1)
 {
     linear_solver = polysolve::LinearSolver::create("", "");
 }
@@ -34,6 +50,13 @@ void NewtonSolver::settings(const nlohmann::json& json)
     velocity_conv_tol = json["velocity_conv_tol"];
     is_velocity_conv_tol_abs = json["is_velocity_conv_tol_abs"];
     m_line_search_lower_bound = json["line_search_lower_bound"];
+    speculative_line_search_steps =
+        std::max(json["speculative_line_search_steps"].get<int>(), 1);
+
+    linear_solver_method = json["linear_solver_method"];
+    linear_solver_ordering = json["linear_solver_ordering"];
+    separate_decoupled_blocks = json["separate_decoupled_blocks"];
+    cg_max_iterations = json["cg_max_iterations"];
 
     linear_solver_settings = json["linear_solver"];
     try {
@@ -56,9 +79,14 @@ nlohmann::json NewtonSolver::settings() const
     settings["max_iterations"] = max_iterations;
     settings["convergence_criteria"] = convergence_criteria;
     settings["linear_solver"] = linear_solver_settings;
+    settings["linear_solver_method"] = linear_solver_method;
+    settings["linear_solver_ordering"] = linear_solver_ordering;
+    settings["separate_decoupled_blocks"] = separate_decoupled_blocks;
+    settings["cg_max_iterations"] = cg_max_iterations;
     settings["energy_conv_tol"] = energy_conv_tol;
     settings["velocity_conv_tol"] = velocity_conv_tol;
     settings["is_velocity_conv_tol_abs"] = is_velocity_conv_tol_abs;
+    settings["speculative_line_search_steps"] = speculative_line_search_steps;
     return settings;
 }
 
@@ -170,6 +198,88 @@ bool NewtonSolver::converged()
         && problem_ptr->are_equality_constraints_satisfied(x);
 }
 
+bool NewtonSolver::update_free_dof()
+{
+    if (dof_to_free_dof.size() == problem_ptr->num_vars()
+        && free_dof_version == problem_ptr->free_dof_version()) {
+        return false;
+    }
+
+    free_dof = problem_ptr->free_dof();
+    free_dof_version = problem_ptr->free_dof_version();
+    is_free_dof_ordering_valid = false;
+    dof_to_free_dof.setConstant(problem_ptr->num_vars(), -1);
+    free_dof_block_starts.clear();
+    const int block_size = problem_ptr->dof_block_size();
+    for (int i = 0; i < free_dof.size(); i++) {
+        dof_to_free_dof[free_dof[i]] = i;
+        if (i == 0
+            || free_dof[i] / block_size != free_dof[i - 1] / block_size) {
+            free_dof_block_starts.push_back(i);
+        }
+    }
+    return true;
+}
+
+// Extract the free DoF of a vector.
+void slice_free_dof(
+    const Eigen::VectorXd& x,
+    const Eigen::VectorXi& free_dof,
+    Eigen::VectorXd& x_free)
+{
+    x_free.resize(free_dof.size());
+    for (int i = 0; i < free_dof.size(); i++) {
+        x_free[i] = x[free_dof[i]];
+    }
+}
+
+// Extract the rows and columns of the free DoF of a matrix. Only the columns
+// of free DoF are visited, so the entries of fixed DoF (e.g., static bodies)
+// are never copied.
+static void slice_free_dof(
+    const Eigen::SparseMatrix<double>& A,
+    const Eigen::VectorXi& free_dof,
+    const Eigen::VectorXi& dof_to_free_dof,
+    Eigen::SparseMatrix<double>& A_free)
+{
+    NAMED_PROFILE_POINT("NewtonSolver::slice_free_dof", SLICE_FREE_DOF);
+    PROFILE_START(SLICE_FREE_DOF);
+
+    A_free.resize(free_dof.size(), free_dof.size());
+    Eigen::VectorXi col_nnz(free_dof.size());
+    for (int j = 0; j < free_dof.size(); j++) {
+        col_nnz[j] = A.col(free_dof[j]).nonZeros();
+    }
+    A_free.reserve(col_nnz);
+
+    for (int j = 0; j < free_dof.size(); j++) {
+        // The map is increasing, so the rows are inserted in order.
+        for (Eigen::SparseMatrix<double>::InnerIterator it(A, free_dof[j]); it;
+             ++it) {
+            int i = dof_to_free_dof[it.row()];
+            if (i >= 0) {
+                A_free.insert(i, j) = it.value();
+            }
+        }
+    }
+    A_free.makeCompressed();
+
+    PROFILE_END(SLICE_FREE_DOF);
+}
+
+// Scatter the free DoF into a full vector with zeros for the other DoF.
+void slice_into_free_dof(
+    const Eigen::VectorXd& x_free,
+    const Eigen::VectorXi& free_dof,
+    Eigen::VectorXd& x)
+{
+    assert(x_free.size() == free_dof.size());
+    x.setZero();
+    for (int i = 0; i < free_dof.size(); i++) {
+        x[free_dof[i]] = x_free[i];
+    }
+}
+
 OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
 {
     assert(problem_ptr != nullptr);
@@ -191,39 +301,26 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
     direction.setZero(problem_ptr->num_vars());
     grad_direction.setZero(problem_ptr->num_vars());
 
+    // Reset the forcing term of Newton-CG
+    cg_forcing_term = 0.5;
+    cg_prev_gradient_norm = -1;
+
     is_energy_converged = false;
     bool success = false;
 
     for (iteration_number = 0; iteration_number < max_iterations;
          iteration_number++) {
-        double fx = problem_ptr->compute_objective(x, gradient, hessian);
-
-        num_fx++;
-        num_grad_fx++;
-        num_hessian_fx++;
-
-        // Remove rows and cols of fixed DoF
-        Eigen::VectorXi free_dof = problem_ptr->free_dof();
-        igl::slice(gradient, free_dof, gradient_free);
-        igl::slice(hessian, free_dof, free_dof, hessian_free);
-
-#ifdef USE_GRADIENT_DESCENT
-        direction_free = -gradient_free;
-#else
-        bool solve_success = compute_regularized_direction(
-            fx, gradient_free, hessian_free, direction_free,
-            regulariztion_coeff);
-        if (!solve_success) {
+        double fx;
+        if (!compute_search_direction(fx, regulariztion_coeff)) {
             exit_reason = "regularization failed";
             break;
         }
-#endif
 
         ///////////////////////////////////////////////////////////////////
         // Line search over newton direction
         // get grad direction for lineseach
-        igl::slice_into(gradient_free, free_dof, grad_direction);
-        igl::slice_into(direction_free, free_dof, direction);
+        slice_into_free_dof(gradient_free, free_dof, grad_direction);
+        slice_into_free_dof(direction_free, free_dof, direction);
 
         // check for newton termination
         if (iteration_number > 0 && converged()) {
@@ -311,6 +408,29 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
         x, problem_ptr->compute_objective(x), success, true, iteration_number);
 }
 
+bool NewtonSolver::compute_search_direction(
+    double& fx, double& regularization_coeff)
+{
+    fx = problem_ptr->compute_objective(x, gradient, hessian);
+
+    num_fx++;
+    num_grad_fx++;
+    num_hessian_fx++;
+
+    // Remove rows and cols of fixed DoF
+    update_free_dof();
+    slice_free_dof(gradient, free_dof, gradient_free);
+    slice_free_dof(hessian, free_dof, dof_to_free_dof, hessian_free);
+
+#ifdef USE_GRADIENT_DESCENT
+    direction_free = -gradient_free;
+    return true;
+#else
+    return compute_regularized_direction(
+        fx, gradient_free, hessian_free, direction_free, regularization_coeff);
+#endif
+}
+
 bool NewtonSolver::line_search(
     const Eigen::VectorXd& x,
     const Eigen::VectorXd& dir,
@@ -357,7 +477,47 @@ bool NewtonSolver::line_search(
     }
 
     double fxi = std::numeric_limits<double>::infinity();
-    while (std::isfinite(lower_bound) && step_length >= lower_bound) {
+
+    // Without CCD the collision check of every step length modifies the
+    // problem, so only the filtered line search is evaluated concurrently.
+    bool is_speculative = speculative_line_search_steps > 1
+        && is_ccd_aligned_with_newton_update
+        && problem_ptr->is_objective_thread_safe();
+    while (is_speculative && std::isfinite(lower_bound)
+           && step_length >= lower_bound) {
+        // Try α, α/2, …, α/2ᵏ⁻¹ at once
+        std::vector<double> step_lengths;
+        for (double alpha = step_length;
+             int(step_lengths.size()) < speculative_line_search_steps
+             && alpha >= lower_bound;
+             alpha /= 2.0) {
+            step_lengths.push_back(alpha);
+        }
+
+        std::vector<double> fxs;
+        size_t i = speculative_line_search(x, dir, fx, step_lengths, fxs);
+        for (const double& fx_j : fxs) {
+            if (!std::isnan(fx_j)) {
+                num_it++;        // Count the number of iterations
+                ls_iterations++; // Count the gloabal number of iterations
+                num_fx++;        // Count the number of objective computations
+            }
+        }
+
+        if (i < step_lengths.size()) {
+            step_length = step_lengths[i];
+            fxi = fxs[i];
+            success = true;
+            break; // while loop
+        }
+
+        // Try again with a smaller step_length
+        fxi = fxs.back();
+        step_length = step_lengths.back() / 2.0;
+    }
+
+    while (!is_speculative && std::isfinite(lower_bound)
+           && step_length >= lower_bound) {
         num_it++;        // Count the number of iterations
         ls_iterations++; // Count the gloabal number of iterations
 
@@ -402,11 +562,9 @@ bool NewtonSolver::line_search(
                 x, dir,
                 [&](const Eigen::VectorXd& x, Eigen::VectorXd& grad) {
                     double fx = problem_ptr->compute_objective(x, grad);
-                    Eigen::VectorXi free_dof = problem_ptr->free_dof();
                     Eigen::VectorXd grad_free;
-                    igl::slice(grad, free_dof, grad_free);
-                    grad.setZero();
-                    igl::slice_into(grad_free, free_dof, grad);
+                    slice_free_dof(grad, free_dof, grad_free);
+                    slice_into_free_dof(grad_free, free_dof, grad);
                     return fx;
                 },
                 max_step_size);
@@ -424,6 +582,51 @@ bool NewtonSolver::line_search(
     return success;
 }
 
+size_t NewtonSolver::speculative_line_search(
+    const Eigen::VectorXd& x,
+    const Eigen::VectorXd& dir,
+    const double fx,
+    const std::vector<double>& step_lengths,
+    std::vector<double>& fxs)
+{
+    // NaN marks the step lengths that were skipped
+    fxs.assign(step_lengths.size(), std::numeric_limits<double>::quiet_NaN());
+
+    // Index of the largest step length found to decrease the objective
+    std::atomic<size_t> best_i(step_lengths.size());
+    std::mutex best_i_mutex;
+
+    tbb::task_group_context context;
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), step_lengths.size(), 1),
+        [&](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                // A larger step length already succeeded
+                if (i > best_i) {
+                    continue;
+                }
+
+                fxs[i] =
+                    problem_ptr->compute_objective(x + step_lengths[i] * dir);
+
+                if (fxs[i] < fx) {
+                    std::scoped_lock lock(best_i_mutex);
+                    if (i < best_i) {
+                        best_i = i;
+                    }
+                    if (i == 0) {
+                        // No other step length can be taken
+                        context.cancel_group_execution();
+                    }
+                }
+            }
+        },
+        context);
+
+    // Every step length larger than best_i was evaluated
+    return best_i;
+}
+
 double norm_Linf(const Eigen::SparseMatrix<double>& M)
 {
     double norm = 0;
@@ -517,18 +720,21 @@ bool NewtonSolver::compute_direction(
     //     direction = dense_hessian.ldlt().solve(-gradient);
     //     solve_success = true;
     // } else {
-    linear_solver->analyzePattern(hessian, hessian.rows());
-    linear_solver->factorize(hessian);
-    nlohmann::json info;
-    linear_solver->getInfo(info);
-    // TODO: This check only works for direct Eigen solvers
-    if (!info.contains("solver_info") || info["solver_info"] == "Success") {
+    if (linear_solver_method == LinearSolverMethod::PRECONDITIONED_CG) {
+        solve_success = compute_cg_direction(gradient, hessian, direction);
+        PROFILE_END();
+        if (!solve_success) {
+            direction = -gradient;
+        }
+        // NOTE: A descent direction is checked by the regularization
+        return solve_success;
+    }
+
+    if (factorize_hessian(hessian)) {
         // TODO: Do we have a better initial guess for iterative
         // solvers?
         direction = Eigen::VectorXd::Zero(gradient.size());
-        linear_solver->solve(-gradient, direction);
-        linear_solver->getInfo(info);
-        if (!info.contains("solver_info") || info["solver_info"] == "Success") {
+        if (solve_factorized(-gradient, direction)) {
             solve_success = true;
         } else {
             spdlog::warn(
@@ -591,6 +797,249 @@ bool NewtonSolver::compute_direction(
     return solve_success;
 }
 
+bool NewtonSolver::factorize_hessian(
+    const Eigen::SparseMatrix<double>& hessian)
+{
+    // Only the Hessian of the free DoF has the block structure
+    const bool is_free_hessian = hessian.rows() == free_dof.size();
+    if (separate_decoupled_blocks && is_free_hessian) {
+        update_decoupled_blocks(hessian);
+    } else {
+        decoupled_blocks.clear();
+    }
+    is_factorization_ordered =
+        linear_solver_ordering == LinearSolverOrdering::CONTACT_GRAPH_ORDERING
+        && is_free_hessian && update_free_dof_ordering();
+
+    if (decoupled_blocks.empty()) {
+        return factorize_coupled_hessian(hessian);
+    }
+
+    // The Hessian of a decoupled block is its (dense) diagonal block, so each
+    // block is factorized on its own.
+    decoupled_block_ldlts.resize(decoupled_blocks.size());
+    std::atomic<bool> are_blocks_factorized = true;
+    tbb::parallel_for(size_t(0), decoupled_blocks.size(), [&](size_t i) {
+        const int bi = decoupled_blocks[i];
+        const int start = free_dof_block_starts[bi];
+        const int size = (bi + 1 < free_dof_block_starts.size()
+                              ? free_dof_block_starts[bi + 1]
+                              : int(free_dof.size()))
+            - start;
+        decoupled_block_ldlts[i].compute(
+            Eigen::MatrixXd(hessian.block(start, start, size, size)));
+        if (decoupled_block_ldlts[i].info() != Eigen::Success) {
+            are_blocks_factorized = false;
+        }
+    });
+
+    if (coupled_dof.size() == 0) {
+        return are_blocks_factorized;
+    }
+    slice_free_dof(
+        hessian, coupled_dof, free_dof_to_coupled_dof, hessian_coupled);
+    return are_blocks_factorized && factorize_coupled_hessian(hessian_coupled);
+}
+
+bool NewtonSolver::solve_factorized(
+    const Eigen::VectorXd& b, Eigen::VectorXd& x)
+{
+    if (decoupled_blocks.empty()) {
+        return solve_coupled(b, x);
+    }
+
+    x.resize(b.size());
+    tbb::parallel_for(size_t(0), decoupled_blocks.size(), [&](size_t i) {
+        const int start = free_dof_block_starts[decoupled_blocks[i]];
+        const int size = decoupled_block_ldlts[i].rows();
+        x.segment(start, size) =
+            decoupled_block_ldlts[i].solve(b.segment(start, size));
+    });
+
+    bool success = true;
+    if (coupled_dof.size() != 0) {
+        Eigen::VectorXd b_coupled, x_coupled;
+        slice_free_dof(b, coupled_dof, b_coupled);
+        x_coupled.setZero(b_coupled.size());
+        success = solve_coupled(b_coupled, x_coupled);
+        for (int i = 0; i < coupled_dof.size(); i++) {
+            x[coupled_dof[i]] = x_coupled[i];
+        }
+    }
+    return success && x.allFinite();
+}
+
+bool NewtonSolver::factorize_coupled_hessian(
+    const Eigen::SparseMatrix<double>& hessian)
+{
+    if (is_factorization_ordered) {
+        if (decoupled_blocks.empty()) {
+            ordered_ldlt_solver.set_ordering(free_dof_order);
+        } else {
+            // Restrict the ordering to the coupled DoF
+            std::vector<int> coupled_order;
+            coupled_order.reserve(coupled_dof.size());
+            for (int i : free_dof_order) {
+                if (free_dof_to_coupled_dof[i] >= 0) {
+                    coupled_order.push_back(free_dof_to_coupled_dof[i]);
+                }
+            }
+            ordered_ldlt_solver.set_ordering(coupled_order);
+        }
+        return ordered_ldlt_solver.factorize(hessian);
+    }
+
+    linear_solver->analyzePattern(hessian, hessian.rows());
+    linear_solver->factorize(hessian);
+    nlohmann::json info;
+    linear_solver->getInfo(info);
+    // TODO: This check only works for direct Eigen solvers
+    return !info.contains("solver_info") || info["solver_info"] == "Success";
+}
+
+bool NewtonSolver::solve_coupled(const Eigen::VectorXd& b, Eigen::VectorXd& x)
+{
+    if (is_factorization_ordered) {
+        ordered_ldlt_solver.solve(b, x);
+        return x.allFinite();
+    }
+
+    linear_solver->solve(b, x);
+    nlohmann::json info;
+    linear_solver->getInfo(info);
+    return !info.contains("solver_info") || info["solver_info"] == "Success";
+}
+
+void NewtonSolver::update_decoupled_blocks(
+    const Eigen::SparseMatrix<double>& hessian)
+{
+    const int num_blocks = free_dof_block_starts.size();
+    const auto block_end = [&](int bi) {
+        return bi + 1 < num_blocks ? free_dof_block_starts[bi + 1]
+                                   : int(free_dof.size());
+    };
+
+    // A block is decoupled if its columns have no entries outside the block
+    // (the Hessian is symmetric, so neither do its rows).
+    std::vector<uint8_t> is_decoupled(num_blocks, true);
+    tbb::parallel_for(0, num_blocks, [&](int bi) {
+        const int start = free_dof_block_starts[bi], end = block_end(bi);
+        for (int j = start; j < end && is_decoupled[bi]; j++) {
+            for (Eigen::SparseMatrix<double>::InnerIterator it(hessian, j); it;
+                 ++it) {
+                if (it.row() < start || it.row() >= end) {
+                    is_decoupled[bi] = false;
+                    break;
+                }
+            }
+        }
+    });
+
+    decoupled_blocks.clear();
+    free_dof_to_coupled_dof.setConstant(free_dof.size(), -1);
+    std::vector<int> coupled;
+    for (int bi = 0; bi < num_blocks; bi++) {
+        if (is_decoupled[bi]) {
+            decoupled_blocks.push_back(bi);
+            continue;
+        }
+        for (int i = free_dof_block_starts[bi]; i < block_end(bi); i++) {
+            free_dof_to_coupled_dof[i] = coupled.size();
+            coupled.push_back(i);
+        }
+    }
+    coupled_dof = Eigen::Map<Eigen::VectorXi>(coupled.data(), coupled.size());
+}
+
+bool NewtonSolver::update_free_dof_ordering()
+{
+    std::vector<int> block_order;
+    if (!problem_ptr->dof_block_ordering(x, block_order)) {
+        return false;
+    }
+    if (is_free_dof_ordering_valid && block_order == dof_block_order) {
+        return true;
+    }
+    dof_block_order = block_order;
+
+    // Expand the block ordering to the free DoF (blocks are contiguous)
+    const int block_size = problem_ptr->dof_block_size();
+    std::vector<int> free_block_of_block(
+        problem_ptr->num_vars() / block_size, -1);
+    for (int bi = 0; bi < free_dof_block_starts.size(); bi++) {
+        free_block_of_block[free_dof[free_dof_block_starts[bi]] / block_size] =
+            bi;
+    }
+
+    free_dof_order.clear();
+    free_dof_order.reserve(free_dof.size());
+    for (int block : dof_block_order) {
+        int bi = free_block_of_block[block];
+        if (bi < 0) {
+            continue; // Every DoF of the block is fixed
+        }
+        int end = bi + 1 < free_dof_block_starts.size()
+            ? free_dof_block_starts[bi + 1]
+            : int(free_dof.size());
+        for (int i = free_dof_block_starts[bi]; i < end; i++) {
+            free_dof_order.push_back(i);
+        }
+    }
+    assert(free_dof_order.size() == free_dof.size());
+
+    is_free_dof_ordering_valid = true;
+    return true;
+}
+
+bool NewtonSolver::compute_cg_direction(
+    const Eigen::VectorXd& gradient,
+    const Eigen::SparseMatrix<double>& hessian,
+    Eigen::VectorXd& direction)
+{
+    // Eisenstat–Walker forcing term (choice 2 with γ = 0.9 and α = 2)
+    const double gamma = 0.9, eta_max = 0.5, eta_min = 1e-8;
+    const double gradient_norm = gradient.norm();
+    if (cg_prev_gradient_norm > 0) {
+        double ratio = gradient_norm / cg_prev_gradient_norm;
+        double eta = gamma * ratio * ratio;
+        // Safeguard against decreasing the forcing term too quickly
+        double eta_safe = gamma * cg_forcing_term * cg_forcing_term;
+        if (eta_safe > 0.1) {
+            eta = std::max(eta, eta_safe);
+        }
+        cg_forcing_term = std::clamp(eta, eta_min, eta_max);
+    }
+    cg_prev_gradient_norm = gradient_norm;
+
+    // The free DoF of the current solve define the diagonal blocks
+    if (free_dof.size() == hessian.rows()) {
+        cg_preconditioner.compute(hessian, free_dof_block_starts);
+    } else {
+        // Unknown blocks, so use a Jacobi preconditioner
+        std::vector<int> block_starts(hessian.rows());
+        std::iota(block_starts.begin(), block_starts.end(), 0);
+        cg_preconditioner.compute(hessian, block_starts);
+    }
+
+    direction = Eigen::VectorXd::Zero(gradient.size());
+    int num_cg_iterations;
+    bool success = preconditioned_conjugate_gradient(
+        hessian, -gradient, cg_preconditioner, cg_forcing_term,
+        cg_max_iterations, direction, num_cg_iterations);
+
+    spdlog::debug(
+        "solver={} iter={:d} cg_iterations={:d} forcing_term={:g}", name(),
+        iteration_number, num_cg_iterations, cg_forcing_term);
+
+    if (!success) {
+        spdlog::warn(
+            "solver={} iter={:d} failure=\"CG solve for newton direction "
+            "(non-positive curvature)\" failsafe=\"gradient descent\"",
+            name(), iteration_number);
+    }
+    return success;
+}
+
 // Make the matrix positive definite (x^T A x > 0).
 double make_matrix_positive_definite(Eigen::SparseMatrix<double>& A)
 {
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <Eigen/Cholesky>
 #include <Eigen/Core>
 #include <polysolve/LinearSolver.hpp>
 
 #include <constants.hpp>
+#include <solvers/conjugate_gradient.hpp>
 #include <solvers/optimization_solver.hpp>
+#include <solvers/ordered_ldlt.hpp>
 #include <utils/not_implemented_error.hpp>
 
 namespace ipc::rigid {
@@ -17,6 +20,25 @@ enum ConvergenceCriteria {
 NLOHMANN_JSON_SERIALIZE_ENUM(
     ConvergenceCriteria, { { VELOCITY, "velocity" }, { ENERGY, "energy" } });
 
+enum LinearSolverMethod {
+    DIRECT,           ///< Factorize the Hessian with the linear solver
+    PRECONDITIONED_CG ///< Inexact block-Jacobi preconditioned CG (Newton-CG)
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(
+    LinearSolverMethod,
+    { { DIRECT, "direct" }, { PRECONDITIONED_CG, "preconditioned_cg" } });
+
+enum LinearSolverOrdering {
+    DEFAULT_ORDERING,      ///< Ordering of the linear solver
+    CONTACT_GRAPH_ORDERING ///< Problem's DoF block ordering (LDLᵀ)
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(
+    LinearSolverOrdering,
+    { { DEFAULT_ORDERING, "default" },
+      { CONTACT_GRAPH_ORDERING, "contact_graph" } });
+
 class NewtonSolver : public virtual OptimizationSolver {
 public:
     NewtonSolver();
@@ -39,6 +61,7 @@ public:
     virtual void set_problem(OptimizationProblem& problem) override
     {
         this->problem_ptr = &problem;
+        dof_to_free_dof.resize(0); // Rebuild the free DoF maps
     }
 
     /// Initialize the solver state for a new solve
@@ -98,6 +121,12 @@ protected:
 
     virtual void post_step_update();
 
+    /// @brief Evaluate the objective at x and solve for the search direction
+    /// of the free DoF (direction_free).
+    /// @return False if no descent direction could be computed.
+    virtual bool
+    compute_search_direction(double& fx, double& regularization_coeff);
+
     virtual bool line_search(
         const Eigen::VectorXd& x,
         const Eigen::VectorXd& dir,
@@ -105,11 +134,51 @@ protected:
         const Eigen::VectorXd& grad_fx,
         double& step_length);
 
+    /// @brief Evaluate the step lengths concurrently.
+    /// @return The index of the largest step length that decreases the
+    ///         objective or step_lengths.size() if none does.
+    size_t speculative_line_search(
+        const Eigen::VectorXd& x,
+        const Eigen::VectorXd& dir,
+        const double fx,
+        const std::vector<double>& step_lengths,
+        std::vector<double>& fxs);
+
     virtual double line_search_lower_bound() const
     {
         return m_line_search_lower_bound;
     }
 
+    /// @brief Rebuild the free DoF maps if the problem's free DoF changed.
+    /// @return True if the free DoF changed.
+    bool update_free_dof();
+
+    /// @brief Factorize the Hessian of the free DoF for solve_factorized().
+    ///
+    /// Blocks of free DoF without entries outside their diagonal block (e.g.,
+    /// bodies without contacts) are factorized separately as dense blocks,
+    /// and only the remaining coupled DoF go to the sparse solver.
+    bool factorize_hessian(const Eigen::SparseMatrix<double>& hessian);
+    /// @brief Solve H x = b with the last factorized Hessian.
+    bool solve_factorized(const Eigen::VectorXd& b, Eigen::VectorXd& x);
+    /// @brief Factorize the Hessian of the coupled DoF with the sparse solver.
+    bool factorize_coupled_hessian(const Eigen::SparseMatrix<double>& hessian);
+    /// @brief Solve the coupled system with the last sparse factorization.
+    bool solve_coupled(const Eigen::VectorXd& b, Eigen::VectorXd& x);
+    /// @brief Find the free DoF blocks that do not couple with other blocks.
+    void update_decoupled_blocks(const Eigen::SparseMatrix<double>& hessian);
+    /// @brief Update the ordering of the free DoF from the problem's block
+    /// ordering at x.
+    /// @return False if the problem does not provide an ordering.
+    bool update_free_dof_ordering();
+
+    /// @brief Solve for the Newton direction with preconditioned CG up to the
+    /// Eisenstat–Walker forcing term.
+    bool compute_cg_direction(
+        const Eigen::VectorXd& gradient,
+        const Eigen::SparseMatrix<double>& hessian,
+        Eigen::VectorXd& delta_x);
+
     /// @brief Pointer to the problem to solve.
     OptimizationProblem* problem_ptr;
 
@@ -117,6 +186,8 @@ protected:
     ConvergenceCriteria convergence_criteria;
 
     double m_line_search_lower_bound; ///< @brief Line search lower bound
+    /// @brief Number of step lengths the line search evaluates concurrently
+    int speculative_line_search_steps;
 
     double energy_conv_tol;        ///< @brief Energy convergence tolerance
     double velocity_conv_tol;      ///< @brief Velocity convergence tolerance
@@ -130,12 +201,41 @@ protected:
     Eigen::VectorXd grad_direction; ///< Gradient with fixed DoF set to zero
     Eigen::SparseMatrix<double> hessian, hessian_free;
 
+    /// @brief Free DoF and the index of each DoF in them (-1 if not free)
+    Eigen::VectorXi free_dof, dof_to_free_dof;
+    /// @brief Version of the problem's free DoF in free_dof
+    size_t free_dof_version;
+    /// @brief Start of each block of coupled free DoF (e.g., a body's DoF)
+    std::vector<int> free_dof_block_starts;
+
     // Linear solver pointer
+    LinearSolverMethod linear_solver_method;
     std::unique_ptr<polysolve::LinearSolver> linear_solver;
     nlohmann::json linear_solver_settings;
 
-private:
-    void reset_stats();
+    // Problem supplied ordering
+    LinearSolverOrdering linear_solver_ordering;
+    OrderedLDLTSolver ordered_ldlt_solver;
+    std::vector<int> dof_block_order; ///< Last block ordering of the problem
+    std::vector<int> free_dof_order;  ///< Block ordering of the free DoF
+    bool is_free_dof_ordering_valid;  ///< Is the LDLᵀ ordering up to date?
+    bool is_factorization_ordered;    ///< Was the last factorization LDLᵀ?
+
+    // Decoupled blocks
+    /// @brief Solve blocks without off-diagonal entries separately.
+    bool separate_decoupled_blocks;
+    /// @brief Free DoF blocks (in free_dof_block_starts) that are decoupled
+    std::vector<int> decoupled_blocks;
+    std::vector<Eigen::LDLT<Eigen::MatrixXd>> decoupled_block_ldlts;
+    /// @brief Free DoF in the coupled system and their index in it (or -1)
+    Eigen::VectorXi coupled_dof, free_dof_to_coupled_dof;
+    Eigen::SparseMatrix<double> hessian_coupled;
+
+    // Newton-CG
+    int cg_max_iterations;        ///< @brief Maximum CG iterations per solve
+    double cg_forcing_term;       ///< @brief Previous forcing term (η)
+    double cg_prev_gradient_norm; ///< @brief ‖∇f‖ of the previous solve
+    BlockJacobiPreconditioner cg_preconditioner;
 
     size_t num_fx = 0;
     size_t num_grad_fx = 0;
@@ -146,8 +246,23 @@ private:
     size_t num_newton_ls_fails = 0;
     size_t num_grad_ls_fails = 0;
     size_t regularization_iterations = 0;
+
+private:
+    void reset_stats();
 };
 
+/// @brief Extract the free DoF of a vector.
+void slice_free_dof(
+    const Eigen::VectorXd& x,
+    const Eigen::VectorXi& free_dof,
+    Eigen::VectorXd& x_free);
+
+/// @brief Scatter the free DoF into a full vector (zero for the other DoF).
+void slice_into_free_dof(
+    const Eigen::VectorXd& x_free,
+    const Eigen::VectorXi& free_dof,
+    Eigen::VectorXd& x);
+
 /**
  * @brief Make the matrix positive definite (\f$x^T A x > 0\$).
  *
@@ -0,0 +1,231 @@
+#include "ordered_ldlt.hpp"
+
+#include <algorithm>
+
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+namespace {
+    /// Recursive nested dissection over the nodes with a common label.
+    class NestedDissection {
+    public:
+        NestedDissection(
+            int num_nodes,
+            const std::vector<std::pair<int, int>>& edges,
+            int leaf_size)
+            : leaf_size(std::max(leaf_size, 1))
+            , labels(num_nodes, 0)
+            , levels(num_nodes, -1)
+        {
+            // Build the adjacency in compressed form
+            std::vector<int> degrees(num_nodes, 0);
+            for (const auto& [i, j] : edges) {
+                if (i != j) {
+                    degrees[i]++;
+                    degrees[j]++;
+                }
+            }
+            adjacency_starts.resize(num_nodes + 1, 0);
+            for (int i = 0; i < num_nodes; i++) {
+                adjacency_starts[i + 1] = adjacency_starts[i] + degrees[i];
+            }
+            adjacency.resize(adjacency_starts.back());
+            std::vector<int> next(
+                adjacency_starts.begin(), adjacency_starts.end() - 1);
+            for (const auto& [i, j] : edges) {
+                if (i != j) {
+                    adjacency[next[i]++] = j;
+                    adjacency[next[j]++] = i;
+                }
+            }
+            order.reserve(num_nodes);
+        }
+
+        void dissect(std::vector<int>& nodes)
+        {
+            if (nodes.size() <= size_t(leaf_size)) {
+                order.insert(order.end(), nodes.begin(), nodes.end());
+                return;
+            }
+
+            const int label = relabel(nodes);
+
+            // Order every connected component independently
+            std::vector<int> component = breadth_first_search(nodes[0], label);
+            if (component.size() < nodes.size()) {
+                std::vector<std::vector<int>> components;
+                for (int node : nodes) {
+                    if (levels[node] < 0) {
+                        components.push_back(
+                            breadth_first_search(node, label, /*clear=*/false));
+                    }
+                }
+                dissect(component);
+                for (std::vector<int>& other : components) {
+                    dissect(other);
+                }
+                return;
+            }
+
+            // Root the level structure at a pseudo-peripheral node
+            int root = component.back();
+            component = breadth_first_search(root, label);
+            const int num_levels = levels[component.back()] + 1;
+            if (num_levels < 3) {
+                // Too dense to separate
+                order.insert(order.end(), nodes.begin(), nodes.end());
+                return;
+            }
+
+            // The middle level separates the levels above from the ones below
+            const int middle = num_levels / 2;
+            std::vector<int> part0, part1, separator;
+            for (int node : component) {
+                if (levels[node] < middle) {
+                    part0.push_back(node);
+                } else if (levels[node] > middle) {
+                    part1.push_back(node);
+                } else if (!has_neighbor_at_level(node, label, middle + 1)) {
+                    part0.push_back(node); // Not needed in the separator
+                } else {
+                    separator.push_back(node);
+                }
+            }
+
+            dissect(part0);
+            dissect(part1);
+            order.insert(order.end(), separator.begin(), separator.end());
+        }
+
+        std::vector<int> order;
+
+    private:
+        int relabel(const std::vector<int>& nodes)
+        {
+            const int label = ++num_labels;
+            for (int node : nodes) {
+                labels[node] = label;
+            }
+            return label;
+        }
+
+        /// Visit the nodes with the given label reachable from root and set
+        /// their levels. Returns the nodes in order of increasing level.
+        std::vector<int>
+        breadth_first_search(int root, int label, bool clear = true)
+        {
+            if (clear) {
+                for (int node : last_search) {
+                    levels[node] = -1;
+                }
+            }
+
+            std::vector<int> visited = { { root } };
+            levels[root] = 0;
+            for (size_t i = 0; i < visited.size(); i++) {
+                const int node = visited[i];
+                for (int k = adjacency_starts[node];
+                     k < adjacency_starts[node + 1]; k++) {
+                    const int neighbor = adjacency[k];
+                    if (labels[neighbor] == label && levels[neighbor] < 0) {
+                        levels[neighbor] = levels[node] + 1;
+                        visited.push_back(neighbor);
+                    }
+                }
+            }
+
+            if (clear) {
+                last_search = visited;
+            } else {
+                last_search.insert(
+                    last_search.end(), visited.begin(), visited.end());
+            }
+            return visited;
+        }
+
+        bool has_neighbor_at_level(int node, int label, int level) const
+        {
+            for (int k = adjacency_starts[node]; k < adjacency_starts[node + 1];
+                 k++) {
+                const int neighbor = adjacency[k];
+                if (labels[neighbor] == label && levels[neighbor] == level) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        const int leaf_size;
+        std::vector<int> adjacency_starts, adjacency;
+        std::vector<int> labels; ///< Nodes being dissected share a label
+        std::vector<int> levels; ///< Level in the last breadth-first search
+        std::vector<int> last_search; ///< Nodes with a level set
+        int num_labels = 0;
+    };
+} // namespace
+
+std::vector<int> nested_dissection_ordering(
+    int num_nodes, const std::vector<std::pair<int, int>>& edges, int leaf_size)
+{
+    NestedDissection nested_dissection(num_nodes, edges, leaf_size);
+    std::vector<int> nodes(num_nodes);
+    for (int i = 0; i < num_nodes; i++) {
+        nodes[i] = i;
+    }
+    nested_dissection.dissect(nodes);
+    assert(nested_dissection.order.size() == size_t(num_nodes));
+    return nested_dissection.order;
+}
+
+void OrderedLDLTSolver::set_ordering(const std::vector<int>& order)
+{
+    // The permutation maps the i-th eliminated row, order[i], to i.
+    Eigen::VectorXi indices(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        indices[order[i]] = int(i);
+    }
+    if (indices.size() != m_permutation.size()
+        || indices != m_permutation.indices()) {
+        m_permutation.indices() = indices;
+        m_is_analyzed = false;
+    }
+}
+
+bool OrderedLDLTSolver::factorize(const Eigen::SparseMatrix<double>& A)
+{
+    PROFILE_POINT("OrderedLDLTSolver::factorize");
+    PROFILE_START();
+
+    assert(A.rows() == A.cols() && A.rows() == m_permutation.size());
+    Eigen::SparseMatrix<double> PAPt;
+    PAPt.selfadjointView<Eigen::Lower>() =
+        A.selfadjointView<Eigen::Lower>().twistedBy(m_permutation);
+
+    const int* outer = PAPt.outerIndexPtr();
+    const int* inner = PAPt.innerIndexPtr();
+    const bool is_same_pattern = m_is_analyzed
+        && m_outer_indices.size() == size_t(PAPt.outerSize() + 1)
+        && m_inner_indices.size() == size_t(PAPt.nonZeros())
+        && std::equal(m_outer_indices.begin(), m_outer_indices.end(), outer)
+        && std::equal(m_inner_indices.begin(), m_inner_indices.end(), inner);
+    if (!is_same_pattern) {
+        m_ldlt.analyzePattern(PAPt);
+        m_outer_indices.assign(outer, outer + PAPt.outerSize() + 1);
+        m_inner_indices.assign(inner, inner + PAPt.nonZeros());
+        m_is_analyzed = true;
+    }
+    m_ldlt.factorize(PAPt);
+
+    PROFILE_END();
+
+    return m_ldlt.info() == Eigen::Success;
+}
+
+void OrderedLDLTSolver::solve(
+    const Eigen::VectorXd& b, Eigen::VectorXd& x) const
+{
+    x = m_permutation.transpose() * m_ldlt.solve(m_permutation * b);
+}
+
+} // namespace ipc::rigid
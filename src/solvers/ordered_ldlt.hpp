@@ -0,0 +1,60 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseCore>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Compute a nested dissection ordering of a graph.
+ *
+ * The graph is recursively split by the middle level of a breadth-first
+ * search from a pseudo-peripheral node. Both halves are ordered before their
+ * separator, so eliminating in this order limits the fill to the separators.
+ *
+ * @param num_nodes Number of nodes in the graph.
+ * @param edges     Undirected edges of the graph.
+ * @param leaf_size Parts with at most this many nodes are not split further.
+ * @return The ordering (the i-th node to eliminate is order[i]).
+ */
+std::vector<int> nested_dissection_ordering(
+    int num_nodes,
+    const std::vector<std::pair<int, int>>& edges,
+    int leaf_size = 8);
+
+/// @brief Sparse LDLᵀ factorization with a user supplied fill-reducing
+/// ordering.
+///
+/// The symbolic analysis is reused until the ordering or the sparsity pattern
+/// changes.
+class OrderedLDLTSolver {
+public:
+    /// @brief Set the ordering (the i-th row to eliminate is order[i]).
+    void set_ordering(const std::vector<int>& order);
+
+    /// @brief Factorize the symmetric matrix A.
+    /// @return True if the factorization succeeded.
+    bool factorize(const Eigen::SparseMatrix<double>& A);
+
+    /// @brief Solve A x = b with the last factorization.
+    void solve(const Eigen::VectorXd& b, Eigen::VectorXd& x) const;
+
+protected:
+    /// Maps a row of A to its row in the ordered matrix
+    Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> m_permutation;
+    Eigen::SimplicialLDLT<
+        Eigen::SparseMatrix<double>,
+        Eigen::Lower,
+        Eigen::NaturalOrdering<int>>
+        m_ldlt;
+
+    /// Sparsity pattern of the last analyzed (ordered) matrix
+    std::vector<int> m_outer_indices, m_inner_indices;
+    bool m_is_analyzed = false;
+};
+
+} // namespace ipc::rigid
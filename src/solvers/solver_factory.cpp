@@ -2,6 +2,7 @@
 
 #include <solvers/homotopy_solver.hpp>
 #include <solvers/ipc_solver.hpp>
+#include <solvers/lbfgs_solver.hpp>
 
 namespace ipc::rigid {
 
@@ -18,6 +19,8 @@ SolverFactory::SolverFactory()
         HomotopySolver::solver_name(), std::make_shared<HomotopySolver>());
     barrier_solvers.emplace(
         IPCSolver::solver_name(), std::make_shared<IPCSolver>());
+    barrier_solvers.emplace(
+        LBFGSSolver::solver_name(), std::make_shared<LBFGSSolver>());
 }
 
 std::shared_ptr<OptimizationSolver>
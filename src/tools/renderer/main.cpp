@@ -177,9 +177,9 @@ public:
         vertex_colors.resize(bodies.num_vertices());
         int start_i = 0;
         for (const auto& body : bodies.m_rbs) {
-            vertex_colors.segment(start_i, body.vertices.rows())
+            vertex_colors.segment(start_i, body.vertices().rows())
                 .setConstant(int(body.type));
-            start_i += body.vertices.rows();
+            start_i += body.vertices().rows();
         }
 
         m_fps = int(1 / sim["args"]["timestep"].get<double>());
@@ -13,7 +13,7 @@ int main(int argc, char* argv[])
     std::string sim_path = "";
     app.add_option(
            "sim_path,-i,-s,--sim-path", sim_path,
-           "JSON file with simulation results")
+           "simulation results (JSON, JSON Lines stream, or binary trajectory)")
         ->required();
 
     std::string output = "";
@@ -29,7 +29,10 @@ RigidBody create_body(
         /*is_dof_fixed=*/VectorMax6b::Zero(pose.ndof()),
         /*oriented=*/false,
         /*group_id=*/id++);
-    rb.vertices = vertices; // Cancel out the inertial rotation for testing
+    // Cancel out the inertial rotation for testing
+    auto geometry = std::make_shared<RigidBodyGeometry>(*rb.geometry);
+    geometry->vertices = vertices;
+    rb.geometry = geometry;
     rb.pose.position.setZero();
     rb.pose.rotation.setZero();
     return rb;
@@ -15,8 +15,34 @@ public:
         const Eigen::MatrixXi& E,
         const Eigen::MatrixXi& F);
 
+    /// @brief Restore a selector from its maps (e.g., loaded from a cache).
+    MeshSelector(
+        const std::vector<size_t>& vertex_to_edge,
+        const std::vector<size_t>& vertex_to_face,
+        const std::vector<size_t>& edge_to_face,
+        const Eigen::MatrixXi& faces_to_edges,
+        const std::vector<size_t>& codim_vertices_to_vertices,
+        const std::vector<size_t>& codim_edges_to_edges)
+        : m_vertex_to_edge(vertex_to_edge)
+        , m_vertex_to_face(vertex_to_face)
+        , m_edge_to_face(edge_to_face)
+        , m_faces_to_edges(faces_to_edges)
+        , m_codim_vertices_to_vertices(codim_vertices_to_vertices)
+        , m_codim_edges_to_edges(codim_edges_to_edges)
+    {
+    }
+
     size_t vertex_to_edge(size_t vi) const { return m_vertex_to_edge[vi]; }
+    const std::vector<size_t>& vertex_to_edge() const
+    {
+        return m_vertex_to_edge;
+    }
+
     size_t vertex_to_face(size_t vi) const { return m_vertex_to_face[vi]; }
+    const std::vector<size_t>& vertex_to_face() const
+    {
+        return m_vertex_to_face;
+    }
 
     size_t face_to_edge(size_t fi, size_t fi_ei) const
     {
@@ -26,12 +52,18 @@ public:
     const Eigen::MatrixXi& face_to_edges() const { return m_faces_to_edges; }
 
     size_t edge_to_face(size_t ei) const { return m_edge_to_face[ei]; }
+    const std::vector<size_t>& edge_to_face() const { return m_edge_to_face; }
 
     size_t codim_vertices_to_vertices(size_t vi) const
     {
         return m_codim_vertices_to_vertices[vi];
     }
 
+    const std::vector<size_t>& codim_vertices_to_vertices() const
+    {
+        return m_codim_vertices_to_vertices;
+    }
+
     size_t codim_edges_to_edges(size_t ei) const
     {
         return m_codim_edges_to_edges[ei];
@@ -93,9 +93,9 @@ void UISimState::load_scene()
         vertex_type.resize(bodies.num_vertices());
         int start_i = 0;
         for (const auto& body : bodies.m_rbs) {
-            vertex_type.segment(start_i, body.vertices.rows())
+            vertex_type.segment(start_i, body.vertices().rows())
                 .setConstant(int(body.type));
-            start_i += body.vertices.rows();
+            start_i += body.vertices().rows();
         }
     } else {
         vertex_type =
@@ -160,9 +160,9 @@ void UISimState::redraw_scene()
         Eigen::VectorXi vertex_type(bodies.num_vertices());
         int start_i = 0;
         for (const auto& body : bodies.m_rbs) {
-            vertex_type.segment(start_i, body.vertices.rows())
+            vertex_type.segment(start_i, body.vertices().rows())
                 .setConstant(int(body.type));
-            start_i += body.vertices.rows();
+            start_i += body.vertices().rows();
         }
         mesh_data->set_vertex_data(
             m_state.problem_ptr->vertex_dof_fixed(), vertex_type);
@@ -0,0 +1,136 @@
+#include <catch2/catch.hpp>
+
+#include <igl/PI.h>
+
+#include <ccd/rigid/rigid_body_separation.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+static RigidBody unit_square(int group_id, double scale = 1)
+{
+    Eigen::MatrixXd vertices(4, 2);
+    vertices << -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, 0.5;
+    vertices *= scale;
+    Eigen::MatrixXi edges(4, 2);
+    edges << 0, 1, 1, 2, 2, 3, 3, 0;
+    return RigidBody(
+        vertices, edges, PoseD::Zero(2), /*velocity=*/PoseD::Zero(2),
+        /*force=*/PoseD::Zero(2), /*density=*/1.0,
+        /*is_dof_fixed=*/VectorXb::Zero(3), /*oriented=*/false, group_id);
+}
+
+TEST_CASE("Convex hull separation of rigid bodies", "[ccd][rigid_body][2D]")
+{
+    std::vector<RigidBody> rbs = { unit_square(0), unit_square(1) };
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    double gap = GENERATE(0.0, 0.1, 1.0, 2.0);
+    PosesD poses_t0 = { PoseD::Zero(2), PoseD::Zero(2) };
+    poses_t0[1].position << 1 + gap, 0;
+
+    SECTION("Static lower bound")
+    {
+        double lower_bound = body_hulls_distance_lower_bound(
+            bodies[0], poses_t0[0], bodies[1], poses_t0[1],
+            /*threshold=*/0.9 * gap);
+        CHECK(lower_bound <= gap + 1e-12);
+        if (gap > 0) {
+            CHECK(lower_bound > 0.9 * gap);
+        }
+    }
+
+    SECTION("Rotated body")
+    {
+        poses_t0[1].rotation << igl::PI / 4;
+        // The corner of the rotated square is √2/2 from its center
+        double distance = gap + 0.5 - sqrt(2) / 2;
+        double lower_bound = body_hulls_distance_lower_bound(
+            bodies[0], poses_t0[0], bodies[1], poses_t0[1],
+            /*threshold=*/std::max(0.9 * distance, 0.0));
+        CHECK(lower_bound <= std::max(distance, 0.0) + 1e-12);
+    }
+
+    SECTION("Moving bodies")
+    {
+        PosesD poses_t1 = poses_t0;
+        double displacement = GENERATE(0.0, 0.25, 1.0);
+        poses_t1[0].position.x() += displacement;
+
+        bool is_separated =
+            are_body_hulls_separated(bodies, poses_t0, poses_t1, 0, 1);
+        if (displacement >= gap) {
+            CHECK(!is_separated);
+        } else if (displacement < 0.5 * gap) {
+            CHECK(is_separated);
+        }
+
+        std::vector<std::pair<int, int>> body_pairs;
+        body_pairs.emplace_back(0, 1);
+        filter_separated_body_pairs(bodies, poses_t0, poses_t1, body_pairs);
+        CHECK(body_pairs.size() == (is_separated ? 0 : 1));
+    }
+
+    SECTION("Edge-vertex trajectory filter")
+    {
+        PosesD poses_t1 = poses_t0;
+        double displacement = GENERATE(0.0, 0.25, 1.0);
+        poses_t1[0].position.x() += displacement;
+
+        // The right-bottom corner of the first square and the left edge of
+        // the second square are gap apart at t=0
+        bool is_separated = is_edge_vertex_trajectory_separated(
+            bodies[0], poses_t0[0], poses_t1[0], /*vertex_id=*/1, //
+            bodies[1], poses_t0[1], poses_t1[1], /*edge_id=*/3);
+        if (displacement >= gap) {
+            CHECK(!is_separated);
+        } else if (displacement < 0.5 * gap) {
+            CHECK(is_separated);
+        }
+
+        // Only the start of the trajectory is searched
+        if (displacement > 0 && gap > 0) {
+            CHECK(is_edge_vertex_trajectory_separated(
+                bodies[0], poses_t0[0], poses_t1[0], /*vertex_id=*/1, //
+                bodies[1], poses_t0[1], poses_t1[1], /*edge_id=*/3,
+                /*earliest_toi=*/0.4 * gap / displacement));
+        }
+    }
+}
+
+TEST_CASE(
+    "Narrow-phase filter near the threshold", "[ccd][rigid_body][2D]")
+{
+    // The filter must behave the same at every scale, and only become more
+    // conservative far from the origin.
+    const double scale = GENERATE(1e-6, 1.0, 1e6);
+    std::vector<RigidBody> rbs = { unit_square(0, scale),
+                                   unit_square(1, scale) };
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    // The right-bottom corner of the first square moves displacement toward
+    // the left edge of the second square, which is gap away at t=0.
+    const double displacement = 0.5;
+    const double relative_gap = GENERATE(1 - 1e-6, 1.0, 1 + 1e-6);
+    const double gap = relative_gap * displacement;
+    const double offset = GENERATE(0.0, 1e7);
+
+    PosesD poses_t0 = { PoseD::Zero(2), PoseD::Zero(2) };
+    poses_t0[0].position << 0, offset * scale;
+    poses_t0[1].position << (1 + gap) * scale, offset * scale;
+    PosesD poses_t1 = poses_t0;
+    poses_t1[0].position.x() += displacement * scale;
+
+    bool is_separated = is_edge_vertex_trajectory_separated(
+        bodies[0], poses_t0[0], poses_t1[0], /*vertex_id=*/1, //
+        bodies[1], poses_t0[1], poses_t1[1], /*edge_id=*/3);
+    if (relative_gap <= 1) {
+        CHECK(!is_separated); // Never reject a contact
+    } else {
+        // Rejected unless the rounding of the coordinates dominates the
+        // difference of the squared distances (≈ 1e-6 of the margin²)
+        CHECK(is_separated == (offset == 0));
+    }
+}
@@ -34,11 +34,11 @@ void print_EE_obj(
             Pose<double>::interpolate(bodyA_pose_t0, bodyA_pose_t1, i / n);
         std::cout
             << "v "
-            << bodyA.world_vertex(pose, bodyA.edges(edgeA_id, 0)).transpose()
+            << bodyA.world_vertex(pose, bodyA.edges()(edgeA_id, 0)).transpose()
             << std::endl;
         std::cout
             << "v "
-            << bodyA.world_vertex(pose, bodyA.edges(edgeA_id, 1)).transpose()
+            << bodyA.world_vertex(pose, bodyA.edges()(edgeA_id, 1)).transpose()
             << std::endl;
     }
     fmt::print("# Edge 2 vertices\n");
@@ -47,11 +47,11 @@ void print_EE_obj(
             Pose<double>::interpolate(bodyB_pose_t0, bodyB_pose_t1, i / n);
         std::cout
             << "v "
-            << bodyB.world_vertex(pose, bodyB.edges(edgeB_id, 0)).transpose()
+            << bodyB.world_vertex(pose, bodyB.edges()(edgeB_id, 0)).transpose()
             << std::endl;
         std::cout
             << "v "
-            << bodyB.world_vertex(pose, bodyB.edges(edgeB_id, 1)).transpose()
+            << bodyB.world_vertex(pose, bodyB.edges()(edgeB_id, 1)).transpose()
             << std::endl;
     }
     fmt::print("# Edge 1 surface\n");
@@ -80,7 +80,10 @@ RigidBody create_body(
         /*is_dof_fixed=*/VectorMax6b::Zero(pose.ndof()),
         /*oriented=*/false,
         /*group_id=*/id++);
-    rb.vertices = vertices; // Cancel out the inertial rotation for testing
+    // Cancel out the inertial rotation for testing
+    auto geometry = std::make_shared<RigidBodyGeometry>(*rb.geometry);
+    geometry->vertices = vertices;
+    rb.geometry = geometry;
     rb.pose.position.setZero();
     rb.pose.rotation.setZero();
     return rb;
@@ -270,7 +273,7 @@ TEST_CASE("Rigid face-vertex time of impact", "[ccd][rigid_toi][face_vertex]")
         double z_t1 = GENERATE(1, 1e-8, 0.0, -1e-8, -2.0, -10);
         expected_toi = 1 / (-z_t1 + 1);
         is_impact_expected = z_t1 <= 0.0 && y >= 0 && y <= 1.0;
-        bodyB_pose_t1.position.z() = z_t1 - bodyB.vertices(0, 2);
+        bodyB_pose_t1.position.z() = z_t1 - bodyB.vertices()(0, 2);
     }
     // SECTION("Rotation")
     // {
@@ -280,7 +283,7 @@ TEST_CASE("Rigid face-vertex time of impact", "[ccd][rigid_toi][face_vertex]")
     // }
 
     CAPTURE(
-        y, bodyB.vertices.row(0), bodyB_pose_t0.position.transpose(),
+        y, bodyB.vertices().row(0), bodyB_pose_t0.position.transpose(),
         bodyB_pose_t1.position.transpose(),
         bodyB.world_vertex(bodyB_pose_t0, 0).transpose(),
         bodyB.world_vertex(bodyB_pose_t1, 0).transpose());
@@ -310,15 +313,12 @@ TEST_CASE("Fast EE case", "[!benchmark][ccd][rigid_toi][edge_edge][fast]")
     Eigen::MatrixXi bodyB_edges(1, 2);
     bodyB_edges.row(0) << 0, 1;
 
-    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
-    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
-
     // clang-format off
-    bodyA.vertices.row(0) << 2.66473512640082, 0.622074238426736, 0.0506824409538513;
-    bodyA.vertices.row(1) << 2.11663114018755, 0.24694623070118, 0.689392835886464;
+    bodyA_vertices.row(0) << 2.66473512640082, 0.622074238426736, 0.0506824409538513;
+    bodyA_vertices.row(1) << 2.11663114018755, 0.24694623070118, 0.689392835886464;
 
-    bodyB.vertices.row(0) << -8.23540431483827, -2.00204356583054, -0.0850398676470792;
-    bodyB.vertices.row(1) << -7.59698634143846, -2.65778542381018, 0.220598272033643;
+    bodyB_vertices.row(0) << -8.23540431483827, -2.00204356583054, -0.0850398676470792;
+    bodyB_vertices.row(1) << -7.59698634143846, -2.65778542381018, 0.220598272033643;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(-0.0743518262648221, 2.0045466941596, -7.30362621222097e-05),
@@ -338,6 +338,9 @@ TEST_CASE("Fast EE case", "[!benchmark][ccd][rigid_toi][edge_edge][fast]")
     );
     // clang-format on
 
+    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
+    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
+
     BENCHMARK("Fast EE case")
     {
         double toi;
@@ -358,15 +361,12 @@ TEST_CASE("Slow EE case", "[!benchmark][ccd][rigid_toi][edge_edge][slow]")
     Eigen::MatrixXi bodyB_edges(1, 2);
     bodyB_edges.row(0) << 0, 1;
 
-    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
-    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
-
     // clang-format off
-    bodyA.vertices.row(0) << -1.45054325721069, 2.29538642849017, 0.461193969193908;
-    bodyA.vertices.row(1) << -1.12537372801783, 1.78188213954136, 1.12303701209507;
+    bodyA_vertices.row(0) << -1.45054325721069, 2.29538642849017, 0.461193969193908;
+    bodyA_vertices.row(1) << -1.12537372801783, 1.78188213954136, 1.12303701209507;
 
-    bodyB.vertices.row(0) << -8.63773122773594, 0.523601125992661, 1.91725528075351;
-    bodyB.vertices.row(1) << -8.00096703934998, 1.01814387645424, 2.44728456523133;
+    bodyB_vertices.row(0) << -8.63773122773594, 0.523601125992661, 1.91725528075351;
+    bodyB_vertices.row(1) << -8.00096703934998, 1.01814387645424, 2.44728456523133;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(-0.0743518262648221, 2.0045466941596, -7.30362621222097e-05),
@@ -386,6 +386,9 @@ TEST_CASE("Slow EE case", "[!benchmark][ccd][rigid_toi][edge_edge][slow]")
     );
     // clang-format on
 
+    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
+    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
+
     BENCHMARK("Slow EE Case")
     {
         double toi;
@@ -406,15 +409,12 @@ TEST_CASE("Actual EE Collision", "[!benchmark][ccd][rigid_toi][edge_edge]")
     Eigen::MatrixXi bodyB_edges(1, 2);
     bodyB_edges.row(0) << 0, 1;
 
-    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
-    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
-
     // clang-format off
-    bodyA.vertices.row(0) << -1, 0, 0;
-    bodyA.vertices.row(1) << 1, 0, 0;
+    bodyA_vertices.row(0) << -1, 0, 0;
+    bodyA_vertices.row(1) << 1, 0, 0;
 
-    bodyB.vertices.row(0) << 0, 0, -1;
-    bodyB.vertices.row(1) << 0, 0, 1;
+    bodyB_vertices.row(0) << 0, 0, -1;
+    bodyB_vertices.row(1) << 0, 0, 1;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(0, 0.5, 0),
@@ -434,6 +434,9 @@ TEST_CASE("Actual EE Collision", "[!benchmark][ccd][rigid_toi][edge_edge]")
     );
     // clang-format on
 
+    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
+    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
+
     BENCHMARK("Actually EE Collision")
     {
         double toi;
@@ -458,15 +461,12 @@ TEST_CASE("Actual VF Collision", "[!benchmark][ccd][rigid_toi][face_vertex]")
     igl::edges(bodyA_faces, bodyA_edges);
     igl::edges(bodyB_faces, bodyB_edges);
 
-    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges, bodyA_faces);
-    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges, bodyB_faces);
-
     // clang-format off
-    bodyA.vertices.row(0) << 0.063161123153442, -0.00975209722618602, 0.0246948915619087;
+    bodyA_vertices.row(0) << 0.063161123153442, -0.00975209722618602, 0.0246948915619087;
 
-    bodyB.vertices.row(0) << -0.00733894260009082, 0.0199670606490534, 0.000727755816038143;
-    bodyB.vertices.row(1) << -0.0122514761614292, 0.0244249832266042, -0.00566776185395443;
-    bodyB.vertices.row(2) << -0.00945035723923828, 0.025642170175986, -0.00591155842365654;
+    bodyB_vertices.row(0) << -0.00733894260009082, 0.0199670606490534, 0.000727755816038143;
+    bodyB_vertices.row(1) << -0.0122514761614292, 0.0244249832266042, -0.00566776185395443;
+    bodyB_vertices.row(2) << -0.00945035723923828, 0.025642170175986, -0.00591155842365654;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(-0.000591328227883731, 0.0888868556875028, -0.000277685809028307),
@@ -486,6 +486,9 @@ TEST_CASE("Actual VF Collision", "[!benchmark][ccd][rigid_toi][face_vertex]")
     );
     // clang-format on
 
+    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges, bodyA_faces);
+    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges, bodyB_faces);
+
     BENCHMARK("Actually VF Collision")
     {
         double toi;
@@ -509,9 +512,6 @@ TEST_CASE(
     Eigen::MatrixXi bodyB_edges(1, 2);
     bodyB_edges.row(0) << 0, 1;
 
-    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
-    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
-
     Pose<double> bodyA_pose_t0, bodyA_pose_t1, bodyB_pose_t0, bodyB_pose_t1;
 
     double earliest_toi;
@@ -519,11 +519,11 @@ TEST_CASE(
     SECTION("0")
     {
         // clang-format off
-        bodyA.vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
-        bodyA.vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
 
-        bodyB.vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
-        bodyB.vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
 
         bodyA_pose_t0 = Pose<double>(
             Eigen::Vector3d(-0.749789935368566, 1.00585262304029, 1.37760763963751e-05),
@@ -547,11 +547,11 @@ TEST_CASE(
     SECTION("1")
     {
         // clang-format off
-        bodyA.vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
-        bodyA.vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
 
-        bodyB.vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
-        bodyB.vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
 
         bodyA_pose_t0 = Pose<double>(
             Eigen::Vector3d(-0.749781303981602, 1.00328869329824, 1.45053758187115e-05),
@@ -578,6 +578,9 @@ TEST_CASE(
         earliest_toi = 0.57421;
     }
 
+    RigidBody bodyA = create_body(bodyA_vertices, bodyA_edges);
+    RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
+
     // print_EE_obj(
     //     bodyA, bodyA_pose_t0, bodyA_pose_t1, /*edgeA_id=*/0, //
     //     bodyB, bodyB_pose_t0, bodyB_pose_t1, /*edgeB_id=*/0);
@@ -849,3 +852,101 @@ TEST_CASE("toi=0", "[ccd][rigid_toi][thisone]")
         CHECK(toi > 0);
     }
 }
+
+TEST_CASE(
+    "Adaptive piecewise-linear time of impact",
+    "[ccd][rigid_toi][piecewise_linear]")
+{
+    int dim = 3;
+    // A unit radius primitive rotates quickly about an axis at offset from a
+    // static primitive, so it only reaches it if offset < 1.
+    double angle = GENERATE(2 * igl::PI, 4 * igl::PI, 20 * igl::PI);
+    double sign = GENERATE(-1.0, 1.0);
+    double offset = GENERATE(0.5, 1.5);
+
+    Eigen::MatrixXd rotating_vertices(2, dim);
+    rotating_vertices.row(0) << 1, 0, 0;
+    rotating_vertices.row(1) << -1, 0, 0;
+    Eigen::MatrixXi rotating_edges(1, 2);
+    rotating_edges.row(0) << 0, 1;
+    RigidBody rotating_body = create_body(rotating_vertices, rotating_edges);
+    Pose<double> rotating_pose_t0 = Pose<double>::Zero(dim);
+    Pose<double> rotating_pose_t1 = Pose<double>::Zero(dim);
+
+    double single_toi = 1, adaptive_toi = 1, rigid_toi = 1;
+    bool is_single_impacting, is_adaptive_impacting, is_rigid_impacting;
+    SECTION("Edge-edge")
+    {
+        // The edge spins about the z-axis toward an edge along the z-axis
+        Eigen::MatrixXd vertices(2, dim);
+        vertices.row(0) << 0, offset, -1;
+        vertices.row(1) << 0, offset, 1;
+        Eigen::MatrixXi edges(1, 2);
+        edges.row(0) << 0, 1;
+        RigidBody body = create_body(vertices, edges);
+        Pose<double> pose = Pose<double>::Zero(dim);
+        rotating_pose_t1.rotation.z() = sign * angle;
+
+        is_single_impacting = compute_piecewise_linear_edge_edge_time_of_impact(
+            rotating_body, rotating_pose_t0, rotating_pose_t1, 0, //
+            body, pose, pose, 0, single_toi, /*earliest_toi=*/1,
+            /*minimum_separation_distance=*/0, TESTING_TOI_TOLERANCE,
+            PiecewiseLinearPieces::SINGLE);
+        is_adaptive_impacting =
+            compute_piecewise_linear_edge_edge_time_of_impact(
+                rotating_body, rotating_pose_t0, rotating_pose_t1, 0, //
+                body, pose, pose, 0, adaptive_toi, /*earliest_toi=*/1,
+                /*minimum_separation_distance=*/0, TESTING_TOI_TOLERANCE,
+                PiecewiseLinearPieces::ADAPTIVE);
+        is_rigid_impacting = compute_edge_edge_time_of_impact(
+            rotating_body, rotating_pose_t0, rotating_pose_t1, 0, //
+            body, pose, pose, 0, rigid_toi, /*earliest_toi=*/1,
+            TESTING_TOI_TOLERANCE);
+    }
+    SECTION("Face-vertex")
+    {
+        // The first vertex spins about the y-axis toward a face in the
+        // xy-plane
+        Eigen::MatrixXd vertices(3, dim);
+        vertices.row(0) << -2, -2, 0;
+        vertices.row(1) << 2, -2, 0;
+        vertices.row(2) << 0, 2, 0;
+        Eigen::MatrixXi faces(1, 3);
+        faces.row(0) << 0, 1, 2;
+        Eigen::MatrixXi edges;
+        igl::edges(faces, edges);
+        RigidBody body = create_body(vertices, edges, faces);
+        Pose<double> pose = Pose<double>::Zero(dim);
+        rotating_pose_t0.position.z() = offset;
+        rotating_pose_t1.position.z() = offset;
+        rotating_pose_t1.rotation.y() = sign * angle;
+
+        is_single_impacting =
+            compute_piecewise_linear_face_vertex_time_of_impact(
+                rotating_body, rotating_pose_t0, rotating_pose_t1, 0, //
+                body, pose, pose, 0, single_toi, /*earliest_toi=*/1,
+                /*minimum_separation_distance=*/0, TESTING_TOI_TOLERANCE,
+                PiecewiseLinearPieces::SINGLE);
+        is_adaptive_impacting =
+            compute_piecewise_linear_face_vertex_time_of_impact(
+                rotating_body, rotating_pose_t0, rotating_pose_t1, 0, //
+                body, pose, pose, 0, adaptive_toi, /*earliest_toi=*/1,
+                /*minimum_separation_distance=*/0, TESTING_TOI_TOLERANCE,
+                PiecewiseLinearPieces::ADAPTIVE);
+        is_rigid_impacting = compute_face_vertex_time_of_impact(
+            rotating_body, rotating_pose_t0, rotating_pose_t1, 0, //
+            body, pose, pose, 0, rigid_toi, /*earliest_toi=*/1,
+            TESTING_TOI_TOLERANCE);
+    }
+
+    CAPTURE(angle, sign, offset, single_toi, adaptive_toi, rigid_toi);
+    REQUIRE(is_rigid_impacting == (offset < 1));
+    if (is_rigid_impacting) {
+        // Neither start misses the impact, and both stop before it
+        CHECK(is_single_impacting);
+        CHECK(is_adaptive_impacting);
+        CHECK(single_toi <= rigid_toi + Constants::RIGID_CCD_TOI_TOL);
+        CHECK(adaptive_toi <= rigid_toi + Constants::RIGID_CCD_TOI_TOL);
+        CHECK(adaptive_toi > 0);
+    }
+}
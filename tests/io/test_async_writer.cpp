@@ -0,0 +1,42 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include <io/async_writer.hpp>
+
+using namespace ipc::rigid;
+
+TEST_CASE("Asynchronous writes run in order", "[io][async_writer]")
+{
+    size_t max_queued_tasks = GENERATE(1, 4);
+    AsyncWriter writer(max_queued_tasks);
+    CHECK(writer.wait()); // Nothing to wait for
+
+    std::vector<int> written;
+    std::atomic<int> num_running(0);
+    bool overlapped = false;
+    size_t task_id = 0;
+    for (int i = 0; i < 20; i++) {
+        task_id = writer.push([&, i]() {
+            overlapped |= num_running++ > 0;
+            written.push_back(i);
+            num_running--;
+            return true;
+        });
+    }
+    CHECK(writer.wait_for(task_id));
+    CHECK(!overlapped);
+    REQUIRE(written.size() == 20);
+    for (int i = 0; i < 20; i++) {
+        CHECK(written[i] == i);
+    }
+
+    SECTION("Failures are reported by the next wait")
+    {
+        writer.push([]() { return false; });
+        writer.push([]() { return true; });
+        CHECK(!writer.wait());
+        CHECK(writer.wait());
+    }
+}
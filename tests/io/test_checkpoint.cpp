@@ -0,0 +1,161 @@
+#include <catch2/catch.hpp>
+
+#include <tbb/global_control.h>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <SimState.hpp>
+#include <io/checkpoint.hpp>
+#include <physics/rigid_body_problem.hpp>
+
+using namespace ipc::rigid;
+
+TEST_CASE("Write and read a binary checkpoint", "[io][checkpoint]")
+{
+    int dim = GENERATE(2, 3);
+    int ndof = PoseD::dim_to_ndof(dim);
+    std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test.ckpt").string();
+
+    Checkpoint checkpoint;
+    checkpoint.args = { { "timestep", 1e-2 }, { "scene_type", "test" } };
+    checkpoint.dim = dim;
+    checkpoint.num_steps = 42;
+    checkpoint.timestep = 1e-2;
+    checkpoint.barrier_stiffness = 1234.5;
+    for (int i = 0; i < 3; i++) {
+        RigidBodyCheckpoint body;
+        body.type = i;
+        body.is_dof_fixed = VectorMax6b::Zero(ndof);
+        body.is_dof_fixed[0] = i % 2;
+        body.pose = PoseD(VectorMax6d::Random(ndof));
+        body.pose_prev = PoseD(VectorMax6d::Random(ndof));
+        body.velocity = PoseD(VectorMax6d::Random(ndof));
+        body.velocity_prev = PoseD(VectorMax6d::Random(ndof));
+        body.acceleration = PoseD(VectorMax6d::Random(ndof));
+        body.force = PoseD(VectorMax6d::Random(ndof));
+        body.Qdot = Eigen::Matrix3d::Random();
+        body.Qddot = Eigen::Matrix3d::Random();
+        body.kinematic_max_time = i - 1;
+        for (int j = 0; j < i; j++) {
+            body.kinematic_poses.emplace_back(VectorMax6d::Random(ndof));
+        }
+        checkpoint.bodies.push_back(body);
+    }
+
+    CHECK(write_checkpoint(filename, checkpoint));
+
+    Checkpoint loaded;
+    REQUIRE(read_checkpoint(filename, loaded));
+    CHECK(loaded.args == checkpoint.args);
+    CHECK(loaded.dim == dim);
+    CHECK(loaded.num_steps == checkpoint.num_steps);
+    CHECK(loaded.timestep == checkpoint.timestep);
+    CHECK(loaded.barrier_stiffness == checkpoint.barrier_stiffness);
+    REQUIRE(loaded.bodies.size() == checkpoint.bodies.size());
+    for (size_t i = 0; i < loaded.bodies.size(); i++) {
+        const RigidBodyCheckpoint& expected = checkpoint.bodies[i];
+        const RigidBodyCheckpoint& body = loaded.bodies[i];
+        CHECK(body.type == expected.type);
+        CHECK(body.is_dof_fixed == expected.is_dof_fixed);
+        // The state must be bitwise identical to continue the simulation
+        CHECK(body.pose.dof() == expected.pose.dof());
+        CHECK(body.pose_prev.dof() == expected.pose_prev.dof());
+        CHECK(body.velocity.dof() == expected.velocity.dof());
+        CHECK(body.velocity_prev.dof() == expected.velocity_prev.dof());
+        CHECK(body.acceleration.dof() == expected.acceleration.dof());
+        CHECK(body.force.dof() == expected.force.dof());
+        CHECK(body.Qdot == expected.Qdot);
+        CHECK(body.Qddot == expected.Qddot);
+        CHECK(body.kinematic_max_time == expected.kinematic_max_time);
+        REQUIRE(body.kinematic_poses.size() == expected.kinematic_poses.size());
+        for (size_t j = 0; j < body.kinematic_poses.size(); j++) {
+            CHECK(
+                body.kinematic_poses[j].dof()
+                == expected.kinematic_poses[j].dof());
+        }
+    }
+
+    // Truncated files are rejected
+    std::vector<char> data = serialize_checkpoint(checkpoint);
+    CHECK(!deserialize_checkpoint(data.data(), data.size() - 1, loaded));
+    CHECK(!deserialize_checkpoint(data.data(), 10, loaded));
+
+    fs::remove(filename);
+}
+
+TEST_CASE("Continue a simulation from a checkpoint", "[io][checkpoint]")
+{
+    // The contact potentials are summed per thread, so the runs are only
+    // bitwise identical with a single thread.
+    tbb::global_control thread_limiter(
+        tbb::global_control::max_allowed_parallelism, 1);
+
+    // A box sliding with friction on a fixed floor
+    nlohmann::json scene = R"({
+        "timestep": 0.01,
+        "rigid_body_problem": {
+            "gravity": [0, -9.81],
+            "coefficient_friction": 0.5,
+            "rigid_bodies": [{
+                "vertices": [[-5, -0.5], [5, -0.5], [5, 0.5], [-5, 0.5]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "position": [0, -0.5],
+                "is_dof_fixed": [true, true, true]
+            }, {
+                "vertices": [
+                    [-0.5, -0.5], [0.5, -0.5], [0.5, 0.5], [-0.5, 0.5]
+                ],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "position": [0, 0.502],
+                "linear_velocity": [2, 0]
+            }]
+        }
+    })"_json;
+    const int num_steps = 10, checkpoint_step = 4;
+    scene["max_iterations"] = num_steps;
+    const fs::path output_dir =
+        fs::temp_directory_path() / "rigid_ipc_test_continuation";
+    fs::remove_all(output_dir);
+
+    SimState sim;
+    REQUIRE(sim.init(scene));
+    sim.m_checkpoint_frequency = checkpoint_step;
+    sim.run_simulation((output_dir / "sim.json").string());
+    REQUIRE(sim.m_num_simulation_steps == num_steps);
+    const std::string checkpoint_filename =
+        (output_dir / fmt::format("sim-chkpt{:05d}.ckpt", checkpoint_step))
+            .string();
+    REQUIRE(fs::exists(checkpoint_filename));
+
+    SimState continued_sim;
+    REQUIRE(continued_sim.load_checkpoint(checkpoint_filename));
+    CHECK(continued_sim.m_num_simulation_steps == checkpoint_step);
+    CHECK(continued_sim.m_max_simulation_steps == num_steps - checkpoint_step);
+    continued_sim.run_simulation((output_dir / "continued_sim.json").string());
+    REQUIRE(continued_sim.m_num_simulation_steps == num_steps);
+
+    const std::vector<RigidBody>& expected_bodies =
+        std::dynamic_pointer_cast<RigidBodyProblem>(sim.problem_ptr)
+            ->m_assembler.m_rbs;
+    const std::vector<RigidBody>& bodies =
+        std::dynamic_pointer_cast<RigidBodyProblem>(continued_sim.problem_ptr)
+            ->m_assembler.m_rbs;
+    REQUIRE(bodies.size() == expected_bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        CHECK(bodies[i].pose.dof() == expected_bodies[i].pose.dof());
+        CHECK(bodies[i].velocity.dof() == expected_bodies[i].velocity.dof());
+    }
+
+    // A checkpoint past the end of its run has no time-steps left
+    Checkpoint checkpoint;
+    REQUIRE(read_checkpoint(checkpoint_filename, checkpoint));
+    checkpoint.args["max_iterations"] = checkpoint_step - 1;
+    REQUIRE(write_checkpoint(checkpoint_filename, checkpoint));
+    REQUIRE(continued_sim.load_checkpoint(checkpoint_filename));
+    CHECK(continued_sim.m_max_simulation_steps == 0);
+    continued_sim.run_simulation((output_dir / "continued_sim.json").string());
+    CHECK(continued_sim.m_num_simulation_steps == checkpoint_step);
+
+    fs::remove_all(output_dir);
+}
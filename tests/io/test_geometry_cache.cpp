@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/geometry_cache.hpp>
+#include <io/read_rb_scene.hpp>
+#include <logger.hpp>
+
+using namespace ipc::rigid;
+
+TEST_CASE("Cache the processed geometries of mesh files", "[io][cache]")
+{
+    const fs::path tmp_dir = fs::temp_directory_path();
+    const fs::path cache_dir = tmp_dir / "rigid_ipc_test_geometry_cache";
+    const std::string mesh_filename =
+        (tmp_dir / "rigid_ipc_test_cube.obj").string();
+    fs::remove_all(cache_dir);
+    {
+        std::ofstream file(mesh_filename);
+        file << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+             << "v 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+             << "f 1 3 2\nf 1 4 3\nf 5 6 7\nf 5 7 8\nf 1 2 6\nf 1 6 5\n"
+             << "f 2 3 7\nf 2 7 6\nf 3 4 8\nf 3 8 7\nf 4 1 5\nf 4 5 8\n";
+    }
+
+    // The bodies have different scales and rotations, so they do not share
+    // a geometry.
+    const std::string scene = fmt::format(
+        R"({{"rigid_bodies": [
+            {{"mesh": "{0}", "scale": 2, "rotation": [30, 0, 45],
+              "density": 500}},
+            {{"mesh": "{0}", "scale": [1, 2, 3], "rotation": [0, 10, 20],
+              "is_dof_fixed": [false, false, false, true, true, false]}}
+        ]}})",
+        mesh_filename);
+
+    std::vector<RigidBody> expected_rbs;
+    set_geometry_cache_directory("");
+    REQUIRE(read_rb_scene_from_str(scene, expected_rbs));
+    CHECK(!fs::exists(cache_dir));
+
+    set_geometry_cache_directory(cache_dir.string());
+    // The first load fills the cache and the second one reads from it.
+    for (int i = 0; i < 2; i++) {
+        std::vector<RigidBody> rbs;
+        REQUIRE(read_rb_scene_from_str(scene, rbs));
+        // One mesh and two geometries
+        CHECK(std::distance(
+                  fs::directory_iterator(cache_dir), fs::directory_iterator())
+              == 3);
+
+        REQUIRE(rbs.size() == expected_rbs.size());
+        for (size_t j = 0; j < rbs.size(); j++) {
+            const RigidBody& rb = rbs[j];
+            const RigidBody& expected_rb = expected_rbs[j];
+            CHECK(rb.vertices() == expected_rb.vertices());
+            CHECK(rb.edges() == expected_rb.edges());
+            CHECK(rb.faces() == expected_rb.faces());
+            CHECK(rb.mass == expected_rb.mass);
+            CHECK(rb.moment_of_inertia == expected_rb.moment_of_inertia);
+            CHECK(rb.pose.dof() == expected_rb.pose.dof());
+            CHECK(
+                rb.average_edge_length()
+                == expected_rb.average_edge_length());
+            CHECK(rb.r_max() == expected_rb.r_max());
+            CHECK(
+                rb.mesh_selector().face_to_edges()
+                == expected_rb.mesh_selector().face_to_edges());
+            CHECK(
+                rb.mesh_selector().codim_edges_to_edges()
+                == expected_rb.mesh_selector().codim_edges_to_edges());
+            CHECK(rb.world_vertices() == expected_rb.world_vertices());
+        }
+    }
+
+    // A changed mesh file does not use the stale records
+    {
+        std::ofstream file(mesh_filename, std::ios::app);
+        file << "v 2 2 2\nl 7 9\n";
+    }
+    std::vector<RigidBody> rbs;
+    REQUIRE(read_rb_scene_from_str(scene, rbs));
+    CHECK(rbs[0].num_vertices() == 9);
+    CHECK(rbs[0].num_codim_edges() == 1);
+
+    set_geometry_cache_directory("");
+    fs::remove_all(cache_dir);
+    fs::remove(mesh_filename);
+}
+
+TEST_CASE("Ignore invalid geometry cache records", "[io][cache]")
+{
+    const fs::path cache_dir =
+        fs::temp_directory_path() / "rigid_ipc_test_invalid_geometry_cache";
+    fs::remove_all(cache_dir);
+    set_geometry_cache_directory(cache_dir.string());
+
+    Eigen::MatrixXd V(3, 2);
+    V << 0, 0, 1, 0, 0, 1;
+    Eigen::MatrixXi E(3, 2);
+    E << 0, 1, 1, 2, 2, 0;
+    save_cached_mesh(42, V, E, Eigen::MatrixXi());
+
+    Eigen::MatrixXd loaded_V;
+    Eigen::MatrixXi loaded_E, loaded_F;
+    REQUIRE(load_cached_mesh(42, loaded_V, loaded_E, loaded_F));
+    CHECK(loaded_V == V);
+    CHECK(loaded_E == E);
+    CHECK(loaded_F.size() == 0);
+    CHECK(!load_cached_mesh(43, loaded_V, loaded_E, loaded_F));
+
+    // Truncate the record
+    const fs::path record = fs::directory_iterator(cache_dir)->path();
+    fs::resize_file(record, fs::file_size(record) - 8);
+    CHECK(!load_cached_mesh(42, loaded_V, loaded_E, loaded_F));
+
+    set_geometry_cache_directory("");
+    CHECK(!load_cached_mesh(42, loaded_V, loaded_E, loaded_F));
+    fs::remove_all(cache_dir);
+}
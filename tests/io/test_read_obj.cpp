@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/read_obj.hpp>
+
+using namespace ipc::rigid;
+
+TEST_CASE("Read an obj file", "[io][obj]")
+{
+    std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test.obj").string();
+    std::string newline = GENERATE(as<std::string>(), "\n", "\r\n");
+    {
+        std::ofstream file(filename, std::ios::binary);
+        for (const char* line : {
+                 "# comment", "o object", "mtllib a.mtl", "v 0 0 0",
+                 "v 1.5 0 +0", "v 0 1e-3 -2", "vn 0 0 1", "vt 0.5 0.5",
+                 "s off", "f 1 2 3", "v 1 1 1", "f 1//1 -2//1 -1//1",
+                 "l 1 -1 2" }) {
+            file << line << newline;
+        }
+        file << "f 2/1/1 3/2/1 4/3/1"; // No newline at the end of the file
+    }
+
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi E, F;
+    REQUIRE(read_obj(filename, V, E, F));
+
+    Eigen::MatrixXd expected_V(4, 3);
+    expected_V << 0, 0, 0, 1.5, 0, 0, 0, 1e-3, -2, 1, 1, 1;
+    CHECK(V == expected_V);
+    Eigen::MatrixXi expected_F(3, 3);
+    expected_F << 0, 1, 2, 0, 2, 3, 1, 2, 3;
+    CHECK(F == expected_F);
+    // Polyline segments followed by the face edges
+    REQUIRE(E.rows() >= 2);
+    CHECK(E.cols() == 2);
+    CHECK(E.row(0) == Eigen::RowVector2i(0, 3));
+    CHECK(E.row(1) == Eigen::RowVector2i(3, 1));
+
+    fs::remove(filename);
+}
+
+TEST_CASE("Read a large obj file in chunks", "[io][obj]")
+{
+    std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_large.obj").string();
+    // Enough vertices to split the file into several chunks
+    const int num_vertices = 200000;
+    {
+        std::ofstream file(filename);
+        for (int i = 0; i < num_vertices; i++) {
+            file << "v " << i << " " << 0.5 * i << " " << -i << "\n";
+            if (i >= 2 && i % 2 == 0) {
+                // Mix absolute and relative indices
+                file << "f " << i - 1 << " " << i << " -1\n";
+            }
+        }
+    }
+
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi E, F;
+    REQUIRE(read_obj(filename, V, E, F));
+
+    REQUIRE(V.rows() == num_vertices);
+    REQUIRE(V.cols() == 3);
+    for (int i = 0; i < num_vertices; i++) {
+        CHECK(V.row(i) == Eigen::RowVector3d(i, 0.5 * i, -i));
+    }
+    REQUIRE(F.rows() == num_vertices / 2 - 1);
+    for (int i = 0; i < F.rows(); i++) {
+        int vi = 2 * (i + 1);
+        CHECK(F.row(i) == Eigen::RowVector3i(vi - 2, vi - 1, vi));
+    }
+
+    fs::remove(filename);
+}
+
+TEST_CASE("Reject invalid obj files", "[io][obj]")
+{
+    std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_invalid.obj").string();
+    // Invalid index, single vertex polyline, mixed face degrees, and mixed
+    // vertex dimensions
+    std::string content = GENERATE(
+        as<std::string>(), "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 x 3\n",
+        "v 0 0 0\nl 1\n", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\nf 1 2 3 -1\n",
+        "v 0 0 0\nv 1 0\n");
+    {
+        std::ofstream file(filename);
+        file << content;
+    }
+
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi E, F;
+    CHECK(!read_obj(filename, V, E, F));
+    CHECK(!read_obj(filename + ".missing", V, E, F));
+
+    fs::remove(filename);
+}
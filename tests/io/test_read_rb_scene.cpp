@@ -48,7 +48,7 @@ TEST_CASE("Read 2D RB Scene", "[io][json][rigid-body]")
 
     Eigen::MatrixXi edges(6, 2);
     edges << 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 0;
-    CHECK((edges - rbs[0].edges).squaredNorm() == Approx(0.0).margin(1e-12));
+    CHECK((edges - rbs[0].edges()).squaredNorm() == Approx(0.0).margin(1e-12));
 
     Eigen::Vector3d velocity(3);
     velocity << 0, 0, 0;
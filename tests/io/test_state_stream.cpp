@@ -0,0 +1,128 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <SimState.hpp>
+#include <io/state_stream.hpp>
+
+using namespace ipc::rigid;
+
+namespace {
+
+// Two boxes falling without ever touching, so the run is deterministic
+const char* const FALLING_BOXES_SCENE = R"({
+    "timestep": 0.01,
+    "rigid_body_problem": {
+        "gravity": [0, -9.81],
+        "rigid_bodies": [{
+            "vertices": [[0, 0], [1, 0], [1, 1], [0, 1]],
+            "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+            "position": [0, 0],
+            "linear_velocity": [1, 0],
+            "angular_velocity": [3]
+        }, {
+            "vertices": [[0, 0], [2, 0], [2, 1], [0, 1]],
+            "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+            "position": [10, 5],
+            "linear_velocity": [0, 2]
+        }]
+    }
+})";
+
+std::string read_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+} // namespace
+
+TEST_CASE("Recover the states of a crashed run", "[io][state_stream]")
+{
+    const size_t num_steps = 5;
+    const std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test.jsonl").string();
+
+    SimState sim;
+    REQUIRE(sim.init(nlohmann::json::parse(FALLING_BOXES_SCENE)));
+    for (size_t i = 0; i < num_steps; i++) {
+        sim.simulation_step();
+        sim.save_simulation_step();
+    }
+    const std::vector<nlohmann::json>& states = sim.state_sequence;
+    REQUIRE(states.size() == num_steps + 1);
+
+    {
+        StateStreamWriter writer;
+        REQUIRE(writer.open(filename, sim.args));
+        for (const nlohmann::json& state : states) {
+            CHECK(writer.write(state));
+        }
+        CHECK(writer.num_states() == states.size());
+    }
+
+    // Crash in the middle of writing the last state
+    fs::resize_file(filename, fs::file_size(filename) - 10);
+
+    StateStreamReader reader;
+    REQUIRE(reader.open(filename));
+    CHECK(reader.args() == sim.args);
+    nlohmann::json state;
+    size_t num_states = 0;
+    while (reader.next(state)) {
+        REQUIRE(num_states < states.size() - 1);
+        CHECK(state == states[num_states]);
+        num_states++;
+    }
+    CHECK(num_states == states.size() - 1);
+
+    SimState recovered_sim;
+    REQUIRE(recovered_sim.load_state_stream(filename));
+    CHECK(recovered_sim.args == sim.args);
+    REQUIRE(recovered_sim.state_sequence.size() == states.size() - 1);
+    for (size_t i = 0; i < recovered_sim.state_sequence.size(); i++) {
+        CHECK(recovered_sim.state_sequence[i] == states[i]);
+    }
+    CHECK(recovered_sim.m_num_simulation_steps == int(num_steps) - 1);
+
+    fs::remove(filename);
+}
+
+TEST_CASE(
+    "Streamed states are saved like the states in memory",
+    "[io][state_stream]")
+{
+    std::string results[2];
+    for (bool stream_states : { false, true }) {
+        const fs::path filename = fs::temp_directory_path()
+            / (stream_states ? "rigid_ipc_test_streamed.json"
+                             : "rigid_ipc_test_in_memory.json");
+
+        SimState sim;
+        REQUIRE(sim.init(nlohmann::json::parse(FALLING_BOXES_SCENE)));
+        sim.m_max_simulation_steps = 5;
+        sim.m_stream_states = stream_states;
+        sim.run_simulation(filename.string());
+
+        // The stream is removed once the results are saved
+        CHECK(!fs::exists(fs::path(filename).replace_extension(".jsonl")));
+        results[int(stream_states)] = read_file(filename.string());
+        fs::remove(filename);
+    }
+
+    // The stats hold the step timings and memory usage, so only the states
+    // and arguments are compared.
+    const size_t stats_start = results[0].find(R"(,"stats":)");
+    REQUIRE(stats_start != std::string::npos);
+    CHECK(
+        results[1].substr(0, stats_start)
+        == results[0].substr(0, stats_start));
+    CHECK(
+        nlohmann::json::parse(results[1])["stats"]["solve_stats"]
+        == nlohmann::json::parse(results[0])["stats"]["solve_stats"]);
+}
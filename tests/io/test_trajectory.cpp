@@ -0,0 +1,162 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/trajectory.hpp>
+
+using namespace ipc::rigid;
+
+TEST_CASE("Write and read a binary trajectory", "[io][trajectory]")
+{
+    int dim = GENERATE(2, 3);
+    bool single_precision = GENERATE(false, true);
+    int ndof = PoseD::dim_to_ndof(dim);
+    const size_t num_bodies = 5, num_frames = 4;
+    const double timestep = 1e-2;
+    std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test.traj").string();
+
+    std::vector<PosesD> poses(num_frames), velocities(num_frames);
+    {
+        TrajectoryWriter writer;
+        REQUIRE(writer.open(
+            filename, dim, num_bodies, timestep, { { "args", 42 } },
+            single_precision));
+        for (size_t i = 0; i < num_frames; i++) {
+            for (size_t j = 0; j < num_bodies; j++) {
+                poses[i].emplace_back(VectorMax6d::Random(ndof));
+                velocities[i].emplace_back(VectorMax6d::Random(ndof));
+            }
+            CHECK(writer.write_frame(i * timestep, poses[i], velocities[i]));
+        }
+        CHECK(writer.close());
+    }
+
+    TrajectoryReader reader;
+    REQUIRE(reader.open(filename));
+    CHECK(reader.dim() == dim);
+    CHECK(reader.num_bodies() == num_bodies);
+    CHECK(reader.timestep() == timestep);
+    CHECK(reader.metadata()["args"] == 42);
+    REQUIRE(reader.num_frames() == num_frames);
+
+    double tol = single_precision ? 1e-6 : 0;
+    // Read the frames out of order
+    for (size_t i = num_frames; i-- > 0;) {
+        CHECK(reader.time(i) == Approx(i * timestep));
+        PosesD frame_poses = reader.poses(i);
+        PosesD frame_velocities = reader.velocities(i);
+        for (size_t j = 0; j < num_bodies; j++) {
+            CHECK(
+                (frame_poses[j].dof() - poses[i][j].dof())
+                    .lpNorm<Eigen::Infinity>()
+                <= tol);
+            CHECK(
+                (frame_velocities[j].dof() - velocities[i][j].dof())
+                    .lpNorm<Eigen::Infinity>()
+                <= tol);
+            CHECK(reader.pose(i, j).dof() == frame_poses[j].dof());
+        }
+    }
+
+    reader.close();
+    fs::remove(filename);
+}
+
+TEST_CASE("Recover the frames of an unclosed trajectory", "[io][trajectory]")
+{
+    const int dim = 3, ndof = PoseD::dim_to_ndof(dim);
+    const size_t num_bodies = 2, num_frames = 3;
+    const double timestep = 1e-2;
+    std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test.traj").string();
+    std::string crashed_filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_crashed.traj").string();
+
+    std::vector<PosesD> poses(num_frames);
+    {
+        TrajectoryWriter writer;
+        REQUIRE(writer.open(
+            filename, dim, num_bodies, timestep, { { "args", 42 } }));
+        for (size_t i = 0; i < num_frames; i++) {
+            for (size_t j = 0; j < num_bodies; j++) {
+                poses[i].emplace_back(VectorMax6d::Random(ndof));
+            }
+            CHECK(writer.write_frame(i * timestep, poses[i], poses[i]));
+        }
+        // Copy the file before it is closed like a crashed run
+        fs::copy_file(
+            filename, crashed_filename, fs::copy_options::overwrite_existing);
+    }
+    // Start writing another frame
+    fs::resize_file(crashed_filename, fs::file_size(crashed_filename) + 20);
+
+    TrajectoryReader reader;
+    REQUIRE(reader.open(crashed_filename));
+    CHECK(reader.metadata()["args"] == 42);
+    REQUIRE(reader.num_frames() == num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+        CHECK(reader.time(i) == Approx(i * timestep));
+        PosesD frame_poses = reader.poses(i);
+        for (size_t j = 0; j < num_bodies; j++) {
+            CHECK(frame_poses[j].dof() == poses[i][j].dof());
+        }
+    }
+
+    reader.close();
+    fs::remove(filename);
+    fs::remove(crashed_filename);
+}
+
+TEST_CASE("Reject invalid trajectory headers", "[io][trajectory]")
+{
+    std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test.traj").string();
+    {
+        TrajectoryWriter writer;
+        REQUIRE(writer.open(filename, 2, 1, 1e-2, nlohmann::json::object()));
+        CHECK(writer.write_frame(0, { PoseD::Zero(2) }, { PoseD::Zero(2) }));
+        CHECK(writer.close());
+    }
+    TrajectoryReader reader;
+    REQUIRE(reader.open(filename));
+    reader.close();
+
+    TrajectoryHeader header;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    const uint64_t file_size = fs::file_size(filename);
+
+    TrajectoryHeader invalid_header = header;
+    SECTION("Invalid dimension") { invalid_header.dim = 4; }
+    SECTION("Too many frames") { invalid_header.num_frames = 2; }
+    SECTION("Index past the end of the file")
+    {
+        invalid_header.index_offset = file_size;
+    }
+    SECTION("Index before the frames")
+    {
+        invalid_header.index_offset = sizeof(TrajectoryHeader);
+    }
+    SECTION("Too many bodies") { invalid_header.num_bodies = ~0ull; }
+    SECTION("Metadata past the end of the file")
+    {
+        invalid_header.metadata_size = ~0ull;
+    }
+
+    {
+        std::fstream file(
+            filename, std::ios::binary | std::ios::in | std::ios::out);
+        file.write(
+            reinterpret_cast<const char*>(&invalid_header),
+            sizeof(invalid_header));
+    }
+    CHECK(!reader.open(filename));
+    CHECK(reader.num_frames() == 0);
+
+    fs::remove(filename);
+}
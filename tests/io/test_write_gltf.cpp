@@ -0,0 +1,216 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+#include <nlohmann/json.hpp>
+
+#include <io/read_rb_scene.hpp>
+#include <io/write_gltf.hpp>
+
+using namespace ipc::rigid;
+
+namespace {
+
+std::string read_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+uint32_t read_uint32(const std::string& data, size_t offset)
+{
+    uint32_t value;
+    std::memcpy(&value, data.data() + offset, sizeof(uint32_t));
+    return value;
+}
+
+std::string decode_base64(const std::string& encoded)
+{
+    static const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                        "abcdefghijklmnopqrstuvwxyz"
+                                        "0123456789+/";
+    std::string decoded;
+    uint32_t group = 0;
+    int num_bits = 0;
+    for (char c : encoded) {
+        if (c == '=') {
+            break;
+        }
+        size_t value = alphabet.find(c);
+        REQUIRE(value != std::string::npos);
+        group = (group << 6) | uint32_t(value);
+        num_bits += 6;
+        if (num_bits >= 8) {
+            num_bits -= 8;
+            decoded.push_back(char((group >> num_bits) & 0xFF));
+        }
+    }
+    return decoded;
+}
+
+} // namespace
+
+TEST_CASE("Write glTF animations", "[io][gltf]")
+{
+    // With one body, one to three frames end the buffer with a two, one, and
+    // three byte base64 group.
+    const size_t num_bodies = GENERATE(1, 2);
+    const size_t num_frames = GENERATE(1, 2, 3, 10);
+    const double timestep = 1e-2;
+
+    nlohmann::json jrb = R"({
+        "vertices": [[0, 0, 0], [1, 0, 0], [0, 1, 0], [0, 0, 1]],
+        "faces": [[0, 2, 1], [0, 1, 3], [0, 3, 2], [1, 2, 3]],
+        "edges": [[0, 1], [1, 2], [2, 0], [0, 3], [1, 3], [2, 3]]
+    })"_json;
+    nlohmann::json scene;
+    scene["rigid_bodies"] = std::vector<nlohmann::json>(num_bodies, jrb);
+    std::vector<RigidBody> rbs;
+    REQUIRE(read_rb_scene(scene, rbs));
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    std::vector<PosesD> frames(num_frames);
+    GltfAnimation animation;
+    for (PosesD& poses : frames) {
+        for (size_t i = 0; i < num_bodies; i++) {
+            poses.emplace_back(
+                Eigen::Vector3d::Random().eval(),
+                Eigen::Vector3d::Random().eval());
+        }
+        animation.push_back(poses);
+    }
+    REQUIRE(animation.num_frames() == num_frames);
+
+    const fs::path tmp_dir = fs::temp_directory_path();
+    const std::string glb_filename = (tmp_dir / "rigid_ipc_test.glb").string();
+    REQUIRE(write_gltf(glb_filename, bodies, animation, timestep));
+
+    // Reading the poses directly writes the same file, reading the frames of
+    // one body at a time (after the rest transforms of the first frame).
+    const std::string read_glb_filename =
+        (tmp_dir / "rigid_ipc_test_read.glb").string();
+    std::vector<std::pair<size_t, size_t>> reads;
+    REQUIRE(write_gltf(
+        read_glb_filename, bodies, num_frames,
+        [&](size_t frame, size_t body, float* transform) {
+            reads.emplace_back(frame, body);
+            gltf_transform(frames[frame][body], transform);
+        },
+        timestep));
+    REQUIRE(reads.size() == num_bodies + 2 * num_bodies * num_frames);
+    for (size_t i = 0; i < num_bodies; i++) {
+        CHECK(reads[i] == std::make_pair(size_t(0), i));
+        for (size_t j = 0; j < 2 * num_frames; j++) {
+            CHECK(
+                reads[num_bodies + 2 * num_frames * i + j]
+                == std::make_pair(j % num_frames, i));
+        }
+    }
+    CHECK(read_file(read_glb_filename) == read_file(glb_filename));
+    fs::remove(read_glb_filename);
+
+    // Header and chunks of the GLB file
+    const std::string glb = read_file(glb_filename);
+    REQUIRE(glb.size() >= 20);
+    CHECK(read_uint32(glb, 0) == 0x46546C67); // "glTF"
+    CHECK(read_uint32(glb, 4) == 2);
+    CHECK(read_uint32(glb, 8) == glb.size());
+    const uint32_t json_length = read_uint32(glb, 12);
+    CHECK(read_uint32(glb, 16) == 0x4E4F534A); // "JSON"
+    CHECK(json_length % 4 == 0);
+    REQUIRE(20 + json_length + 8 <= glb.size());
+    const nlohmann::json gltf =
+        nlohmann::json::parse(glb.substr(20, json_length));
+    const uint32_t bin_length = read_uint32(glb, 20 + json_length);
+    CHECK(read_uint32(glb, 24 + json_length) == 0x004E4942); // "BIN"
+    CHECK(bin_length % 4 == 0);
+    REQUIRE(28 + json_length + bin_length == glb.size());
+    const std::string bin = glb.substr(28 + json_length);
+    CHECK(gltf["buffers"][0]["byteLength"] == bin_length);
+    CHECK(!gltf["buffers"][0].contains("uri"));
+
+    // Animation of the bodies
+    const nlohmann::json& accessors = gltf["accessors"];
+    const nlohmann::json& views = gltf["bufferViews"];
+    const auto read_floats = [&](size_t accessor, size_t num_components) {
+        const nlohmann::json& view =
+            views[accessors[accessor]["bufferView"].get<size_t>()];
+        const size_t count = accessors[accessor]["count"];
+        REQUIRE(
+            view["byteLength"].get<size_t>()
+            == num_components * count * sizeof(float));
+        std::vector<float> values(num_components * count);
+        std::memcpy(
+            values.data(), bin.data() + view["byteOffset"].get<size_t>(),
+            view["byteLength"].get<size_t>());
+        return values;
+    };
+    const nlohmann::json& samplers = gltf["animations"][0]["samplers"];
+    REQUIRE(samplers.size() == 2 * num_bodies);
+    const std::vector<float> times =
+        read_floats(samplers[0]["input"].get<size_t>(), 1);
+    for (size_t j = 0; j < num_frames; j++) {
+        CHECK(times[j] == float(j * timestep));
+    }
+    for (size_t i = 0; i < num_bodies; i++) {
+        const std::vector<float> translations =
+            read_floats(samplers[2 * i]["output"].get<size_t>(), 3);
+        const std::vector<float> rotations =
+            read_floats(samplers[2 * i + 1]["output"].get<size_t>(), 4);
+        for (size_t j = 0; j < num_frames; j++) {
+            const PoseD& pose = frames[j][i];
+            const Eigen::Quaterniond q = pose.construct_quaternion();
+            for (int d = 0; d < 3; d++) {
+                CHECK(translations[3 * j + d] == float(pose.position[d]));
+            }
+            CHECK(rotations[4 * j + 0] == float(q.x()));
+            CHECK(rotations[4 * j + 1] == float(q.y()));
+            CHECK(rotations[4 * j + 2] == float(q.z()));
+            CHECK(rotations[4 * j + 3] == float(q.w()));
+        }
+        // The nodes start at the first frame
+        const nlohmann::json& node = gltf["nodes"][i];
+        CHECK(node["translation"][0] == translations[0]);
+        CHECK(node["rotation"][3] == rotations[3]);
+    }
+
+    // The same buffer embedded in base64
+    const std::string gltf_filename =
+        (tmp_dir / "rigid_ipc_test.gltf").string();
+    REQUIRE(write_gltf(
+        gltf_filename, bodies, animation, timestep,
+        /*embed_buffers=*/true, /*write_binary=*/false));
+    const nlohmann::json embedded_gltf =
+        nlohmann::json::parse(read_file(gltf_filename));
+    const std::string uri = embedded_gltf["buffers"][0]["uri"];
+    const std::string prefix = "data:application/octet-stream;base64,";
+    REQUIRE(uri.substr(0, prefix.size()) == prefix);
+    const std::string encoded = uri.substr(prefix.size());
+    CHECK(encoded.size() == 4 * ((bin.size() + 2) / 3));
+    const size_t num_padding =
+        encoded.size() - encoded.find_last_not_of('=') - 1;
+    CHECK(num_padding == (3 - bin.size() % 3) % 3);
+    CHECK(decode_base64(encoded) == bin);
+
+    // The same buffer in a separate file
+    REQUIRE(write_gltf(
+        gltf_filename, bodies, animation, timestep,
+        /*embed_buffers=*/false, /*write_binary=*/false));
+    const std::string bin_filename =
+        (tmp_dir / "rigid_ipc_test.bin").string();
+    CHECK(
+        nlohmann::json::parse(read_file(gltf_filename))["buffers"][0]["uri"]
+        == "rigid_ipc_test.bin");
+    CHECK(read_file(bin_filename) == bin);
+
+    fs::remove(glb_filename);
+    fs::remove(gltf_filename);
+    fs::remove(bin_filename);
+}
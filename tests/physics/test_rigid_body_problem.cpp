@@ -252,4 +252,40 @@ TEST_CASE("dof -> poses -> dof", "[RB][RB-Problem]")
     }
 }
 
+TEST_CASE("Free DoF of a rigid body problem", "[RB][RB-Problem]")
+{
+    Eigen::MatrixXd vertices(4, 2);
+    Eigen::MatrixXi edges(4, 2);
+    vertices << -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, 0.5;
+    edges << 0, 1, 1, 2, 2, 3, 3, 0;
+
+    std::vector<RigidBody> rbs = {
+        rb_from_displacements(vertices, edges, Pose<double>::Zero(2)),
+        rb_from_displacements(vertices, edges, Pose<double>::Zero(2))
+    };
+    // Only the rotation of the second body is free
+    rbs[1].is_dof_fixed << true, true, false;
+
+    SplitDistanceBarrierRBProblem rbp;
+    rbp.init(rbs);
+
+    // The free DoF are known as soon as the problem is initialized
+    Eigen::VectorXi expected_free_dof(4);
+    expected_free_dof << 0, 1, 2, 5;
+    REQUIRE(rbp.free_dof().size() == expected_free_dof.size());
+    CHECK(rbp.free_dof() == expected_free_dof);
+    const size_t version = rbp.free_dof_version();
+
+    // Unchanged free DoF keep their version
+    rbp.init_augmented_lagrangian();
+    CHECK(rbp.free_dof_version() == version);
+
+    // Fixing more DoF changes the free DoF
+    rbs[0].is_dof_fixed.setOnes();
+    rbp.init(rbs);
+    CHECK(rbp.free_dof_version() != version);
+    REQUIRE(rbp.free_dof().size() == 1);
+    CHECK(rbp.free_dof()[0] == 5);
+}
+
 // TODO: Add 3D RB test
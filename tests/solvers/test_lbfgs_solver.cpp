@@ -0,0 +1,302 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <constants.hpp>
+#include <problems/barrier_problem.hpp>
+#include <solvers/ipc_solver.hpp>
+#include <solvers/lbfgs_solver.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+/// @brief Convex problem f(x) = ½xᵀAx - bᵀx + w/4 ∑ xᵢ⁴ + κ ∑ b(xᵢ + 1)
+/// with A tridiagonal and the barrier keeping every xᵢ > -1.
+class ConvexBarrierProblem : public virtual BarrierProblem {
+public:
+    ConvexBarrierProblem(int num_vars, double quartic_weight, bool use_barriers)
+        : num_vars_(num_vars)
+        , quartic_weight(quartic_weight)
+    {
+        m_use_barriers = use_barriers;
+        is_dof_fixed_ = VectorXb::Zero(num_vars);
+        b.resize(num_vars);
+        for (int i = 0; i < num_vars; i++) {
+            // The unconstrained minimizer violates the bound at even DoF
+            b(i) = i % 2 == 0 ? -6 : 2;
+        }
+        std::vector<Eigen::Triplet<double>> triplets;
+        for (int i = 0; i < num_vars; i++) {
+            triplets.emplace_back(i, i, 4);
+            if (i + 1 < num_vars) {
+                triplets.emplace_back(i, i + 1, -1);
+                triplets.emplace_back(i + 1, i, -1);
+            }
+        }
+        A.resize(num_vars, num_vars);
+        A.setFromTriplets(triplets.begin(), triplets.end());
+    }
+
+    double compute_energy_term(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad_Ex,
+        Eigen::SparseMatrix<double>& hess_Ex,
+        bool compute_grad = true,
+        bool compute_hess = true) override
+    {
+        if (compute_grad) {
+            grad_Ex = A * x - b + quartic_weight * x.array().cube().matrix();
+        }
+        if (compute_hess) {
+            Eigen::VectorXd diag = 3 * quartic_weight * x.array().square();
+            hess_Ex = A;
+            hess_Ex.diagonal() += diag;
+        }
+        return 0.5 * x.dot(A * x) - b.dot(x)
+            + quartic_weight / 4 * x.array().pow(4).sum();
+    }
+
+    double compute_barrier_term(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad_Bx,
+        Eigen::SparseMatrix<double>& hess_Bx,
+        int& num_constraints,
+        bool compute_grad = true,
+        bool compute_hess = true) override
+    {
+        // b(d) = -(d - d̂)² log(d / d̂) for d = xᵢ + 1 < d̂
+        num_constraints = 0;
+        double Bx = 0;
+        Eigen::VectorXd hess_diag = Eigen::VectorXd::Zero(x.size());
+        grad_Bx.setZero(x.size());
+        for (int i = 0; i < x.size(); i++) {
+            double d = x(i) + 1;
+            if (d <= 0) {
+                return std::numeric_limits<double>::infinity();
+            }
+            if (d >= dhat) {
+                continue;
+            }
+            num_constraints++;
+            double log_d = std::log(d / dhat);
+            Bx += -(d - dhat) * (d - dhat) * log_d;
+            grad_Bx(i) = -2 * (d - dhat) * log_d - (d - dhat) * (d - dhat) / d;
+            hess_diag(i) = -2 * log_d - 4 * (d - dhat) / d
+                + (d - dhat) * (d - dhat) / (d * d);
+        }
+        if (compute_hess) {
+            hess_Bx = SparseDiagonal<double>(hess_diag);
+        }
+        return Bx;
+    }
+
+    double barrier_hessian(double d) const override
+    {
+        return -2 * std::log(d / dhat) - 4 * (d - dhat) / d
+            + (d - dhat) * (d - dhat) / (d * d);
+    }
+
+    double barrier_activation_distance() const override { return dhat; }
+    void barrier_activation_distance(const double eps) override {}
+
+    // The stiffness is fixed, so every solver minimizes the same objective.
+    double barrier_stiffness() const override { return 1; }
+    void barrier_stiffness(const double kappa) override {}
+
+    bool has_collisions(
+        const Eigen::VectorXd& xi, const Eigen::VectorXd& xj) override
+    {
+        return m_use_barriers && (xj.array() <= -1).any();
+    }
+    double compute_earliest_toi(
+        const Eigen::VectorXd& xi, const Eigen::VectorXd& xj) override
+    {
+        double toi = std::numeric_limits<double>::infinity();
+        for (int i = 0; m_use_barriers && i < xi.size(); i++) {
+            if (xj(i) < xi(i)) {
+                toi = std::min(toi, (xi(i) + 1) / (xi(i) - xj(i)));
+            }
+        }
+        return toi;
+    }
+    bool is_ccd_aligned_with_newton_update() override { return true; }
+
+    int num_vars() const override { return num_vars_; }
+    const VectorXb& is_dof_fixed() const override { return is_dof_fixed_; }
+
+    double compute_min_distance(const Eigen::VectorXd& x) const override
+    {
+        return m_use_barriers ? x.minCoeff() + 1 : -1;
+    }
+
+    Eigen::MatrixXd world_vertices(const Eigen::VectorXd& x) const override
+    {
+        return x;
+    }
+
+    double world_bbox_diagonal() const override { return 1; }
+
+    DiagonalMatrixXd mass_matrix() const override
+    {
+        DiagonalMatrixXd I(num_vars_);
+        I.setIdentity();
+        return I;
+    }
+    double average_mass() const override { return 1; }
+
+    double timestep() const override { return 1; }
+
+    int num_vars_;
+    double quartic_weight;
+    double dhat = 0.5;
+    Eigen::SparseMatrix<double> A;
+    Eigen::VectorXd b;
+    VectorXb is_dof_fixed_;
+};
+
+/// @brief Record the state of the L-BFGS history at every iteration.
+class LBFGSSolverTester : public LBFGSSolver {
+public:
+    std::vector<size_t> history_sizes;
+    std::vector<bool> is_quasi_newton_directions;
+
+protected:
+    bool compute_search_direction(
+        double& fx, double& regularization_coeff) override
+    {
+        bool success =
+            LBFGSSolver::compute_search_direction(fx, regularization_coeff);
+        history_sizes.push_back(s_history.size());
+        is_quasi_newton_directions.push_back(is_quasi_newton_direction);
+        return success;
+    }
+
+    bool converged() override
+    {
+        bool was_quasi_newton_direction = is_quasi_newton_direction;
+        bool is_converged = LBFGSSolver::converged();
+        if (was_quasi_newton_direction && !is_quasi_newton_direction) {
+            // Convergence was confirmed with the exact Newton direction
+            history_sizes.back() = s_history.size();
+            is_quasi_newton_directions.back() = false;
+        }
+        return is_converged;
+    }
+};
+
+nlohmann::json
+solver_settings(int history_size = 8, int hessian_refresh_interval = 10)
+{
+    return {
+        { "max_iterations", 1000 },
+        { "convergence_criteria", "energy" },
+        { "energy_conv_tol", 1e-14 },
+        { "velocity_conv_tol", 1e-8 },
+        { "is_velocity_conv_tol_abs", false },
+        { "line_search_lower_bound",
+          Constants::DEFAULT_LINE_SEARCH_LOWER_BOUND },
+        { "speculative_line_search_steps", 1 },
+        { "linear_solver_method", "direct" },
+        { "linear_solver_ordering", "default" },
+        { "separate_decoupled_blocks", true },
+        { "cg_max_iterations", 1000 },
+        { "linear_solver", { { "name", "Eigen::SimplicialLDLT" } } },
+        { "dhat_epsilon", 1e-9 },
+        { "min_barrier_stiffness_scale",
+          Constants::DEFAULT_MIN_BARRIER_STIFFNESS_SCALE },
+        { "history_size", history_size },
+        { "hessian_refresh_interval", hessian_refresh_interval },
+    };
+}
+
+} // namespace
+
+TEST_CASE("L-BFGS converges to the Newton minimizer", "[opt][lbfgs_solver]")
+{
+    int num_vars = GENERATE(1, 10, 100);
+    double quartic_weight = GENERATE(0.0, 1.0);
+    bool use_barriers = GENERATE(false, true);
+    ConvexBarrierProblem problem(num_vars, quartic_weight, use_barriers);
+    Eigen::VectorXd x0 = Eigen::VectorXd::Zero(num_vars);
+
+    IPCSolver newton_solver;
+    newton_solver.settings(solver_settings());
+    newton_solver.set_problem(problem);
+    OptimizationResults newton_results = newton_solver.solve(x0);
+    REQUIRE(newton_results.success);
+
+    LBFGSSolver lbfgs_solver;
+    lbfgs_solver.settings(solver_settings());
+    lbfgs_solver.set_problem(problem);
+    OptimizationResults results = lbfgs_solver.solve(x0);
+    REQUIRE(results.success);
+
+    CHECK(
+        (results.x - newton_results.x).lpNorm<Eigen::Infinity>()
+        == Approx(0).margin(1e-6));
+    CHECK(results.minf == Approx(newton_results.minf));
+    if (use_barriers) {
+        CHECK(results.x.minCoeff() > -1);
+        // The bound is active at the minimizer
+        CHECK(results.x.minCoeff() < -1 + problem.dhat);
+    }
+}
+
+TEST_CASE(
+    "L-BFGS history is truncated at history_size", "[opt][lbfgs_solver]")
+{
+    int history_size = GENERATE(0, 1, 3);
+    ConvexBarrierProblem problem(20, /*quartic_weight=*/1, true);
+    Eigen::VectorXd x0 = Eigen::VectorXd::Constant(20, 4);
+
+    LBFGSSolverTester solver;
+    solver.settings(solver_settings(history_size, /*refresh_interval=*/100));
+    solver.set_problem(problem);
+    OptimizationResults results = solver.solve(x0);
+    REQUIRE(results.success);
+
+    REQUIRE(!solver.history_sizes.empty());
+    size_t max_history_size = *std::max_element(
+        solver.history_sizes.begin(), solver.history_sizes.end());
+    CHECK(max_history_size == size_t(history_size));
+}
+
+TEST_CASE(
+    "L-BFGS refreshes the exact Hessian every hessian_refresh_interval "
+    "iterations",
+    "[opt][lbfgs_solver]")
+{
+    int refresh_interval = GENERATE(1, 2, 3);
+    ConvexBarrierProblem problem(20, /*quartic_weight=*/1, true);
+    Eigen::VectorXd x0 = Eigen::VectorXd::Constant(20, 4);
+
+    LBFGSSolverTester solver;
+    solver.settings(solver_settings(/*history_size=*/8, refresh_interval));
+    solver.set_problem(problem);
+    OptimizationResults results = solver.solve(x0);
+    REQUIRE(results.success);
+
+    // Count the quasi-Newton directions between exact Hessians
+    const std::vector<bool>& is_quasi_newton =
+        solver.is_quasi_newton_directions;
+    REQUIRE(!is_quasi_newton.empty());
+    CHECK(!is_quasi_newton.front()); // The first direction uses the Hessian
+    CHECK(!is_quasi_newton.back());  // Convergence uses the Hessian
+    int num_quasi_newton = 0, max_num_quasi_newton = 0;
+    size_t num_refreshes = 0;
+    for (bool is_qn : is_quasi_newton) {
+        num_quasi_newton = is_qn ? num_quasi_newton + 1 : 0;
+        max_num_quasi_newton = std::max(max_num_quasi_newton, num_quasi_newton);
+        num_refreshes += !is_qn;
+    }
+    CHECK(max_num_quasi_newton == refresh_interval);
+    CHECK(
+        solver.stats()["num_hessian_refreshes"].get<size_t>()
+        == num_refreshes);
+    CHECK(
+        solver.stats()["num_quasi_newton_steps"].get<size_t>()
+        == is_quasi_newton.size() - num_refreshes);
+}
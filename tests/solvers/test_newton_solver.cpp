@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 
 #include <Eigen/Eigenvalues>
+#include <constants.hpp>
 #include <solvers/newton_solver.hpp>
 #include <utils/eigen_ext.hpp>
 #include <utils/not_implemented_error.hpp>
@@ -115,6 +116,199 @@ TEST_CASE("Test Newton direction solve", "[opt][newtons_method][newton_dir]")
     CHECK((x + delta_x).squaredNorm() == Approx(0.0));
 }
 
+TEST_CASE("Test block-Jacobi preconditioned CG", "[opt][newtons_method][cg]")
+{
+    int block_size = GENERATE(1, 3, 6);
+    int num_blocks = 20, n = block_size * num_blocks;
+
+    // Random SPD matrix with dense diagonal blocks and sparse coupling
+    Eigen::MatrixXd R = Eigen::MatrixXd::Random(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (i / block_size != j / block_size && (7 * i + 3 * j) % 11) {
+                R(i, j) = 0;
+            }
+        }
+    }
+    Eigen::MatrixXd dense_A =
+        R * R.transpose() + Eigen::MatrixXd::Identity(n, n);
+    Eigen::SparseMatrix<double> A = dense_A.sparseView();
+    Eigen::VectorXd b = Eigen::VectorXd::Random(n);
+
+    std::vector<int> block_starts;
+    for (int i = 0; i < num_blocks; i++) {
+        block_starts.push_back(i * block_size);
+    }
+    BlockJacobiPreconditioner preconditioner;
+    preconditioner.compute(A, block_starts);
+
+    Eigen::VectorXd x;
+    int num_iterations;
+    REQUIRE(preconditioned_conjugate_gradient(
+        A, b, preconditioner, /*tolerance=*/1e-10, /*max_iterations=*/1000, x,
+        num_iterations));
+    CHECK((dense_A * x - b).norm() <= 1e-8 * b.norm());
+
+    // Negative definite matrices have no descent direction
+    Eigen::SparseMatrix<double> negative_A = -A;
+    x.setZero();
+    CHECK(!preconditioned_conjugate_gradient(
+        negative_A, b, preconditioner, 1e-10, 1000, x, num_iterations));
+}
+
+TEST_CASE(
+    "Solve decoupled blocks separately", "[opt][newtons_method][blocks]")
+{
+    // Bodies with three DoF each, where only the first two are coupled
+    class BlockProblem : public virtual OptimizationProblem {
+    public:
+        BlockProblem(int num_blocks)
+            : num_blocks(num_blocks)
+        {
+            x0 = Eigen::VectorXd::Random(3 * num_blocks);
+            centers = Eigen::VectorXd::Random(3 * num_blocks);
+            for (int i = 0; i < num_blocks; i++) {
+                Eigen::Matrix3d M = Eigen::Matrix3d::Random();
+                A.push_back(M * M.transpose() + Eigen::Matrix3d::Identity());
+            }
+            is_dof_fixed_ = VectorXb::Zero(3 * num_blocks);
+            is_dof_fixed_[3 * num_blocks - 1] = true;
+        }
+
+        // f = Σ ½ (xᵢ - cᵢ)ᵀ Aᵢ (xᵢ - cᵢ) + ¼ xᵢ⁴ + ½ ‖x₀ - x₁‖²
+        double compute_objective(
+            const Eigen::VectorXd& x,
+            Eigen::VectorXd& grad_fx,
+            Eigen::SparseMatrix<double>& hess_fx,
+            bool compute_grad = true,
+            bool compute_hess = true) override
+        {
+            double fx = 0;
+            grad_fx.setZero(x.size());
+            std::vector<Eigen::Triplet<double>> triplets;
+            for (int i = 0; i < num_blocks; i++) {
+                const Eigen::Vector3d xi = x.segment<3>(3 * i);
+                const Eigen::Vector3d dx = xi - centers.segment<3>(3 * i);
+                fx += dx.dot(A[i] * dx) / 2 + xi.array().pow(4).sum() / 4;
+                grad_fx.segment<3>(3 * i) =
+                    A[i] * dx + xi.array().pow(3).matrix();
+                for (int j = 0; j < 3; j++) {
+                    for (int k = 0; k < 3; k++) {
+                        triplets.emplace_back(
+                            3 * i + j, 3 * i + k,
+                            A[i](j, k) + (j == k ? 3 * xi[j] * xi[j] : 0));
+                    }
+                }
+            }
+            const Eigen::Vector3d d = x.segment<3>(0) - x.segment<3>(3);
+            fx += d.squaredNorm() / 2;
+            grad_fx.segment<3>(0) += d;
+            grad_fx.segment<3>(3) -= d;
+            for (int j = 0; j < 3; j++) {
+                triplets.emplace_back(j, j, 1);
+                triplets.emplace_back(3 + j, 3 + j, 1);
+                triplets.emplace_back(j, 3 + j, -1);
+                triplets.emplace_back(3 + j, j, -1);
+            }
+            if (compute_hess) {
+                hess_fx.resize(x.size(), x.size());
+                hess_fx.setFromTriplets(triplets.begin(), triplets.end());
+            }
+            return fx;
+        }
+
+        bool
+        has_collisions(const Eigen::VectorXd&, const Eigen::VectorXd&) override
+        {
+            return false;
+        }
+        double compute_earliest_toi(
+            const Eigen::VectorXd& xi, const Eigen::VectorXd& xj) override
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        bool is_ccd_aligned_with_newton_update() override { return true; }
+
+        int num_vars() const override { return 3 * num_blocks; }
+        const VectorXb& is_dof_fixed() const override { return is_dof_fixed_; }
+        int dof_block_size() const override { return 3; }
+
+        double compute_min_distance(const Eigen::VectorXd& x) const override
+        {
+            return -1;
+        }
+        Eigen::MatrixXd world_vertices(const Eigen::VectorXd& x) const override
+        {
+            throw NotImplementedError("no vertices");
+        }
+        double world_bbox_diagonal() const override
+        {
+            throw NotImplementedError("no world bbox diagonal");
+        }
+        DiagonalMatrixXd mass_matrix() const override
+        {
+            DiagonalMatrixXd I(num_vars());
+            I.setIdentity();
+            return I;
+        }
+        double average_mass() const override { return 1; }
+        double timestep() const override { return 1; }
+
+        int num_blocks;
+        std::vector<Eigen::Matrix3d> A;
+        Eigen::VectorXd centers;
+        VectorXb is_dof_fixed_;
+        Eigen::VectorXd x0;
+    };
+
+    class BlockNewtonSolver : public NewtonSolver {
+    public:
+        using NewtonSolver::decoupled_blocks;
+    };
+
+    const int num_blocks = 5;
+    BlockProblem problem(num_blocks);
+
+    const auto solve = [&](bool separate_decoupled_blocks,
+                           BlockNewtonSolver& solver) {
+        solver.settings({
+            { "max_iterations", 1000 },
+            { "convergence_criteria", "energy" },
+            { "energy_conv_tol", 1e-14 },
+            { "velocity_conv_tol", 1e-8 },
+            { "is_velocity_conv_tol_abs", false },
+            { "line_search_lower_bound",
+              Constants::DEFAULT_LINE_SEARCH_LOWER_BOUND },
+            { "speculative_line_search_steps", 1 },
+            { "linear_solver_method", "direct" },
+            { "linear_solver_ordering", "default" },
+            { "separate_decoupled_blocks", separate_decoupled_blocks },
+            { "cg_max_iterations", 1000 },
+            { "linear_solver", { { "name", "Eigen::SimplicialLDLT" } } },
+        });
+        solver.set_problem(problem);
+        solver.init_solve(problem.x0);
+        return solver.solve(problem.x0);
+    };
+
+    BlockNewtonSolver global_solver, block_solver;
+    OptimizationResults global_results = solve(false, global_solver);
+    OptimizationResults block_results = solve(true, block_solver);
+    REQUIRE(global_results.success);
+    REQUIRE(block_results.success);
+
+    // Every body but the two coupled ones is solved on its own
+    CHECK(global_solver.decoupled_blocks.empty());
+    CHECK(block_solver.decoupled_blocks.size() == num_blocks - 2);
+
+    CHECK(
+        (block_results.x - global_results.x).lpNorm<Eigen::Infinity>()
+        == Approx(0).margin(1e-10));
+    CHECK(block_results.minf == Approx(global_results.minf));
+    const int fixed_dof = 3 * num_blocks - 1;
+    CHECK(block_results.x[fixed_dof] == problem.x0[fixed_dof]);
+}
+
 TEST_CASE("Test making a matrix SPD", "[opt][make_spd]")
 {
     Eigen::SparseMatrix<double> A =
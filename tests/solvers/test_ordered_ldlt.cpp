@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+
+#include <solvers/ordered_ldlt.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Nested dissection ordering", "[opt][linear_solver]")
+{
+    // A chain of bodies all touching a hub (e.g., objects resting on ground)
+    int num_nodes = GENERATE(1, 10, 100);
+    int hub = num_nodes / 2;
+    std::vector<std::pair<int, int>> edges;
+    for (int i = 0; i + 1 < num_nodes; i++) {
+        edges.emplace_back(i, i + 1);
+    }
+    for (int i = 0; i < num_nodes; i++) {
+        edges.emplace_back(i, hub);
+    }
+
+    std::vector<int> order =
+        nested_dissection_ordering(num_nodes, edges, /*leaf_size=*/2);
+
+    std::vector<int> sorted_order = order;
+    std::sort(sorted_order.begin(), sorted_order.end());
+    for (int i = 0; i < num_nodes; i++) {
+        CHECK(sorted_order[i] == i);
+    }
+    if (num_nodes > 2) {
+        // The hub separates every other pair of nodes
+        CHECK(std::find(order.begin(), order.end(), hub) >= order.end() - 3);
+    }
+}
+
+TEST_CASE("Ordered LDLT solve", "[opt][linear_solver]")
+{
+    int num_blocks = GENERATE(1, 10, 50);
+    int block_size = 3;
+    int n = num_blocks * block_size;
+
+    // Block tridiagonal SPD matrix
+    std::vector<Eigen::Triplet<double>> triplets;
+    std::vector<std::pair<int, int>> edges;
+    for (int bi = 0; bi < num_blocks; bi++) {
+        for (int i = 0; i < block_size; i++) {
+            int r = bi * block_size + i;
+            triplets.emplace_back(r, r, 4.0 * block_size);
+            if (bi + 1 < num_blocks) {
+                int c = (bi + 1) * block_size + i;
+                triplets.emplace_back(r, c, -1.0);
+                triplets.emplace_back(c, r, -1.0);
+            }
+        }
+        if (bi + 1 < num_blocks) {
+            edges.emplace_back(bi, bi + 1);
+        }
+    }
+    Eigen::SparseMatrix<double> A(n, n);
+    A.setFromTriplets(triplets.begin(), triplets.end());
+
+    std::vector<int> block_order =
+        nested_dissection_ordering(num_blocks, edges, /*leaf_size=*/1);
+    std::vector<int> order;
+    for (int bi : block_order) {
+        for (int i = 0; i < block_size; i++) {
+            order.push_back(bi * block_size + i);
+        }
+    }
+
+    OrderedLDLTSolver solver;
+    solver.set_ordering(order);
+    Eigen::VectorXd b = Eigen::VectorXd::Random(n);
+    Eigen::VectorXd x;
+    // The second factorization reuses the symbolic analysis
+    for (int i = 0; i < 2; i++) {
+        REQUIRE(solver.factorize(A));
+        solver.solve(b, x);
+        CHECK((A * x - b).norm() <= 1e-10 * b.norm());
+    }
+}